@@ -10,14 +10,89 @@
 *       functions. It reads in command line arguments, handling user input 
 *       and calls the appropriate function to compress or decompress the image. 
 *
+*       Passing --stats, or setting COMP40_STATS in the environment, prints
+*       per-stage timings and counters when the program exits. If
+*       COMP40_STATS names a file (anything other than "1"), the summary is
+*       written there as JSON instead of to stderr.
+*
+*       --eval runs a round trip instead: each named image (or stdin) is
+*       compressed and decoded in memory, and its size, quality, and
+*       codec throughput are printed as one row of a table.
+*
+*       --batch DIR compresses (or with -d decompresses) every named
+*       file into DIR, overlapping file I/O with the codec; see batch40.c.
+*
+*       --fixed codes blocks with the integer-only codec in fixed40.c
+*       instead of the float stages; the file format is unchanged.
+*
+*       --no-cache turns off the encoder and decoder block caches in
+*       codec40.c (the output is the same; only speed changes).
+*
+*       --rle writes format 3, where runs of identical codewords become
+*       repeat tokens; -d reads format 2 and format 3 alike.
+*
+*       --rotate 90|180|270 and --flip h|v reorient a compressed image
+*       read from the input without decoding it (see orient40.c); they
+*       can be combined and given more than once, and apply in order.
+*
+*       --halve writes a compressed image at half the width and height
+*       of the compressed image read, built from its codewords without
+*       decoding (see scale40.c).
+*
+*       --pixel x,y prints one decoded pixel, and --rows a-b writes
+*       pixel rows a to b as a P6, of a format 2 file, decoding only the
+*       blocks involved (see view40.c). Both can be given several times.
+*
+*       --update FILE [--at x,y] reads a PPM patch and writes it into the
+*       format 2 FILE with its top-left corner at (x, y), re-encoding
+*       only the blocks it overlaps and overwriting those codewords in
+*       place.
+*
+*       --sequence [--threshold N] frame... compresses the named frames
+*       into one format 5 sequence, storing only the blocks that change
+*       from frame to frame (see seq40.c); -d writes the frames back out
+*       as consecutive PPMs.
+*
+*       --serve SOCKET keeps running and answers compress and decompress
+*       requests sent over a Unix socket at SOCKET (see serve40.c and
+*       wire40.h); load40 is a client that measures its throughput.
+*       --max-request MiB caps the size of one request (64 MiB unless
+*       given); a longer one is refused and its connection closed.
+*
+*       P2/P5 graymaps are detected automatically and compressed
+*       luma-only to format 4 (see gray40.c), which -d turns back into
+*       a P5 graymap.
+*
 **************************************************************/
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include "assert.h"
 #include "compress40.h"
+#include "stats40.h"
+#include "eval40.h"
+#include "batch40.h"
+#include "serve40.h"
+#include "codec40.h"
+#include "orient40.h"
+#include "scale40.h"
+#include "view40.h"
+#include "seq40.h"
+#include "pnm.h"
+#include "pnm40.h"
+#include "a2plain.h"
 
 static void (*compress_or_decompress)(FILE *input) = compress40;
+static Orient40 orientation;
+
+static int evaluate_files(int num_files, char *paths[]);
+static void reorient(FILE *input);
+static void halve(FILE *input);
+static int query_file(const char *path, int argc, char *argv[]);
+static int update_file(const char *target, const char *at, FILE *input);
+static int sequence_files(int num_files, char *paths[], unsigned threshold);
+static const char *mode_label(void);
 
 /********** main **********
 * Main function that reads in command line arguments and calls the 
@@ -41,26 +116,166 @@ static void (*compress_or_decompress)(FILE *input) = compress40;
 int main(int argc, char *argv[])
 {
         int i;
+        bool show_stats = false;
+        bool evaluate = false;
+        const char *batch_dir = NULL;
+        const char *serve_path = NULL;
+        unsigned long max_request_mb = SERVE40_DEFAULT_REQUEST_MB;
+        bool querying = false;
+        const char *update_target = NULL;
+        const char *update_at = "0,0";
+        bool sequence = false;
+        unsigned threshold = 0;
 
         for (i = 1; i < argc; i++) {
                 if (strcmp(argv[i], "-c") == 0) {
                         compress_or_decompress = compress40;
                 } else if (strcmp(argv[i], "-d") == 0) {
                         compress_or_decompress = decompress40;
+                } else if (strcmp(argv[i], "--stats") == 0) {
+                        show_stats = true;
+                } else if (strcmp(argv[i], "--eval") == 0) {
+                        evaluate = true;
+                } else if (strcmp(argv[i], "--fixed") == 0) {
+                        Codec40_use_fixed_point(true);
+                } else if (strcmp(argv[i], "--no-cache") == 0) {
+                        Codec40_use_cache(false);
+                } else if (strcmp(argv[i], "--rle") == 0) {
+                        Codec40_use_run_length(true);
+                } else if (strcmp(argv[i], "--rotate") == 0 && i + 1 < argc) {
+                        char *end;
+                        unsigned long degrees = strtoul(argv[++i], &end, 10);
+                        if (*end != '\0'
+                            || !Orient40_rotate(&orientation, degrees)) {
+                                fprintf(stderr, "%s: --rotate takes 90, 180, "
+                                        "or 270\n", argv[0]);
+                                exit(1);
+                        }
+                        compress_or_decompress = reorient;
+                } else if (strcmp(argv[i], "--flip") == 0 && i + 1 < argc) {
+                        const char *axis = argv[++i];
+                        if (strlen(axis) != 1
+                            || !Orient40_flip(&orientation, *axis)) {
+                                fprintf(stderr, "%s: --flip takes h or v\n",
+                                        argv[0]);
+                                exit(1);
+                        }
+                        compress_or_decompress = reorient;
+                } else if (strcmp(argv[i], "--halve") == 0) {
+                        compress_or_decompress = halve;
+                } else if ((strcmp(argv[i], "--pixel") == 0
+                            || strcmp(argv[i], "--rows") == 0) && i + 1 < argc) {
+                        querying = true;        /* run in order below */
+                        i++;
+                } else if (strcmp(argv[i], "--update") == 0 && i + 1 < argc) {
+                        update_target = argv[++i];
+                } else if (strcmp(argv[i], "--at") == 0 && i + 1 < argc) {
+                        update_at = argv[++i];
+                } else if (strcmp(argv[i], "--sequence") == 0) {
+                        sequence = true;
+                } else if (strcmp(argv[i], "--threshold") == 0
+                           && i + 1 < argc) {
+                        char *end;
+                        threshold = strtoul(argv[++i], &end, 10);
+                        if (*end != '\0') {
+                                fprintf(stderr, "%s: --threshold takes a "
+                                        "number\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+                        batch_dir = argv[++i];
+                } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+                        serve_path = argv[++i];
+                } else if (strcmp(argv[i], "--max-request") == 0
+                           && i + 1 < argc) {
+                        char *end;
+                        max_request_mb = strtoul(argv[++i], &end, 10);
+                        if (*end != '\0' || max_request_mb < 1
+                            || max_request_mb > SERVE40_MAX_REQUEST_MB) {
+                                fprintf(stderr, "%s: --max-request takes a "
+                                        "number of MiB from 1 to %d\n",
+                                        argv[0], SERVE40_MAX_REQUEST_MB);
+                                exit(1);
+                        }
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n",
                                 argv[0], argv[i]);
                         exit(1);
-                } else if (argc - i > 2) {
-                        fprintf(stderr, "Usage: %s -d [filename]\n"
-                                "       %s -c [filename]\n",
-                                argv[0], argv[0]);
+                } else if (argc - i > 2 && !evaluate && batch_dir == NULL
+                           && !sequence) {
+                        fprintf(stderr, "Usage: %s [--stats] [--fixed] -d "
+                                "[filename]\n"
+                                "       %s [--stats] [--fixed] [--rle] -c "
+                                "[filename]\n"
+                                "       %s [--fixed] [--rle] --eval "
+                                "[filename...]\n"
+                                "       %s [-c|-d] --batch dir filename...\n"
+                                "       %s [--rotate 90|180|270] [--flip h|v] "
+                                "[filename]\n"
+                                "       %s --halve [filename]\n"
+                                "       %s [--pixel x,y] [--rows a-b] "
+                                "[filename]\n"
+                                "       %s --update file [--at x,y] "
+                                "[patch]\n"
+                                "       %s --sequence [--threshold n] "
+                                "frame...\n"
+                                "       %s --serve socket [--max-request MiB]\n",
+                                argv[0], argv[0], argv[0], argv[0], argv[0],
+                                argv[0], argv[0], argv[0], argv[0], argv[0]);
                         exit(1);
                 } else {
                         break;
                 }
         }
+        /* turn on instrumentation if asked for on the command line or env */
+        const char *stats_env = getenv("COMP40_STATS");
+        if (show_stats || stats_env != NULL) {
+                const char *json_path = NULL;
+                if (stats_env != NULL && *stats_env != '\0'
+                    && strcmp(stats_env, "1") != 0) {
+                        json_path = stats_env;
+                }
+                /* named for the mode dispatched to below */
+                const char *label = evaluate ? "eval"
+                                    : querying ? "query"
+                                    : serve_path != NULL ? "serve"
+                                    : sequence ? "sequence"
+                                    : update_target != NULL ? "update"
+                                    : mode_label();
+                Stats40_enable(label, json_path);
+        }
+
+        if (evaluate) {
+                return evaluate_files(argc - i, argv + i);
+        }
+        if (querying) {
+                assert(argc - i <= 1);
+                return query_file(i < argc ? argv[i] : "/dev/stdin", i, argv);
+        }
+        if (serve_path != NULL) {
+                return Serve40_run(serve_path,
+                                   (size_t) max_request_mb << 20);
+        }
+        if (sequence) {
+                return sequence_files(argc - i, argv + i, threshold);
+        }
+        if (update_target != NULL) {
+                assert(argc - i <= 1);
+                FILE *fp = i < argc ? fopen(argv[i], "rb") : stdin;
+                assert(fp != NULL);
+                int status = update_file(update_target, update_at, fp);
+                if (fp != stdin) {
+                        fclose(fp);
+                }
+                return status;
+        }
+
+        if (batch_dir != NULL) {
+                return Batch40_run(compress_or_decompress == decompress40,
+                                   batch_dir, argc - i, argv + i);
+        }
         assert(argc - i <= 1);    /* at most one file on command line */
+
         if (i < argc) {
                 FILE *fp = fopen(argv[i], "r");
                 assert(fp != NULL);
@@ -72,3 +287,255 @@ int main(int argc, char *argv[])
 
         return EXIT_SUCCESS; 
 }
+
+
+/********** mode_label **********
+* Names the mode compress_or_decompress selects, for the stats summary
+*
+* Return:
+*      const char * - "compress", "decompress", "reorient", or "halve"
+*
+************************/
+static const char *mode_label(void)
+{
+        if (compress_or_decompress == decompress40) {
+                return "decompress";
+        }
+        if (compress_or_decompress == reorient) {
+                return "reorient";
+        }
+        if (compress_or_decompress == halve) {
+                return "halve";
+        }
+        return "compress";
+}
+
+
+/********** evaluate_files **********
+* Runs the round-trip evaluation on each named image, or on stdin if no
+* images are named, printing one table row per image
+*
+* Parameters:
+*      int num_files - number of paths
+*      char *paths[] - image paths
+*
+* Return:
+*      int - EXIT_SUCCESS, or EXIT_FAILURE if any file could not be opened
+*            or was a graymap, which is skipped
+*
+************************/
+static int evaluate_files(int num_files, char *paths[])
+{
+        int status = EXIT_SUCCESS;
+
+        Eval40_header(stdout);
+        if (num_files == 0 && !Eval40_image(stdin, "-", stdout)) {
+                fprintf(stderr, "-: --eval scores PPM images, not "
+                        "graymaps\n");
+                status = EXIT_FAILURE;
+        }
+        for (int i = 0; i < num_files; i++) {
+                FILE *fp = fopen(paths[i], "rb");
+                if (fp == NULL) {
+                        perror(paths[i]);
+                        status = EXIT_FAILURE;
+                        continue;
+                }
+                if (!Eval40_image(fp, paths[i], stdout)) {
+                        fprintf(stderr, "%s: --eval scores PPM images, not "
+                                "graymaps\n", paths[i]);
+                        status = EXIT_FAILURE;
+                }
+                fclose(fp);
+        }
+        return status;
+}
+
+
+/********** reorient **********
+* Rotates and/or flips the compressed image in input as the command line
+* asked, writing the result to stdout
+*
+* Parameters:
+*      FILE *input - stream holding a format 2 or 3 compressed image
+*
+************************/
+static void reorient(FILE *input)
+{
+        Orient40_stream(input, stdout, orientation);
+}
+
+
+/********** halve **********
+* Writes the compressed image in input at half size to stdout
+*
+* Parameters:
+*      FILE *input - stream holding a format 2 or 3 compressed image
+*
+************************/
+static void halve(FILE *input)
+{
+        Scale40_stream(input, stdout);
+}
+
+
+/********** query_file **********
+* Answers the --pixel and --rows queries among the options, in order, from
+* a format 2 file without decoding the rest of it
+*
+* Parameters:
+*      const char *path - the compressed file
+*      int argc         - number of option arguments
+*      char *argv[]     - the options
+*
+* Return:
+*      int - EXIT_SUCCESS, or EXIT_FAILURE if the file could not be opened
+*            or a query was malformed or out of range
+*
+* Notes:
+*      --pixel prints "x,y r g b" on a scale of 255; --rows writes a P6
+************************/
+static int query_file(const char *path, int argc, char *argv[])
+{
+        View40_T view = View40_open(path);
+        if (view == NULL) {
+                perror(path);
+                return EXIT_FAILURE;
+        }
+        unsigned width = View40_width(view);
+        unsigned height = View40_height(view);
+        int status = EXIT_SUCCESS;
+
+        for (int i = 1; i < argc - 1; i++) {
+                unsigned first, second;
+                char extra;
+                if (strcmp(argv[i], "--pixel") == 0) {
+                        i++;
+                        if (sscanf(argv[i], "%u,%u%c", &first, &second,
+                                   &extra) != 2
+                            || first >= width || second >= height) {
+                                fprintf(stderr, "%s: no pixel '%s' in a "
+                                        "%ux%u image\n", argv[0], argv[i],
+                                        width, height);
+                                status = EXIT_FAILURE;
+                                continue;
+                        }
+                        struct Pnm_rgb pixel;
+                        View40_pixel(view, first, second, &pixel);
+                        printf("%u,%u %u %u %u\n", first, second,
+                               pixel.red, pixel.green, pixel.blue);
+                } else if (strcmp(argv[i], "--rows") == 0) {
+                        i++;
+                        if (sscanf(argv[i], "%u-%u%c", &first, &second,
+                                   &extra) != 2
+                            || first > second || second >= height) {
+                                fprintf(stderr, "%s: no rows '%s' in a "
+                                        "%ux%u image\n", argv[0], argv[i],
+                                        width, height);
+                                status = EXIT_FAILURE;
+                                continue;
+                        }
+                        View40_rows(view, first, second, stdout);
+                } else if (strcmp(argv[i], "--rotate") == 0
+                           || strcmp(argv[i], "--flip") == 0
+                           || strcmp(argv[i], "--batch") == 0) {
+                        i++;    /* skip the option's argument */
+                }
+        }
+
+        View40_close(&view);
+        return status;
+}
+
+
+/********** update_file **********
+* Writes the PPM patch in input into the format 2 file target, with its
+* top-left corner at the pixel named by at ("x,y")
+*
+* Parameters:
+*      const char *target - the compressed file to update in place
+*      const char *at     - where the patch goes
+*      FILE *input        - stream holding the patch
+*
+* Return:
+*      int - EXIT_SUCCESS, or EXIT_FAILURE if at is malformed, target
+*            could not be opened or updated, or the patch does not fit
+*            inside the image
+*
+* Notes:
+*      CRE if the patch is not a PPM
+************************/
+static int update_file(const char *target, const char *at, FILE *input)
+{
+        unsigned x, y;
+        char extra;
+        if (sscanf(at, "%u,%u%c", &x, &y, &extra) != 2) {
+                fprintf(stderr, "--at takes x,y, not '%s'\n", at);
+                return EXIT_FAILURE;
+        }
+
+        View40_T view = View40_open(target);
+        if (view == NULL) {
+                perror(target);
+                return EXIT_FAILURE;
+        }
+        unsigned width = View40_width(view);
+        unsigned height = View40_height(view);
+        View40_close(&view);
+
+        Pnm_ppm patch = Pnm40_read_ppm(input, uarray2_methods_plain);
+        if (x > width || patch->width > width - x
+            || y > height || patch->height > height - y) {
+                fprintf(stderr, "%s: a %ux%u patch at %u,%u does not fit "
+                        "in a %ux%u image\n", target, patch->width,
+                        patch->height, x, y, width, height);
+                Pnm_ppmfree(&patch);
+                return EXIT_FAILURE;
+        }
+        bool ok = View40_update(target, x, y, patch);
+        Pnm_ppmfree(&patch);
+        if (!ok) {
+                perror(target);
+                return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+}
+
+
+/********** sequence_files **********
+* Compresses the named frames, in order, into one sequence on stdout
+*
+* Parameters:
+*      int num_files      - number of frames
+*      char *paths[]      - frame paths
+*      unsigned threshold - largest quantized change that is not stored
+*
+* Return:
+*      int - EXIT_SUCCESS, or EXIT_FAILURE if a frame could not be opened
+*            (the frames before it are still written)
+*
+* Notes:
+*      CRE if a frame is not a PPM or is not the size of the first
+************************/
+static int sequence_files(int num_files, char *paths[], unsigned threshold)
+{
+        Seq40_T seq = Seq40_new(stdout, threshold);
+        int status = EXIT_SUCCESS;
+
+        for (int i = 0; i < num_files; i++) {
+                FILE *fp = fopen(paths[i], "rb");
+                if (fp == NULL) {
+                        perror(paths[i]);
+                        status = EXIT_FAILURE;
+                        break;
+                }
+                Pnm_ppm frame = Pnm40_read_ppm(fp, uarray2_methods_plain);
+                fclose(fp);
+                Codec40_trim(frame);
+                Seq40_add(seq, frame);
+                Pnm_ppmfree(&frame);
+        }
+
+        Seq40_free(&seq);
+        return status;
+}
@@ -0,0 +1,651 @@
+/**************************************************************
+*
+*                     a2parallel.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       a2parallel.c implements the parallel maps of a2parallel.h. A
+*       map becomes a job of numbered tasks, run by the calling thread
+*       (worker 0) and the pool's threads (workers 1 and up). The pool
+*       sleeps on a condition variable between jobs, so a map costs one
+*       wakeup, not a thread creation.
+*
+*       Work is spread by stealing. Each worker has a deque of tasks,
+*       kept as a range [lo, hi) packed into one 64-bit word, and starts
+*       with a contiguous share of the tasks, so neighbouring tiles stay
+*       on one core. The owner takes tasks from the bottom (lo), and a
+*       worker that runs dry takes the top half of another's range. Both
+*       are a compare-and-swap on the range word, so an owner and a thief
+*       can never take the same task. A thief's new range can only hold
+*       tasks no one has taken, so a stale range is never seen again.
+*
+**************************************************************/
+#include "a2parallel.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "assert.h"
+#include "a2plain.h"
+#include "stats40.h"
+
+/* side of the tiles map_block_major uses on arrays with blocksize 1, and
+ * the number of elements in a row-major task */
+#define TILE 64
+#define TILE_AREA (TILE * TILE)
+
+#define RANGE_BITS 32
+#define RANGE_MASK 0xffffffffu
+
+/********** Deque **********
+ *
+ * struct to hold one worker's tasks, lo in the low half of range and hi
+ * in the high half, alone on its cache line so that owners do not
+ * contend with each other
+ *
+ ************************/
+typedef struct Deque {
+        uint64_t range;
+} __attribute__((aligned(64))) Deque;
+
+/********** Map_Job **********
+ *
+ * struct to hold one parallel map, or one A2Parallel_run
+ *
+ * Contains:
+ *      A2Methods_T methods, A2Methods_UArray2 array2
+ *          the array being mapped and its suite
+ *
+ *      A2Methods_applyfun *apply, void **cls
+ *          the apply function and the per-worker closures
+ *
+ *      A2Parallel_taskfun *task
+ *          for A2Parallel_run, the function called per task, in place
+ *          of apply
+ *
+ *      int width, height
+ *          the array's size
+ *
+ *      int band
+ *          rows per task for a row-major map, or 0
+ *
+ *      int tile, tiles_wide
+ *          side of a block-major map's tasks, and how many there are
+ *          across the array
+ *
+ *      size_t num_tasks
+ *          how many tasks there are
+ *
+ *      int num_deques, Deque deques[]
+ *          the workers' deques, one per worker taking part
+ *
+ ************************/
+typedef struct Map_Job {
+        A2Methods_T methods;
+        A2Methods_UArray2 array2;
+        A2Methods_applyfun *apply;
+        void **cls;
+        A2Parallel_taskfun *task;
+        int width;
+        int height;
+        int band;
+        int tile;
+        int tiles_wide;
+        size_t num_tasks;
+        int num_deques;
+        Deque deques[A2PARALLEL_MAX_WORKERS];
+} Map_Job;
+
+/********** Pool **********
+ *
+ * struct to hold the persistent pool of threads
+ *
+ * Contains:
+ *      int num_workers
+ *          workers in a map, counting the calling thread
+ *
+ *      pthread_mutex_t submit
+ *          held by the map that has the pool
+ *
+ *      pthread_mutex_t lock, pthread_cond_t work_ready, work_done
+ *          guard job, generation, and busy, and signal a new job and the
+ *          last pool thread finishing it
+ *
+ *      Map_Job *job, unsigned long generation
+ *          the current job, and how many jobs have been posted
+ *
+ *      int busy
+ *          pool threads still working on the current job
+ *
+ ************************/
+typedef struct Pool {
+        int num_workers;
+        pthread_mutex_t submit;
+        pthread_mutex_t lock;
+        pthread_cond_t work_ready;
+        pthread_cond_t work_done;
+        Map_Job *job;
+        unsigned long generation;
+        int busy;
+} Pool;
+
+static Pool pool = {
+        1,
+        PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_COND_INITIALIZER,
+        PTHREAD_COND_INITIALIZER,
+        NULL,
+        0,
+        0
+};
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void *pool_main(void *arg);
+
+
+/******************************************************************************
+ *
+ *                          THE POOL
+ *
+ *****************************************************************************/
+
+
+/********** start_pool **********
+ *
+ * Sizes the pool from the environment and starts its threads
+ *
+ * Notes:
+ *      Run once, through pthread_once. The threads are never joined;
+ *      they sleep between jobs until the program exits
+ ************************/
+static void start_pool(void)
+{
+        long n = A2Parallel_requested();
+        if (n < 1) {
+                n = 1;
+        }
+        pool.num_workers = n > A2PARALLEL_MAX_WORKERS
+                           ? A2PARALLEL_MAX_WORKERS : (int) n;
+        Stats40_num_workers = pool.num_workers;
+
+        for (int w = 1; w < pool.num_workers; w++) {
+                pthread_t thread;
+                int err = pthread_create(&thread, NULL, pool_main,
+                                         (void *) (ptrdiff_t) w);
+                if (err != 0) {
+                        /* run with the threads that did start */
+                        pool.num_workers = w;
+                        Stats40_num_workers = w;
+                        break;
+                }
+                pthread_detach(thread);
+        }
+}
+
+
+/********** A2Parallel_requested **********
+ *
+ * Returns the thread count asked for, before any clamping
+ *
+ * Return:
+ *      COMP40_THREADS if it is set to a number, otherwise the number of
+ *      online CPUs
+ *
+ * Notes:
+ *      A value that is not wholly a number is ignored
+ ************************/
+long A2Parallel_requested(void)
+{
+        const char *env = getenv("COMP40_THREADS");
+        char *end = NULL;
+        long n = 0;
+
+        if (env != NULL && *env != '\0') {
+                n = strtol(env, &end, 10);
+        }
+        /* unset, or not a number: one worker per online CPU */
+        if (end == NULL || *end != '\0') {
+                n = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        return n;
+}
+
+
+/********** A2Parallel_workers **********
+ *
+ * Returns how many closures a map's cls must hold
+ *
+ * Notes:
+ *      Starts the pool on the first call
+ ************************/
+int A2Parallel_workers(void)
+{
+        pthread_once(&pool_once, start_pool);
+        return pool.num_workers;
+}
+
+
+/********** run_task **********
+ *
+ * Runs one task: calls apply on every element of its part of the array,
+ * in row-major order, or calls the job's task function
+ *
+ ************************/
+static void run_task(Map_Job *job, size_t task, void *cl)
+{
+        if (job->task != NULL) {
+                job->task(task, cl);
+                return;
+        }
+
+        int col0 = 0;
+        int row0;
+        int cols = job->width;
+        int rows;
+
+        if (job->band > 0) {
+                row0 = task * job->band;
+                rows = job->band;
+        } else {
+                col0 = task % job->tiles_wide * job->tile;
+                row0 = task / job->tiles_wide * job->tile;
+                cols = job->tile;
+                rows = job->tile;
+        }
+        if (cols > job->width - col0) {
+                cols = job->width - col0;
+        }
+        if (rows > job->height - row0) {
+                rows = job->height - row0;
+        }
+
+        for (int row = row0; row < row0 + rows; row++) {
+                for (int col = col0; col < col0 + cols; col++) {
+                        job->apply(col, row, job->array2,
+                                   job->methods->at(job->array2, col, row),
+                                   cl);
+                }
+        }
+}
+
+
+/********** pack_range **********
+ *
+ * Returns the deque word for the tasks [lo, hi)
+ *
+ ************************/
+static inline uint64_t pack_range(uint64_t lo, uint64_t hi)
+{
+        return hi << RANGE_BITS | lo;
+}
+
+
+/********** pop_task **********
+ *
+ * Takes the bottom task of deque into *task; false if it is empty
+ *
+ ************************/
+static bool pop_task(Deque *deque, size_t *task)
+{
+        uint64_t range = __atomic_load_n(&deque->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+                uint64_t lo = range & RANGE_MASK;
+                uint64_t hi = range >> RANGE_BITS;
+                if (lo >= hi) {
+                        return false;
+                }
+                if (__atomic_compare_exchange_n(&deque->range, &range,
+                                                pack_range(lo + 1, hi), true,
+                                                __ATOMIC_ACQ_REL,
+                                                __ATOMIC_ACQUIRE)) {
+                        *task = lo;
+                        return true;
+                }
+        }
+}
+
+
+/********** steal_tasks **********
+ *
+ * Takes the top half of the first non-empty deque after worker's own
+ * into worker's (empty) deque, then pops one task from it into *task;
+ * false if every deque was empty when looked at
+ *
+ ************************/
+static bool steal_tasks(Map_Job *job, int worker, size_t *task)
+{
+        for (int i = 1; i < job->num_deques; i++) {
+                Deque *victim = &job->deques[(worker + i) % job->num_deques];
+                uint64_t range = __atomic_load_n(&victim->range,
+                                                 __ATOMIC_ACQUIRE);
+                for (;;) {
+                        uint64_t lo = range & RANGE_MASK;
+                        uint64_t hi = range >> RANGE_BITS;
+                        if (lo >= hi) {
+                                break;
+                        }
+                        uint64_t mid = lo + (hi - lo) / 2;
+                        if (__atomic_compare_exchange_n(&victim->range,
+                                                        &range,
+                                                        pack_range(lo, mid),
+                                                        true,
+                                                        __ATOMIC_ACQ_REL,
+                                                        __ATOMIC_ACQUIRE)) {
+                                STATS_STEAL(worker);
+                                __atomic_store_n(&job->deques[worker].range,
+                                                 pack_range(mid + 1, hi),
+                                                 __ATOMIC_RELEASE);
+                                *task = mid;
+                                return true;
+                        }
+                }
+        }
+        return false;
+}
+
+
+/********** run_job **********
+ *
+ * Runs tasks of job as worker, its own first and then stolen ones, until
+ * no deque has any left
+ *
+ ************************/
+static void run_job(Map_Job *job, int worker)
+{
+        void *cl = job->cls[worker];
+        Deque *own = &job->deques[worker];
+        size_t task;
+
+        while (pop_task(own, &task) || steal_tasks(job, worker, &task)) {
+                STATS_START(task_start);
+                run_task(job, task, cl);
+                STATS_TASK(worker, task_start);
+        }
+}
+
+
+/********** pool_main **********
+ *
+ * Body of pool thread arg: waits for each new job and helps run it
+ *
+ ************************/
+static void *pool_main(void *arg)
+{
+        int worker = (int) (ptrdiff_t) arg;
+        unsigned long seen = 0;
+
+        pthread_mutex_lock(&pool.lock);
+        for (;;) {
+                while (pool.generation == seen) {
+                        pthread_cond_wait(&pool.work_ready, &pool.lock);
+                }
+                seen = pool.generation;
+                Map_Job *job = pool.job;
+                pthread_mutex_unlock(&pool.lock);
+
+                run_job(job, worker);
+
+                pthread_mutex_lock(&pool.lock);
+                pool.busy--;
+                if (pool.busy == 0) {
+                        pthread_cond_signal(&pool.work_done);
+                }
+        }
+        return NULL;
+}
+
+
+/********** run_map **********
+ *
+ * Runs job on the pool, or on the calling thread alone if the pool is
+ * already running another job
+ *
+ ************************/
+static void run_map(Map_Job *job)
+{
+        if (job->num_tasks == 0) {
+                return;
+        }
+        assert(job->num_tasks <= RANGE_MASK);
+        STATS_START(map_start);
+
+        if (pool.num_workers == 1 || job->num_tasks == 1
+            || pthread_mutex_trylock(&pool.submit) != 0) {
+                job->num_deques = 1;
+                job->deques[0].range = pack_range(0, job->num_tasks);
+                run_job(job, 0);
+                STATS_PARALLEL(map_start);
+                return;
+        }
+
+        /* deal each worker a contiguous share */
+        job->num_deques = pool.num_workers;
+        for (int w = 0; w < job->num_deques; w++) {
+                job->deques[w].range = pack_range(
+                        job->num_tasks * w / job->num_deques,
+                        job->num_tasks * (w + 1) / job->num_deques);
+        }
+
+        pthread_mutex_lock(&pool.lock);
+        pool.job = job;
+        pool.busy = pool.num_workers - 1;
+        pool.generation++;
+        pthread_cond_broadcast(&pool.work_ready);
+        pthread_mutex_unlock(&pool.lock);
+
+        run_job(job, 0);
+
+        pthread_mutex_lock(&pool.lock);
+        while (pool.busy > 0) {
+                pthread_cond_wait(&pool.work_done, &pool.lock);
+        }
+        pool.job = NULL;
+        pthread_mutex_unlock(&pool.lock);
+        pthread_mutex_unlock(&pool.submit);
+        STATS_PARALLEL(map_start);
+}
+
+
+/******************************************************************************
+ *
+ *                          MAPS
+ *
+ *****************************************************************************/
+
+
+/********** init_job **********
+ *
+ * Sets up job to map over array2, with no tasks chosen yet
+ *
+ ************************/
+static void init_job(Map_Job *job, A2Methods_T methods,
+                     A2Methods_UArray2 array2, A2Methods_applyfun apply,
+                     void *cls[])
+{
+        assert(array2 != NULL && apply != NULL && cls != NULL);
+        A2Parallel_workers();
+
+        job->methods = methods;
+        job->array2 = array2;
+        job->apply = apply;
+        job->cls = cls;
+        job->task = NULL;
+        job->width = methods->width(array2);
+        job->height = methods->height(array2);
+        job->band = 0;
+        job->tile = 0;
+        job->tiles_wide = 0;
+        job->num_tasks = 0;
+}
+
+
+/********** map_rows **********
+ *
+ * Parallel row-major map, in bands of whole rows about TILE_AREA
+ * elements big
+ *
+ ************************/
+static void map_rows(A2Methods_T methods, A2Methods_UArray2 array2,
+                     A2Methods_applyfun apply, void *cls[])
+{
+        Map_Job job;
+        init_job(&job, methods, array2, apply, cls);
+        if (job.width == 0 || job.height == 0) {
+                return;
+        }
+
+        job.band = job.width >= TILE_AREA ? 1 : TILE_AREA / job.width;
+        job.num_tasks = (job.height + (size_t) job.band - 1) / job.band;
+        run_map(&job);
+}
+
+
+/********** map_blocks **********
+ *
+ * Parallel block-major map, a task per block (or TILE x TILE tile)
+ *
+ ************************/
+static void map_blocks(A2Methods_T methods, A2Methods_UArray2 array2,
+                       A2Methods_applyfun apply, void *cls[])
+{
+        Map_Job job;
+        init_job(&job, methods, array2, apply, cls);
+        if (job.width == 0 || job.height == 0) {
+                return;
+        }
+
+        int blocksize = methods->blocksize(array2);
+        job.tile = blocksize > 1 ? blocksize : TILE;
+        job.tiles_wide = (job.width + job.tile - 1) / job.tile;
+        job.num_tasks = (size_t) job.tiles_wide
+                        * ((job.height + job.tile - 1) / job.tile);
+        run_map(&job);
+}
+
+
+/********** A2Parallel_run **********
+ *
+ * Runs num_tasks tasks on the pool
+ *
+ * Parameters:
+ *      size_t num_tasks        - How many tasks there are
+ *      A2Parallel_taskfun task - Called once per task number
+ *      void *cls[]             - One closure per worker
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      task and cls are non-null
+ *      CRE if num_tasks is 2^32 or more
+ *
+ * Notes:
+ *      Tasks are dealt and stolen as the maps' are, so task i and i + 1
+ *      usually run on the same worker
+ ************************/
+void A2Parallel_run(size_t num_tasks, A2Parallel_taskfun task, void *cls[])
+{
+        assert(task != NULL && cls != NULL);
+        A2Parallel_workers();
+
+        Map_Job job;
+        job.cls = cls;
+        job.task = task;
+        job.num_tasks = num_tasks;
+        run_map(&job);
+}
+
+
+/********** Small_Closure **********
+ *
+ * struct to adapt a small apply function to the full apply signature
+ *
+ ************************/
+typedef struct Small_Closure {
+        A2Methods_smallapplyfun *apply;
+        void *cl;
+} Small_Closure;
+
+
+/********** apply_small **********
+ *
+ * Full apply function that calls a small one with its own closure
+ *
+ ************************/
+static void apply_small(int i, int j, A2Methods_UArray2 array2,
+                        A2Methods_Object *elem, void *vcl)
+{
+        (void)i;
+        (void)j;
+        (void)array2;
+        Small_Closure *cl = vcl;
+        cl->apply(elem, cl->cl);
+}
+
+
+/********** small_map **********
+ *
+ * Runs map with apply wrapped once per worker
+ *
+ ************************/
+static void small_map(void map(A2Methods_T, A2Methods_UArray2,
+                               A2Methods_applyfun, void *[]),
+                      A2Methods_T methods, A2Methods_UArray2 array2,
+                      A2Methods_smallapplyfun apply, void *cls[])
+{
+        assert(apply != NULL && cls != NULL);
+        int num_workers = A2Parallel_workers();
+        Small_Closure small[A2PARALLEL_MAX_WORKERS];
+        void *small_cls[A2PARALLEL_MAX_WORKERS];
+
+        for (int w = 0; w < num_workers; w++) {
+                small[w].apply = apply;
+                small[w].cl = cls[w];
+                small_cls[w] = &small[w];
+        }
+        map(methods, array2, apply_small, small_cls);
+}
+
+
+/* the plain suite's maps: the functions above on uarray2_methods_plain */
+
+static void plain_map_row_major(A2Methods_UArray2 array2,
+                                A2Methods_applyfun apply, void *cls[])
+{
+        map_rows(uarray2_methods_plain, array2, apply, cls);
+}
+
+static void plain_map_block_major(A2Methods_UArray2 array2,
+                                  A2Methods_applyfun apply, void *cls[])
+{
+        map_blocks(uarray2_methods_plain, array2, apply, cls);
+}
+
+static void plain_small_map_row_major(A2Methods_UArray2 array2,
+                                      A2Methods_smallapplyfun apply,
+                                      void *cls[])
+{
+        small_map(map_rows, uarray2_methods_plain, array2, apply, cls);
+}
+
+static void plain_small_map_block_major(A2Methods_UArray2 array2,
+                                        A2Methods_smallapplyfun apply,
+                                        void *cls[])
+{
+        small_map(map_blocks, uarray2_methods_plain, array2, apply, cls);
+}
+
+static const struct A2Parallel_T uarray2_parallel_plain_struct = {
+        plain_map_row_major,
+        plain_map_block_major,
+        plain_small_map_row_major,
+        plain_small_map_block_major,
+};
+
+A2Parallel_T uarray2_parallel_plain = &uarray2_parallel_plain_struct;
@@ -0,0 +1,82 @@
+/**************************************************************
+*
+*                     a2parallel.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       a2parallel.h declares parallel counterparts to the map
+*       functions of an A2Methods_T suite. Each map cuts the array into
+*       disjoint tile-sized tasks, short bands of rows or square blocks,
+*       and runs them on a pool of threads that is started on the first
+*       map and kept for the life of the program. Each worker starts on
+*       its own contiguous share of the tasks and steals from the others
+*       when it runs out, so regions that cost more to code do not leave
+*       the rest of the pool idle. A2Parallel_run does the same for
+*       tasks that are not elements of an array.
+*
+*       A map takes one closure per worker instead of one closure: every
+*       apply call made by worker w gets cls[w], so workers can gather
+*       results without locking and the caller combines them afterwards.
+*       Every element is visited exactly once, by one worker; apply calls
+*       for different tasks may run at the same time, so apply may write
+*       only to its own element and its own closure.
+*
+**************************************************************/
+#ifndef A2PARALLEL_INCLUDED
+#define A2PARALLEL_INCLUDED
+
+#include <stddef.h>
+#include "a2methods.h"
+
+/* most workers a map uses, so callers can size cls arrays statically */
+#define A2PARALLEL_MAX_WORKERS 64
+
+typedef void A2Parallel_mapfun(A2Methods_UArray2 array2,
+                               A2Methods_applyfun apply, void *cls[]);
+typedef void A2Parallel_smallmapfun(A2Methods_UArray2 array2,
+                                    A2Methods_smallapplyfun apply,
+                                    void *cls[]);
+typedef void A2Parallel_taskfun(size_t task, void *cl);
+
+/*
+ * map_row_major's tasks are bands of whole rows, about a 64 x 64 tile's
+ * worth of elements each, visited in row-major order. map_block_major's
+ * tasks are the array's blocks (64 x 64 tiles for an array with
+ * blocksize 1), each visited in row-major order. Tasks run in no
+ * particular order.
+ */
+typedef const struct A2Parallel_T {
+        A2Parallel_mapfun *map_row_major;
+        A2Parallel_mapfun *map_block_major;
+        A2Parallel_smallmapfun *small_map_row_major;
+        A2Parallel_smallmapfun *small_map_block_major;
+} *A2Parallel_T;
+
+/* parallel maps over arrays made with uarray2_methods_plain */
+extern A2Parallel_T uarray2_parallel_plain;
+
+/*
+ * The thread count asked for: COMP40_THREADS from the environment if it
+ * is set to a number, otherwise the number of online CPUs. Not clamped;
+ * each user decides what 0 or a negative count means.
+ */
+extern long A2Parallel_requested(void);
+
+/*
+ * How many closures a map's cls must hold: COMP40_THREADS from the
+ * environment if set, otherwise one per online CPU, and at least 1.
+ * A map that finds the pool busy (another thread's map, or a map from
+ * inside apply) runs on the calling thread alone and uses only cls[0].
+ */
+extern int A2Parallel_workers(void);
+
+/*
+ * Calls task(i, cls[w]) once for each i below num_tasks, spread over the
+ * pool as the maps' tasks are. CRE if num_tasks is 2^32 or more.
+ */
+extern void A2Parallel_run(size_t num_tasks, A2Parallel_taskfun task,
+                           void *cls[]);
+
+#endif
@@ -0,0 +1,638 @@
+/**************************************************************
+*
+*                     batch40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       batch40.c implements batch mode. The main thread owns all
+*       I/O: it keeps up to BATCH_DEPTH files in the window between
+*       "read submitted" and "write finished", so reads of later files
+*       and writes of earlier ones are in flight (through io40) while
+*       a worker thread runs the codec on files that are already in
+*       memory.
+*
+*       Each file is a Job. Once its read completes, the job goes on
+*       the ready queue; the worker takes it, compresses or decompresses
+*       it from one memory buffer into another, and puts it on the
+*       finished queue, from which the main thread submits its write.
+*       The two queues share one mutex; the worker sleeps on work_ready
+*       and the main thread, when it has no I/O to collect, waits
+*       briefly on work_done.
+*
+*       The codec runs on one file at a time, under codec_lock, inside a
+*       TRY, so a file that is not a valid image fails alone and the
+*       batch carries on: Hanson exceptions keep one stack of handlers
+*       for the whole process, so only one thread at a time may be inside
+*       a TRY. Each file's encode and decode maps run on the whole
+*       a2parallel pool instead.
+*
+**************************************************************/
+#include "batch40.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "assert.h"
+#include "except.h"
+#include "mem.h"
+#include "pnm.h"
+#include "pnm40.h"
+#include "a2plain.h"
+#include "codec40.h"
+#include "gray40.h"
+#include "seq40.h"
+#include "io40.h"
+#include "pipeline40.h"
+
+/* files between "read submitted" and "write finished" at once */
+#define BATCH_DEPTH 32
+
+/* longest the main thread sleeps waiting for a worker, in ns */
+#define WORK_WAIT_NS 1000000
+
+static pthread_mutex_t codec_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/********** Job **********
+ *
+ * struct to hold one file as it moves through batch mode
+ *
+ * Contains:
+ *      int index
+ *          position of the file in the paths array
+ *
+ *      unsigned char *input, size_t input_length
+ *          the file's contents, freed once the codec has run
+ *
+ *      char *output, size_t output_length
+ *          the result, allocated by open_memstream and freed with free
+ *          once it has been written
+ *
+ *      bool malformed
+ *          set by the codec if the input was not a valid image; the job
+ *          then has no output
+ *
+ *      struct Job *next
+ *          link in the ready or finished queue
+ *
+ ************************/
+typedef struct Job {
+        int index;
+        unsigned char *input;
+        size_t input_length;
+        char *output;
+        size_t output_length;
+        bool malformed;
+        struct Job *next;
+} Job;
+
+/********** Queue **********
+ *
+ * FIFO of jobs
+ *
+ ************************/
+typedef struct Queue {
+        Job *first;
+        Job *last;
+} Queue;
+
+/********** Batch **********
+ *
+ * struct to hold the state shared by the main thread and the worker
+ *
+ * Contains:
+ *      bool decompress
+ *          direction of the codec
+ *
+ *      pthread_mutex_t lock
+ *          protects both queues and closing
+ *
+ *      pthread_cond_t work_ready, work_done
+ *          signalled when a job is added to ready, or to finished
+ *
+ *      Queue ready, finished
+ *          jobs waiting for a worker, and jobs waiting to be written
+ *
+ *      bool closing
+ *          set when there is no more work, so the idle worker exits
+ *
+ *      The remaining fields belong to the main thread alone:
+ *
+ *      const char *outdir, char **paths, int num_files, Job *jobs
+ *          where results go, the inputs, and one job per input
+ *
+ *      Io40_T io, int num_workers
+ *          the I/O backend and the number of worker threads (0 or 1)
+ *
+ *      int next, remaining, in_window, computing
+ *          next file to read, files not yet done, files between "read
+ *          submitted" and "write finished", and jobs with the worker
+ *
+ *      Queue to_write
+ *          jobs whose output is ready to be written
+ *
+ *      int status
+ *          EXIT_FAILURE once any file has failed
+ *
+ ************************/
+typedef struct Batch {
+        bool decompress;
+        pthread_mutex_t lock;
+        pthread_cond_t work_ready;
+        pthread_cond_t work_done;
+        Queue ready;
+        Queue finished;
+        bool closing;
+
+        const char *outdir;
+        char **paths;
+        int num_files;
+        Job *jobs;
+        Io40_T io;
+        int num_workers;
+        int next;
+        int remaining;
+        int in_window;
+        int computing;
+        Queue to_write;
+        int status;
+} Batch;
+
+
+/********** push **********
+ *
+ * Adds job to the end of queue
+ *
+ ************************/
+static void push(Queue *queue, Job *job)
+{
+        job->next = NULL;
+        if (queue->last == NULL) {
+                queue->first = job;
+        } else {
+                queue->last->next = job;
+        }
+        queue->last = job;
+}
+
+
+/********** pop **********
+ *
+ * Removes and returns the first job of queue, or NULL if it is empty
+ *
+ ************************/
+static Job *pop(Queue *queue)
+{
+        Job *job = queue->first;
+        if (job != NULL) {
+                queue->first = job->next;
+                if (queue->first == NULL) {
+                        queue->last = NULL;
+                }
+        }
+        return job;
+}
+
+
+/********** code_image **********
+ *
+ * Compresses (or, if decompress is true, decompresses) the image at
+ * input's position onto output
+ *
+ * Notes:
+ *      The same functions as the single-file path are used, so the
+ *      output is identical to what 40image would write to stdout for
+ *      that input. CRE if input is malformed.
+ ************************/
+static void code_image(bool decompress, FILE *input, FILE *output)
+{
+        if (decompress) {
+                unsigned width, height;
+                unsigned format = Codec40_read_header(input, &width, &height);
+                if (format == GRAY40_FORMAT) {
+                        Gray40_decompress(input, width, height, output);
+                } else if (format == SEQ40_FORMAT) {
+                        Seq40_decompress(input, width, height, output);
+                } else {
+                        A2Methods_UArray2 codewords;
+                        codewords = Codec40_read_codewords(input, format,
+                                                           width, height);
+                        Pnm_ppm image = Codec40_decode(codewords);
+                        Pnm40_write_ppm(output, image);
+                        uarray2_methods_plain->free(&codewords);
+                        Pnm_ppmfree(&image);
+                }
+        } else if (Gray40_is_graymap(input)) {
+                Gray40_compress(input, output);
+        } else {
+                Pnm_ppm image = Pnm40_read_ppm(input, uarray2_methods_plain);
+                Codec40_trim(image);
+                A2Methods_UArray2 codewords = Codec40_encode(image);
+                Codec40_write(output, codewords);
+                uarray2_methods_plain->free(&codewords);
+                Pnm_ppmfree(&image);
+        }
+}
+
+
+/********** Batch40_code **********
+ *
+ * Compresses (or, if decompress is true, decompresses) the image at
+ * input's position onto output
+ *
+ * Parameters:
+ *      bool decompress - direction of the codec
+ *      FILE *input     - stream holding a PNM image or a compressed image
+ *      FILE *output    - stream the result is written to
+ *
+ * Return:
+ *      true if the image was coded, false if input was malformed, in
+ *      which case output holds whatever was written before that was found
+ *
+ * Expects:
+ *      input and output are non-null
+ *
+ * Notes:
+ *      Holds codec_lock for the whole call, so calls from different
+ *      threads run one at a time. Memory the codec had allocated when it
+ *      found the input malformed is not recovered; the server codes in
+ *      worker processes it replaces after such a failure (see serve40.c).
+ ************************/
+bool Batch40_code(bool decompress, FILE *input, FILE *output)
+{
+        assert(input != NULL && output != NULL);
+
+        volatile bool coded = true;
+        pthread_mutex_lock(&codec_lock);
+        TRY
+                code_image(decompress, input, output);
+        ELSE
+                coded = false;
+        END_TRY;
+        pthread_mutex_unlock(&codec_lock);
+        return coded;
+}
+
+
+/********** run_codec **********
+ *
+ * Compresses or decompresses job's input buffer into its output buffer
+ *
+ * Notes:
+ *      Runs Batch40_code on memory streams. If the input is malformed,
+ *      the job is marked so and its output is freed.
+ ************************/
+static void run_codec(bool decompress, Job *job)
+{
+        FILE *input = fmemopen(job->input, job->input_length, "rb");
+        FILE *output = open_memstream(&job->output, &job->output_length);
+        assert(input != NULL && output != NULL);
+
+        job->malformed = !Batch40_code(decompress, input, output);
+
+        fclose(input);
+        fclose(output);
+        FREE(job->input);
+        if (job->malformed) {
+                free(job->output);
+                job->output = NULL;
+                job->output_length = 0;
+        }
+}
+
+
+/********** worker_main **********
+ *
+ * Worker thread: runs the codec on ready jobs until closing is set
+ *
+ ************************/
+static void *worker_main(void *arg)
+{
+        Batch *batch = arg;
+
+        pthread_mutex_lock(&batch->lock);
+        for (;;) {
+                Job *job = pop(&batch->ready);
+                if (job == NULL) {
+                        if (batch->closing) {
+                                break;
+                        }
+                        pthread_cond_wait(&batch->work_ready, &batch->lock);
+                        continue;
+                }
+                pthread_mutex_unlock(&batch->lock);
+
+                run_codec(batch->decompress, job);
+
+                pthread_mutex_lock(&batch->lock);
+                push(&batch->finished, job);
+                pthread_cond_signal(&batch->work_done);
+        }
+        pthread_mutex_unlock(&batch->lock);
+        return NULL;
+}
+
+
+/********** output_path **********
+ *
+ * Returns the path batch mode writes the result for path to
+ *
+ * Notes:
+ *      The caller frees the result with FREE
+ ************************/
+static char *output_path(bool decompress, const char *outdir,
+                         const char *path)
+{
+        const char *slash = strrchr(path, '/');
+        const char *base = slash == NULL ? path : slash + 1;
+        size_t base_length = strlen(base);
+        const char *suffix = ".c40";
+
+        if (decompress) {
+                size_t n = strlen(".c40");
+                if (base_length > n
+                    && strcmp(base + base_length - n, ".c40") == 0) {
+                        base_length -= n;
+                        suffix = "";
+                } else {
+                        suffix = ".ppm";
+                }
+        }
+
+        size_t size = strlen(outdir) + 1 + base_length + strlen(suffix) + 1;
+        char *result = ALLOC(size);
+        snprintf(result, size, "%s/%.*s%s", outdir, (int) base_length, base,
+                 suffix);
+        return result;
+}
+
+
+/********** fail **********
+ *
+ * Reports an error for one file, in the style of perror, and counts the
+ * file as done
+ *
+ * Notes:
+ *      in_window says whether the file had entered the window
+ ************************/
+static void fail(Batch *batch, const char *path, const char *reason,
+                 bool in_window)
+{
+        fprintf(stderr, "%s: %s\n", path, reason);
+        batch->status = EXIT_FAILURE;
+        batch->remaining--;
+        if (in_window) {
+                batch->in_window--;
+        }
+}
+
+
+/********** fill_window **********
+ *
+ * Submits reads of the next files until the window is full
+ *
+ * Return:
+ *      true if any file was started
+ ************************/
+static bool fill_window(Batch *batch)
+{
+        bool progress = false;
+
+        while (batch->next < batch->num_files
+               && batch->in_window < BATCH_DEPTH) {
+                Job *job = &batch->jobs[batch->next];
+                job->index = batch->next;
+                if (Io40_read_file(batch->io, batch->paths[job->index],
+                                   job)) {
+                        batch->in_window++;
+                } else {
+                        fail(batch, batch->paths[job->index], strerror(errno),
+                             false);
+                }
+                batch->next++;
+                progress = true;
+        }
+        return progress;
+}
+
+
+/********** handle_completion **********
+ *
+ * Acts on one finished read or write
+ *
+ * Notes:
+ *      A loaded file goes to the worker, or with no worker straight
+ *      through the codec and onto to_write. An empty file is an error.
+ ************************/
+static void handle_completion(Batch *batch, Io40_Completion *done)
+{
+        Job *job = done->tag;
+        const char *path = batch->paths[job->index];
+
+        if (done->kind == IO40_WRITE) {
+                free(job->output);
+                if (done->error != 0) {
+                        fail(batch, path, strerror(done->error), true);
+                } else {
+                        batch->remaining--;
+                        batch->in_window--;
+                }
+                return;
+        }
+
+        if (done->error != 0 || done->length == 0) {
+                FREE(done->data);
+                fail(batch, path,
+                     strerror(done->error != 0 ? done->error : EINVAL), true);
+                return;
+        }
+
+        job->input = done->data;
+        job->input_length = done->length;
+        if (batch->num_workers == 0) {
+                run_codec(batch->decompress, job);
+                push(&batch->to_write, job);
+                return;
+        }
+        pthread_mutex_lock(&batch->lock);
+        push(&batch->ready, job);
+        pthread_cond_signal(&batch->work_ready);
+        pthread_mutex_unlock(&batch->lock);
+        batch->computing++;
+}
+
+
+/********** collect_finished **********
+ *
+ * Moves jobs the worker has finished onto to_write
+ *
+ * Return:
+ *      true if any job was moved
+ ************************/
+static bool collect_finished(Batch *batch)
+{
+        bool progress = false;
+        Job *job;
+
+        pthread_mutex_lock(&batch->lock);
+        while ((job = pop(&batch->finished)) != NULL) {
+                push(&batch->to_write, job);
+                batch->computing--;
+                progress = true;
+        }
+        pthread_mutex_unlock(&batch->lock);
+        return progress;
+}
+
+
+/********** submit_writes **********
+ *
+ * Submits a write for every job on to_write
+ *
+ * Return:
+ *      true if any job was taken off to_write
+ ************************/
+static bool submit_writes(Batch *batch)
+{
+        bool progress = false;
+        Job *job;
+
+        while ((job = pop(&batch->to_write)) != NULL) {
+                if (job->malformed) {
+                        fail(batch, batch->paths[job->index],
+                             "not a valid image", true);
+                        progress = true;
+                        continue;
+                }
+                char *path = output_path(batch->decompress, batch->outdir,
+                                         batch->paths[job->index]);
+                if (!Io40_write_file(batch->io, path,
+                                     (unsigned char *) job->output,
+                                     job->output_length, job)) {
+                        free(job->output);
+                        fail(batch, path, strerror(errno), true);
+                }
+                FREE(path);
+                progress = true;
+        }
+        return progress;
+}
+
+
+/********** wait_for_work **********
+ *
+ * Sleeps until the worker finishes a job (or briefly, if I/O may finish
+ * first), or, with nothing on the worker, until a request completes
+ *
+ ************************/
+static void wait_for_work(Batch *batch)
+{
+        if (batch->computing == 0) {
+                Io40_Completion done;
+                if (Io40_wait(batch->io, &done, true)) {
+                        handle_completion(batch, &done);
+                }
+                return;
+        }
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += WORK_WAIT_NS;
+        if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+        }
+        pthread_mutex_lock(&batch->lock);
+        if (batch->finished.first == NULL) {
+                pthread_cond_timedwait(&batch->work_done, &batch->lock,
+                                       &until);
+        }
+        pthread_mutex_unlock(&batch->lock);
+}
+
+
+/********** Batch40_run **********
+ *
+ * Compresses or decompresses many files, overlapping their I/O with the
+ * codec
+ *
+ * Parameters:
+ *      bool decompress    - true to decompress, false to compress
+ *      const char *outdir - Directory to write results to
+ *      int num_files      - Number of input paths
+ *      char *paths[]      - Input paths
+ *
+ * Return:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if any file failed
+ *
+ * Expects:
+ *      outdir and paths are non-null
+ *
+ * Notes:
+ *      The codec runs on a worker thread, and with COMP40_THREADS=0 on
+ *      the main thread between I/O requests. A file that is not a valid
+ *      image is reported on stderr and the rest are still processed.
+ ************************/
+int Batch40_run(bool decompress, const char *outdir, int num_files,
+                char *paths[])
+{
+        assert(outdir != NULL && paths != NULL && num_files >= 0);
+
+        Batch batch;
+        memset(&batch, 0, sizeof(batch));
+        batch.decompress = decompress;
+        pthread_mutex_init(&batch.lock, NULL);
+        pthread_cond_init(&batch.work_ready, NULL);
+        pthread_cond_init(&batch.work_done, NULL);
+        batch.outdir = outdir;
+        batch.paths = paths;
+        batch.num_files = num_files;
+        batch.jobs = CALLOC(num_files > 0 ? num_files : 1, sizeof(Job));
+        batch.io = Io40_new(BATCH_DEPTH);
+        batch.remaining = num_files;
+        batch.status = EXIT_SUCCESS;
+
+        /* the codec runs one file at a time, so one worker is enough */
+        batch.num_workers = Pipeline40_threads() > 0 ? 1 : 0;
+        pthread_t worker;
+        if (batch.num_workers > 0) {
+                int err = pthread_create(&worker, NULL, worker_main, &batch);
+                assert(err == 0);
+        }
+
+        while (batch.remaining > 0) {
+                bool progress = fill_window(&batch);
+
+                Io40_Completion done;
+                while (Io40_wait(batch.io, &done, false)) {
+                        handle_completion(&batch, &done);
+                        progress = true;
+                }
+                progress |= collect_finished(&batch);
+                progress |= submit_writes(&batch);
+
+                if (!progress && batch.remaining > 0) {
+                        wait_for_work(&batch);
+                }
+        }
+
+        /* let the worker go */
+        pthread_mutex_lock(&batch.lock);
+        batch.closing = true;
+        pthread_cond_broadcast(&batch.work_ready);
+        pthread_mutex_unlock(&batch.lock);
+        if (batch.num_workers > 0) {
+                pthread_join(worker, NULL);
+        }
+
+        FREE(batch.jobs);
+        Io40_free(&batch.io);
+        pthread_cond_destroy(&batch.work_done);
+        pthread_cond_destroy(&batch.work_ready);
+        pthread_mutex_destroy(&batch.lock);
+        return batch.status;
+}
@@ -0,0 +1,39 @@
+/**************************************************************
+*
+*                     batch40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       batch40.h declares batch mode, which compresses or
+*       decompresses many files at once, overlapping their I/O with
+*       the codec work.
+*
+**************************************************************/
+#ifndef BATCH40_INCLUDED
+#define BATCH40_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*
+ * Compresses (or, if decompress is true, decompresses) each of the
+ * num_files paths into outdir. A compressed file is named after its input
+ * with ".c40" appended; a decompressed file drops a trailing ".c40", or
+ * else has ".ppm" appended. Returns EXIT_SUCCESS, or EXIT_FAILURE if any
+ * file could not be read, coded, or written (the rest are still
+ * processed).
+ */
+extern int Batch40_run(bool decompress, const char *outdir, int num_files,
+                       char *paths[]);
+
+/*
+ * Compresses (or decompresses) the one image at input's position onto
+ * output, exactly as 40image would for that file. Returns false if it is
+ * malformed. Calls run one at a time. Batch mode and the server
+ * (serve40.c) run every file through this.
+ */
+extern bool Batch40_code(bool decompress, FILE *input, FILE *output);
+
+#endif
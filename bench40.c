@@ -0,0 +1,1115 @@
+/**************************************************************
+*
+*                     bench40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       bench40.c is a benchmark harness for the compression pipeline.
+*       It generates synthetic PPM images (noise, gradient, flat, and
+*       photo-like content) at several resolutions and times every
+*       encode and decode stage on its own, over several repetitions.
+*
+*       Results are printed as a table on stdout and, when requested,
+*       written as JSON so that runs can be compared across releases.
+*
+*       With -V it instead checks the fixed-point codec against the
+*       float one, on the synthetic images and on any PPM files named,
+*       and fails if any codeword field or decoded channel is further
+*       apart than the allowed bound.
+*
+*       Usage:
+*               bench40 [-r reps] [-s WIDTHxHEIGHT]... [-p pattern]...
+*                       [-o results.json]
+*               bench40 -V [-s WIDTHxHEIGHT]... [-p pattern]... [image...]
+*
+**************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <inttypes.h>
+#include "assert.h"
+#include "mem.h"
+#include "pnm.h"
+#include "pnm40.h"
+#include "a2plain.h"
+#include "a2methods.h"
+#include "arith40.h"
+#include "codec40.h"
+#include "fixed40.h"
+#include "bitpack40.h"
+
+#define DEFAULT_REPS 5
+#define MAX_REPS 100
+#define MAX_SIZES 16
+#define NS_PER_SEC 1e9
+
+/* largest float/fixed difference -V accepts, in quantization levels for
+ * codeword fields and in output steps (denominator / 255, rounded up, so
+ * one unit for 8-bit images) for decoded channels */
+#define VERIFY_MAX_FIELD 1
+#define VERIFY_MAX_CHANNEL 1
+#define VERIFY_STEP_LEVELS 255
+
+/********** Pattern **********
+ *
+ * kinds of synthetic image content the harness can generate
+ *
+ ************************/
+typedef enum Pattern {
+        PATTERN_NOISE = 0,
+        PATTERN_GRADIENT,
+        PATTERN_FLAT,
+        PATTERN_PHOTO,
+        NUM_PATTERNS
+} Pattern;
+
+static const char *pattern_names[NUM_PATTERNS] = {
+        "noise", "gradient", "flat", "photo"
+};
+
+/********** Stage **********
+ *
+ * pipeline stages timed by the harness, encode stages first followed by
+ * their decode mirrors, then whole-block coding on the float and
+ * fixed-point paths, and on the float path through the block caches,
+ * then the codeword fields packed and unpacked a whole image per call by
+ * each Bitpack40 kernel
+ *
+ ************************/
+typedef enum Stage {
+        STAGE_READ = 0,
+        STAGE_CONVERT,
+        STAGE_DCT,
+        STAGE_QUANTIZE,
+        STAGE_PACK,
+        STAGE_WRITE,
+        STAGE_DECODE_READ,
+        STAGE_UNPACK,
+        STAGE_IDCT,
+        STAGE_CONVERT_RGB,
+        STAGE_DECODE_WRITE,
+        STAGE_FLOAT_ENCODE,
+        STAGE_FIXED_ENCODE,
+        STAGE_FLOAT_DECODE,
+        STAGE_FIXED_DECODE,
+        STAGE_CACHED_ENCODE,
+        STAGE_CACHED_DECODE,
+        STAGE_PACK_SCALAR,
+        STAGE_PACK_AVX2,
+        STAGE_PACK_BMI2,
+        STAGE_UNPACK_SCALAR,
+        STAGE_UNPACK_AVX2,
+        STAGE_UNPACK_BMI2,
+        NUM_STAGES
+} Stage;
+
+static const char *stage_names[NUM_STAGES] = {
+        "read", "convert", "dct", "quantize", "pack", "write",
+        "decode_read", "unpack", "idct", "convert_rgb", "decode_write",
+        "float_encode", "fixed_encode", "float_decode", "fixed_decode",
+        "cached_encode", "cached_decode", "pack_scalar", "pack_avx2",
+        "pack_bmi2", "unpack_scalar", "unpack_avx2", "unpack_bmi2"
+};
+
+/********** Size **********
+ *
+ * struct to hold one benchmarked resolution
+ *
+ ************************/
+typedef struct Size {
+        unsigned width;
+        unsigned height;
+} Size;
+
+static const Size default_sizes[] = {
+        { 256, 256 }, { 1280, 720 }, { 3840, 2160 }
+};
+
+/********** Bench_Case **********
+ *
+ * struct to hold everything needed to run one pattern at one resolution
+ *
+ * Contains:
+ *      Pattern pattern, Size size
+ *          the synthetic content and resolution being benchmarked
+ *
+ *      FILE *ppm_file, *comp_file, *sink
+ *          the generated PPM, the compressed output, and /dev/null
+ *
+ *      Block_Pixel_Info *blocks, uint64_t *words
+ *          per-block working state, one entry per 2x2 block
+ *
+ *      int64_t *fields, uint64_t *bulk_words, int64_t *unpacked
+ *          every block's six codeword fields, the words Bitpack40_pack
+ *          makes of them, and the fields Bitpack40_unpack gets back
+ *
+ *      Pnm_ppm decoded
+ *          image the decoder stages write into
+ *
+ *      uint32_t checksum
+ *          xor of codewords from the whole-block runs, kept so that the
+ *          compiler cannot drop them
+ *
+ *      double samples[NUM_STAGES][MAX_REPS]
+ *          wall-clock nanoseconds per stage per repetition
+ *
+ ************************/
+typedef struct Bench_Case {
+        Pattern pattern;
+        Size size;
+        FILE *ppm_file;
+        FILE *comp_file;
+        FILE *sink;
+        size_t num_blocks;
+        Block_Pixel_Info *blocks;
+        uint64_t *words;
+        int64_t *fields;
+        uint64_t *bulk_words;
+        int64_t *unpacked;
+        Pnm_ppm decoded;
+        uint32_t checksum;
+        double samples[NUM_STAGES][MAX_REPS];
+} Bench_Case;
+
+
+/******************************************************************************
+ *
+ *                          TIMING AND GENERATION
+ *
+ *****************************************************************************/
+
+
+/********** now_ns **********
+ *
+ * Returns the current value of the monotonic clock in nanoseconds
+ *
+ ************************/
+static double now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+
+/********** next_random **********
+ *
+ * Advances a xorshift64 generator and returns its next value. A fixed
+ * generator keeps the synthetic images identical from run to run.
+ *
+ ************************/
+static uint64_t next_random(uint64_t *state)
+{
+        uint64_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        return x;
+}
+
+
+/********** clamp_channel **********
+ *
+ * Rounds and clamps a generated channel value into [0, 255]
+ *
+ ************************/
+static unsigned clamp_channel(double value)
+{
+        if (value < 0) {
+                return 0;
+        }
+        if (value > 255) {
+                return 255;
+        }
+        return (unsigned) (value + 0.5);
+}
+
+
+/********** fill_pixel **********
+ *
+ * Computes the synthetic value of one pixel for the given pattern
+ *
+ * Notes:
+ *      photo combines smooth low-frequency shading, hard-edged regions, and
+ *      a little sensor-like noise, which is roughly what camera images give
+ *      the quantizer
+ ************************/
+static void fill_pixel(Pattern pattern, unsigned col, unsigned row, Size size,
+                       uint64_t *rng, Pnm_rgb pixel)
+{
+        double x = (double) col / size.width;
+        double y = (double) row / size.height;
+
+        switch (pattern) {
+        case PATTERN_NOISE:
+                pixel->red   = next_random(rng) & 0xff;
+                pixel->green = next_random(rng) & 0xff;
+                pixel->blue  = next_random(rng) & 0xff;
+                break;
+        case PATTERN_GRADIENT:
+                pixel->red   = clamp_channel(255 * x);
+                pixel->green = clamp_channel(255 * y);
+                pixel->blue  = clamp_channel(255 * (x + y) / 2);
+                break;
+        case PATTERN_FLAT:
+                pixel->red   = 128;
+                pixel->green = 96;
+                pixel->blue  = 200;
+                break;
+        default: {
+                double shade = 110 + 60 * sin(x * 7.0) * cos(y * 5.0);
+                double edge  = ((col / 97 + row / 61) % 3) * 25.0;
+                double noise = (double) (next_random(rng) % 17) - 8;
+                pixel->red   = clamp_channel(shade + edge + noise);
+                pixel->green = clamp_channel(shade * 0.9 + noise);
+                pixel->blue  = clamp_channel(shade * 0.7 - edge + noise + 30);
+                break;
+        }
+        }
+}
+
+
+/********** generate_image **********
+ *
+ * Creates a synthetic image of the requested pattern and size with a
+ * denominator of 255
+ *
+ * Notes:
+ *      The returned image must be freed with Pnm_ppmfree
+ ************************/
+static Pnm_ppm generate_image(Pattern pattern, Size size)
+{
+        A2Methods_T methods = uarray2_methods_plain;
+        uint64_t rng = 0x9e3779b97f4a7c15ull;
+        Pnm_ppm image;
+        NEW(image);
+
+        image->width = size.width;
+        image->height = size.height;
+        image->denominator = 255;
+        image->methods = methods;
+        image->pixels = methods->new(size.width, size.height,
+                                     sizeof(struct Pnm_rgb));
+
+        for (unsigned row = 0; row < size.height; row++) {
+                for (unsigned col = 0; col < size.width; col++) {
+                        fill_pixel(pattern, col, row, size, &rng,
+                                   methods->at(image->pixels, col, row));
+                }
+        }
+        return image;
+}
+
+
+/******************************************************************************
+ *
+ *                          STAGE RUNNERS
+ *
+ *****************************************************************************/
+
+
+/********** block_pixel **********
+ *
+ * Returns the pixel at position block_i (0-3) of the given block index
+ *
+ ************************/
+static Pnm_rgb block_pixel(Pnm_ppm image, size_t block, int block_i)
+{
+        unsigned blocks_wide = image->width / BLOCKSIZE;
+        unsigned col = (block % blocks_wide) * BLOCKSIZE + block_i % BLOCKSIZE;
+        unsigned row = (block / blocks_wide) * BLOCKSIZE + block_i / BLOCKSIZE;
+
+        return image->methods->at(image->pixels, col, row);
+}
+
+
+/********** block_pixels **********
+ *
+ * Gathers the four pixels of the given block index
+ *
+ ************************/
+static void block_pixels(Pnm_ppm image, size_t block,
+                         Pnm_rgb pixels[BLOCKAREA])
+{
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                pixels[block_i] = block_pixel(image, block, block_i);
+        }
+}
+
+
+/********** codeword_layout **********
+ *
+ * Returns the codeword's six fields as a Bitpack40 layout, in the order
+ * a, b, c, d, Pb, Pr
+ *
+ ************************/
+static Bitpack40_Layout codeword_layout(void)
+{
+        CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = {
+                CODEWORD_A, CODEWORD_B, CODEWORD_C,
+                CODEWORD_D, CODEWORD_PB, CODEWORD_PR
+        };
+        Bitpack40_Layout layout;
+        layout.num_fields = NUM_CODEWORD_ELEMENTS;
+        for (int f = 0; f < NUM_CODEWORD_ELEMENTS; f++) {
+                layout.fields[f].width = code_elems[f].width;
+                layout.fields[f].lsb = code_elems[f].lsb;
+                layout.fields[f].isSigned = code_elems[f].isSigned;
+        }
+        return layout;
+}
+
+
+/********** run_blocks **********
+ *
+ * Times whole-block encoding of image and decoding of the case's
+ * codewords, through the float stages, through fixed40.c, and through
+ * the float stages with the block caches on, for repetition rep
+ *
+ ************************/
+static void run_blocks(Bench_Case *bc, Pnm_ppm image, int rep)
+{
+        Pnm_rgb pixels[BLOCKAREA];
+        uint32_t checksum = 0;
+
+        Codec40_use_cache(false);
+        double start = now_ns();
+
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(image, i, pixels);
+                checksum ^= Codec40_encode_block(pixels, image->denominator);
+        }
+        bc->samples[STAGE_FLOAT_ENCODE][rep] = now_ns() - start;
+
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(image, i, pixels);
+                checksum ^= Fixed40_encode_block(pixels, image->denominator);
+        }
+        bc->samples[STAGE_FIXED_ENCODE][rep] = now_ns() - start;
+        bc->checksum ^= checksum;
+
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(bc->decoded, i, pixels);
+                Codec40_decode_block(bc->words[i], image->denominator, pixels);
+        }
+        bc->samples[STAGE_FLOAT_DECODE][rep] = now_ns() - start;
+
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(bc->decoded, i, pixels);
+                Fixed40_decode_block(bc->words[i], image->denominator, pixels);
+        }
+        bc->samples[STAGE_FIXED_DECODE][rep] = now_ns() - start;
+
+        Codec40_use_cache(true);
+        checksum = 0;
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(image, i, pixels);
+                checksum ^= Codec40_encode_block(pixels, image->denominator);
+        }
+        bc->samples[STAGE_CACHED_ENCODE][rep] = now_ns() - start;
+        bc->checksum ^= checksum;
+
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                block_pixels(bc->decoded, i, pixels);
+                Codec40_decode_block(bc->words[i], image->denominator, pixels);
+        }
+        bc->samples[STAGE_CACHED_DECODE][rep] = now_ns() - start;
+}
+
+
+/********** run_bitpack **********
+ *
+ * Times packing every block's quantized fields into codewords with one
+ * Bitpack40 call, and unpacking them again, with each kernel in turn,
+ * for repetition rep. Every kernel must give the per-block packer's
+ * codewords and the original fields back.
+ *
+ ************************/
+static void run_bitpack(Bench_Case *bc, int rep)
+{
+        static const Bitpack40_Kernel kernels[] = {
+                BITPACK40_SCALAR, BITPACK40_AVX2, BITPACK40_BMI2
+        };
+        size_t num_fields = bc->num_blocks * NUM_CODEWORD_ELEMENTS;
+        Bitpack40_Layout layout = codeword_layout();
+
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                Block_Pixel_Info *block = &bc->blocks[i];
+                int64_t *fields = &bc->fields[i * NUM_CODEWORD_ELEMENTS];
+                for (int f = 0; f < 4; f++) {
+                        fields[f] = block->quantized_abcd[f];
+                }
+                fields[4] = block->pb_chromaIndex;
+                fields[5] = block->pr_chromaIndex;
+        }
+
+        for (int k = 0; k < 3; k++) {
+                Bitpack40_use_kernel(kernels[k]);
+
+                double start = now_ns();
+                size_t overflows = Bitpack40_pack(&layout, bc->fields,
+                                                  bc->bulk_words,
+                                                  bc->num_blocks);
+                bc->samples[STAGE_PACK_SCALAR + k][rep] = now_ns() - start;
+                assert(overflows == 0);
+                assert(memcmp(bc->words, bc->bulk_words,
+                              bc->num_blocks * sizeof(*bc->words)) == 0);
+
+                start = now_ns();
+                Bitpack40_unpack(&layout, bc->bulk_words, bc->unpacked,
+                                 bc->num_blocks);
+                bc->samples[STAGE_UNPACK_SCALAR + k][rep] = now_ns() - start;
+                assert(memcmp(bc->fields, bc->unpacked,
+                              num_fields * sizeof(*bc->fields)) == 0);
+        }
+        Bitpack40_use_kernel(BITPACK40_AUTO);
+}
+
+
+/********** run_encode **********
+ *
+ * Runs each encode stage over every block of the case's image, recording
+ * the time of each stage for repetition rep
+ *
+ ************************/
+static void run_encode(Bench_Case *bc, int rep)
+{
+        double start = now_ns();
+
+        /* read */
+        rewind(bc->ppm_file);
+        Pnm_ppm image = Pnm40_read_ppm(bc->ppm_file, uarray2_methods_plain);
+        bc->samples[STAGE_READ][rep] = now_ns() - start;
+
+        /* color conversion */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                        RGB_to_ComponentVideo(block_pixel(image, i, block_i),
+                                              image->denominator,
+                                              &bc->blocks[i].compvidArr[block_i]);
+                }
+        }
+        bc->samples[STAGE_CONVERT][rep] = now_ns() - start;
+
+        /* discrete cosine transform */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                discrete_Cosine_Transform(&bc->blocks[i]);
+        }
+        bc->samples[STAGE_DCT][rep] = now_ns() - start;
+
+        /* quantization */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                abcd_quantization(&bc->blocks[i]);
+                chroma_quantization(&bc->blocks[i]);
+        }
+        bc->samples[STAGE_QUANTIZE][rep] = now_ns() - start;
+
+        /* codeword packing */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                Block_Pixel_Info *block = &bc->blocks[i];
+                CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = {
+                        CODEWORD_A, CODEWORD_B, CODEWORD_C,
+                        CODEWORD_D, CODEWORD_PB, CODEWORD_PR
+                };
+                code_elems[0].value = block->quantized_abcd[0];
+                code_elems[1].value = block->quantized_abcd[1];
+                code_elems[2].value = block->quantized_abcd[2];
+                code_elems[3].value = block->quantized_abcd[3];
+                code_elems[4].value = block->pb_chromaIndex;
+                code_elems[5].value = block->pr_chromaIndex;
+                bc->words[i] = pack_codeword(code_elems);
+        }
+        bc->samples[STAGE_PACK][rep] = now_ns() - start;
+        run_bitpack(bc, rep);
+
+        /* output */
+        start = now_ns();
+        rewind(bc->comp_file);
+        fprintf(bc->comp_file, "COMP40 Compressed image format 2\n%u %u\n",
+                image->width, image->height);
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                print_codeword(bc->comp_file, bc->words[i]);
+        }
+        fflush(bc->comp_file);
+        bc->samples[STAGE_WRITE][rep] = now_ns() - start;
+
+        run_blocks(bc, image, rep);
+        Pnm_ppmfree(&image);
+}
+
+
+/********** run_decode **********
+ *
+ * Runs each decode stage over the compressed output left by run_encode,
+ * recording the time of each stage for repetition rep
+ *
+ ************************/
+static void run_decode(Bench_Case *bc, int rep)
+{
+        Pnm_ppm image = bc->decoded;
+        double start = now_ns();
+
+        /* read codewords */
+        unsigned width, height;
+        rewind(bc->comp_file);
+        int read = fscanf(bc->comp_file,
+                          "COMP40 Compressed image format 2\n%u %u",
+                          &width, &height);
+        assert(read == 2 && getc(bc->comp_file) == '\n');
+        assert(width == image->width && height == image->height);
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                read_codeword(bc->comp_file, &bc->words[i]);
+        }
+        bc->samples[STAGE_DECODE_READ][rep] = now_ns() - start;
+
+        /* unpack fields */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                Block_Pixel_Info *block = &bc->blocks[i];
+                CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = {
+                        CODEWORD_A, CODEWORD_B, CODEWORD_C,
+                        CODEWORD_D, CODEWORD_PB, CODEWORD_PR
+                };
+                extract_bitpack(bc->words[i], code_elems);
+                block->quantized_abcd[0] = code_elems[0].value;
+                block->quantized_abcd[1] = code_elems[1].value;
+                block->quantized_abcd[2] = code_elems[2].value;
+                block->quantized_abcd[3] = code_elems[3].value;
+                block->pb_chromaIndex = code_elems[4].value;
+                block->pr_chromaIndex = code_elems[5].value;
+        }
+        bc->samples[STAGE_UNPACK][rep] = now_ns() - start;
+
+        /* dequantize chroma and apply the inverse transform */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                Block_Pixel_Info *block = &bc->blocks[i];
+                block->pb_mean = Arith40_chroma_of_index(block->pb_chromaIndex);
+                block->pr_mean = Arith40_chroma_of_index(block->pr_chromaIndex);
+                inverse_discrete_Cosine_Transform(block);
+        }
+        bc->samples[STAGE_IDCT][rep] = now_ns() - start;
+
+        /* color conversion back to RGB */
+        start = now_ns();
+        for (size_t i = 0; i < bc->num_blocks; i++) {
+                Block_Pixel_Info *block = &bc->blocks[i];
+                for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                        ComponentVideo_to_RGB(block->pb_mean, block->pr_mean,
+                                              &block->compvidArr[block_i],
+                                              image->denominator,
+                                              block_pixel(image, i, block_i));
+                }
+        }
+        bc->samples[STAGE_CONVERT_RGB][rep] = now_ns() - start;
+
+        /* output */
+        start = now_ns();
+        Pnm40_write_ppm(bc->sink, image);
+        fflush(bc->sink);
+        bc->samples[STAGE_DECODE_WRITE][rep] = now_ns() - start;
+}
+
+
+/******************************************************************************
+ *
+ *                          REPORTING
+ *
+ *****************************************************************************/
+
+
+/********** Stage_Summary **********
+ *
+ * struct to hold the statistics of one stage across all repetitions
+ *
+ ************************/
+typedef struct Stage_Summary {
+        double mean_ns;
+        double stddev_ns;
+        double min_ns;
+        double mb_per_s;
+        double ns_per_block;
+} Stage_Summary;
+
+
+/********** summarize **********
+ *
+ * Computes the mean, sample standard deviation, minimum, and derived
+ * throughput of one stage of a finished case
+ *
+ * Notes:
+ *      MB/s is measured against the raw 24-bit pixel data of the image so
+ *      that every stage is reported on the same scale
+ ************************/
+static Stage_Summary summarize(Bench_Case *bc, Stage stage, int reps)
+{
+        Stage_Summary summary = { 0, 0, 0, 0, 0 };
+        double *samples = bc->samples[stage];
+        double raw_bytes = 3.0 * bc->size.width * bc->size.height;
+
+        summary.min_ns = samples[0];
+        for (int rep = 0; rep < reps; rep++) {
+                summary.mean_ns += samples[rep];
+                if (samples[rep] < summary.min_ns) {
+                        summary.min_ns = samples[rep];
+                }
+        }
+        summary.mean_ns /= reps;
+
+        for (int rep = 0; rep < reps && reps > 1; rep++) {
+                double diff = samples[rep] - summary.mean_ns;
+                summary.stddev_ns += diff * diff / (reps - 1);
+        }
+        summary.stddev_ns = sqrt(summary.stddev_ns);
+
+        summary.mb_per_s = raw_bytes / 1e6 / (summary.mean_ns / NS_PER_SEC);
+        summary.ns_per_block = summary.mean_ns / bc->num_blocks;
+        return summary;
+}
+
+
+/********** report_case **********
+ *
+ * Prints the results of a finished case as a table on stdout, and as JSON
+ * objects on json (if non-NULL)
+ *
+ ************************/
+static void report_case(Bench_Case *bc, int reps, FILE *json, bool *first)
+{
+        printf("%-8s %5ux%-5u  %-13s %12s %9s %10s %10s\n",
+               pattern_names[bc->pattern], bc->size.width, bc->size.height,
+               "stage", "mean(ms)", "stddev%", "MB/s", "ns/block");
+
+        for (int stage = 0; stage < NUM_STAGES; stage++) {
+                Stage_Summary s = summarize(bc, stage, reps);
+                printf("%-20s %-13s %12.3f %9.2f %10.1f %10.2f\n", "",
+                       stage_names[stage], s.mean_ns / 1e6,
+                       100.0 * s.stddev_ns / s.mean_ns, s.mb_per_s,
+                       s.ns_per_block);
+
+                if (json == NULL) {
+                        continue;
+                }
+                fprintf(json, "%s    { \"pattern\": \"%s\", \"width\": %u, "
+                        "\"height\": %u, \"stage\": \"%s\", "
+                        "\"mean_ns\": %.0f, \"stddev_ns\": %.0f, "
+                        "\"min_ns\": %.0f, \"mb_per_s\": %.3f, "
+                        "\"ns_per_block\": %.3f }",
+                        *first ? "" : ",\n", pattern_names[bc->pattern],
+                        bc->size.width, bc->size.height, stage_names[stage],
+                        s.mean_ns, s.stddev_ns, s.min_ns, s.mb_per_s,
+                        s.ns_per_block);
+                *first = false;
+        }
+        printf("\n");
+}
+
+
+/********** write_kernels **********
+ *
+ * Writes, as JSON members, the Bitpack40 kernels (packing/unpacking)
+ * that actually run for the codeword layout when each one is asked for,
+ * so that rows timed on a CPU without AVX2 or BMI2 are recognizable as
+ * scalar
+ *
+ ************************/
+static void write_kernels(FILE *json)
+{
+        static const Bitpack40_Kernel kernels[] = {
+                BITPACK40_AUTO, BITPACK40_SCALAR, BITPACK40_AVX2,
+                BITPACK40_BMI2
+        };
+        static const char *names[] = { "auto", "scalar", "avx2", "bmi2" };
+        Bitpack40_Layout layout = codeword_layout();
+
+        for (int k = 0; k < 4; k++) {
+                Bitpack40_use_kernel(kernels[k]);
+                fprintf(json, "%s\"%s\": \"%s/%s\"", k == 0 ? "" : ", ",
+                        names[k], Bitpack40_kernel(&layout, false),
+                        Bitpack40_kernel(&layout, true));
+        }
+        Bitpack40_use_kernel(BITPACK40_AUTO);
+}
+
+
+/********** run_case **********
+ *
+ * Generates the image for one pattern and size, runs reps encode/decode
+ * repetitions over it, and reports the results
+ *
+ ************************/
+static void run_case(Pattern pattern, Size size, int reps, FILE *json,
+                     bool *first)
+{
+        Bench_Case *bc;
+        NEW(bc);
+        bc->pattern = pattern;
+        bc->size = size;
+        bc->num_blocks = (size_t) (size.width / BLOCKSIZE)
+                         * (size.height / BLOCKSIZE);
+
+        /* write the generated image out so that reading it is timed too */
+        Pnm_ppm image = generate_image(pattern, size);
+        bc->ppm_file = tmpfile();
+        bc->comp_file = tmpfile();
+        bc->sink = fopen("/dev/null", "w");
+        assert(bc->ppm_file != NULL && bc->comp_file != NULL
+               && bc->sink != NULL);
+        Pnm_ppmwrite(bc->ppm_file, image);
+        fflush(bc->ppm_file);
+
+        bc->blocks = ALLOC(bc->num_blocks * sizeof(*bc->blocks));
+        bc->words = ALLOC(bc->num_blocks * sizeof(*bc->words));
+        bc->fields = ALLOC(bc->num_blocks * NUM_CODEWORD_ELEMENTS
+                           * sizeof(*bc->fields));
+        bc->bulk_words = ALLOC(bc->num_blocks * sizeof(*bc->bulk_words));
+        bc->unpacked = ALLOC(bc->num_blocks * NUM_CODEWORD_ELEMENTS
+                             * sizeof(*bc->unpacked));
+        bc->decoded = image;
+
+        for (int rep = 0; rep < reps; rep++) {
+                run_encode(bc, rep);
+                run_decode(bc, rep);
+        }
+        report_case(bc, reps, json, first);
+
+        fclose(bc->ppm_file);
+        fclose(bc->comp_file);
+        fclose(bc->sink);
+        FREE(bc->blocks);
+        FREE(bc->words);
+        FREE(bc->fields);
+        FREE(bc->bulk_words);
+        FREE(bc->unpacked);
+        Pnm_ppmfree(&image);
+        FREE(bc);
+}
+
+
+/******************************************************************************
+ *
+ *                          VERIFICATION
+ *
+ *****************************************************************************/
+
+
+/********** Verify_Result **********
+ *
+ * struct to hold the largest float/fixed differences found in one image
+ *
+ * Contains:
+ *      size_t blocks, differing
+ *          blocks checked, and blocks whose two codewords differ
+ *
+ *      int64_t field[NUM_CODEWORD_ELEMENTS]
+ *          largest difference in each codeword field (a, b, c, d, and the
+ *          two chroma indices)
+ *
+ *      int64_t channel
+ *          largest difference in a decoded channel, decoding the same
+ *          codeword both ways
+ *
+ ************************/
+typedef struct Verify_Result {
+        size_t blocks;
+        size_t differing;
+        int64_t field[NUM_CODEWORD_ELEMENTS];
+        int64_t channel;
+} Verify_Result;
+
+
+/********** note_difference **********
+ *
+ * Raises *worst to |a - b| if that is larger
+ *
+ ************************/
+static void note_difference(int64_t *worst, int64_t a, int64_t b)
+{
+        int64_t diff = a > b ? a - b : b - a;
+        if (diff > *worst) {
+                *worst = diff;
+        }
+}
+
+
+/********** verify_image **********
+ *
+ * Codes every block of image with both paths and records how far apart
+ * the results are
+ *
+ ************************/
+static void verify_image(Pnm_ppm image, Verify_Result *result)
+{
+        size_t num_blocks = (size_t) (image->width / BLOCKSIZE)
+                            * (image->height / BLOCKSIZE);
+        Pnm_rgb pixels[BLOCKAREA];
+        struct Pnm_rgb float_out[BLOCKAREA], fixed_out[BLOCKAREA];
+        Pnm_rgb float_pixels[BLOCKAREA], fixed_pixels[BLOCKAREA];
+
+        memset(result, 0, sizeof(*result));
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                float_pixels[block_i] = &float_out[block_i];
+                fixed_pixels[block_i] = &fixed_out[block_i];
+        }
+
+        for (size_t i = 0; i < num_blocks; i++) {
+                block_pixels(image, i, pixels);
+                uint32_t float_word = Codec40_encode_block(pixels,
+                                                           image->denominator);
+                uint32_t fixed_word = Fixed40_encode_block(pixels,
+                                                           image->denominator);
+
+                CodeWord_Element float_elems[NUM_CODEWORD_ELEMENTS] = {
+                        CODEWORD_A, CODEWORD_B, CODEWORD_C,
+                        CODEWORD_D, CODEWORD_PB, CODEWORD_PR
+                };
+                CodeWord_Element fixed_elems[NUM_CODEWORD_ELEMENTS] = {
+                        CODEWORD_A, CODEWORD_B, CODEWORD_C,
+                        CODEWORD_D, CODEWORD_PB, CODEWORD_PR
+                };
+                extract_bitpack(float_word, float_elems);
+                extract_bitpack(fixed_word, fixed_elems);
+                for (int f = 0; f < NUM_CODEWORD_ELEMENTS; f++) {
+                        note_difference(&result->field[f],
+                                        float_elems[f].value,
+                                        fixed_elems[f].value);
+                }
+                result->differing += float_word != fixed_word;
+
+                Codec40_decode_block(float_word, image->denominator,
+                                     float_pixels);
+                Fixed40_decode_block(float_word, image->denominator,
+                                     fixed_pixels);
+                for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                        note_difference(&result->channel,
+                                        float_out[block_i].red,
+                                        fixed_out[block_i].red);
+                        note_difference(&result->channel,
+                                        float_out[block_i].green,
+                                        fixed_out[block_i].green);
+                        note_difference(&result->channel,
+                                        float_out[block_i].blue,
+                                        fixed_out[block_i].blue);
+                }
+        }
+        result->blocks = num_blocks;
+}
+
+
+/********** report_verify **********
+ *
+ * Prints one row of verification results
+ *
+ * Return:
+ *      true if every difference is within bounds
+ ************************/
+static bool report_verify(const char *name, Pnm_ppm image,
+                          Verify_Result *result)
+{
+        /* the fixed path decodes through Q16, which is finer than one
+         * step of an 8-bit image but not of a 16-bit one */
+        int64_t step = (image->denominator + VERIFY_STEP_LEVELS - 1)
+                       / VERIFY_STEP_LEVELS;
+        bool ok = result->channel <= VERIFY_MAX_CHANNEL * step;
+        for (int f = 0; f < NUM_CODEWORD_ELEMENTS; f++) {
+                ok = ok && result->field[f] <= VERIFY_MAX_FIELD;
+        }
+
+        printf("%-24s %5ux%-5u %9.4f%% %3" PRId64 " %3" PRId64 " %3" PRId64
+               " %3" PRId64 " %3" PRId64 " %3" PRId64 " %7" PRId64 "  %s\n",
+               name, image->width, image->height,
+               result->blocks == 0 ? 0.0
+                                   : 100.0 * result->differing
+                                     / result->blocks,
+               result->field[0], result->field[1], result->field[2],
+               result->field[3], result->field[4], result->field[5],
+               result->channel, ok ? "ok" : "FAIL");
+        return ok;
+}
+
+
+/********** verify_files **********
+ *
+ * Runs verification over the selected synthetic images and the named PPM
+ * files
+ *
+ * Return:
+ *      EXIT_SUCCESS if every image is within bounds, else EXIT_FAILURE
+ ************************/
+static int verify_files(bool patterns[NUM_PATTERNS], bool any_pattern,
+                        Size sizes[], int num_sizes, int num_files,
+                        char *files[])
+{
+        bool ok = true;
+        Verify_Result result;
+
+        printf("%-24s %-11s %10s %3s %3s %3s %3s %3s %3s %7s\n", "image",
+               "size", "differing", "a", "b", "c", "d", "pb", "pr",
+               "channel");
+
+        for (int p = 0; p < NUM_PATTERNS && num_files == 0; p++) {
+                if (any_pattern && !patterns[p]) {
+                        continue;
+                }
+                for (int s = 0; s < num_sizes; s++) {
+                        Pnm_ppm image = generate_image(p, sizes[s]);
+                        verify_image(image, &result);
+                        ok = report_verify(pattern_names[p], image, &result)
+                             && ok;
+                        Pnm_ppmfree(&image);
+                }
+        }
+
+        for (int i = 0; i < num_files; i++) {
+                FILE *fp = fopen(files[i], "rb");
+                if (fp == NULL) {
+                        perror(files[i]);
+                        ok = false;
+                        continue;
+                }
+                Pnm_ppm image = Pnm40_read_ppm(fp, uarray2_methods_plain);
+                fclose(fp);
+                Codec40_trim(image);
+                verify_image(image, &result);
+                ok = report_verify(files[i], image, &result) && ok;
+                Pnm_ppmfree(&image);
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/********** usage **********
+ *
+ * Prints the command line usage and exits with failure
+ *
+ ************************/
+static void usage(const char *progname)
+{
+        fprintf(stderr, "Usage: %s [-r reps] [-s WIDTHxHEIGHT]... "
+                "[-p noise|gradient|flat|photo]... [-o results.json]\n"
+                "       %s -V [-s WIDTHxHEIGHT]... [-p pattern]... "
+                "[image.ppm...]\n",
+                progname, progname);
+        exit(1);
+}
+
+
+/********** main **********
+ *
+ * Parses the command line, then benchmarks every selected pattern at every
+ * selected size
+ *
+ * Notes:
+ *      Sizes are rounded down to even dimensions, since the codec trims odd
+ *      rows and columns before compressing anyway
+ ************************/
+int main(int argc, char *argv[])
+{
+        int reps = DEFAULT_REPS;
+        Size sizes[MAX_SIZES];
+        int num_sizes = 0;
+        bool patterns[NUM_PATTERNS] = { false };
+        bool any_pattern = false;
+        const char *json_path = NULL;
+        bool verify = false;
+        char **files = ALLOC(argc * sizeof(char *));
+        int num_files = 0;
+
+        for (int i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                        reps = atoi(argv[++i]);
+                        if (reps < 1 || reps > MAX_REPS) {
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+                        Size *size = &sizes[num_sizes];
+                        if (num_sizes == MAX_SIZES
+                            || sscanf(argv[++i], "%ux%u", &size->width,
+                                      &size->height) != 2
+                            || size->width < 2 || size->height < 2) {
+                                usage(argv[0]);
+                        }
+                        size->width &= ~1u;
+                        size->height &= ~1u;
+                        num_sizes++;
+                } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+                        int p;
+                        i++;
+                        for (p = 0; p < NUM_PATTERNS; p++) {
+                                if (strcmp(argv[i], pattern_names[p]) == 0) {
+                                        break;
+                                }
+                        }
+                        if (p == NUM_PATTERNS) {
+                                usage(argv[0]);
+                        }
+                        patterns[p] = any_pattern = true;
+                } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+                        json_path = argv[++i];
+                } else if (strcmp(argv[i], "-V") == 0) {
+                        verify = true;
+                } else if (argv[i][0] != '-') {
+                        files[num_files++] = argv[i];
+                } else {
+                        usage(argv[0]);
+                }
+        }
+
+        if (num_sizes == 0) {
+                num_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+                memcpy(sizes, default_sizes, sizeof(default_sizes));
+        }
+        if (verify) {
+                int status = verify_files(patterns, any_pattern, sizes,
+                                          num_sizes, num_files, files);
+                FREE(files);
+                return status;
+        }
+        if (num_files > 0) {
+                usage(argv[0]);
+        }
+        FREE(files);
+
+        FILE *json = NULL;
+        if (json_path != NULL) {
+                json = fopen(json_path, "w");
+                assert(json != NULL);
+                fprintf(json, "{\n  \"benchmark\": \"bench40\",\n"
+                        "  \"format\": 1,\n  \"timestamp\": %ld,\n"
+                        "  \"compiler\": \"%s\",\n  \"reps\": %d,\n"
+                        "  \"bitpack_kernels\": { ",
+                        (long) time(NULL), __VERSION__, reps);
+                write_kernels(json);
+                fprintf(json, " },\n  \"results\": [\n");
+        }
+
+        bool first = true;
+        for (int p = 0; p < NUM_PATTERNS; p++) {
+                if (any_pattern && !patterns[p]) {
+                        continue;
+                }
+                for (int s = 0; s < num_sizes; s++) {
+                        run_case(p, sizes[s], reps, json, &first);
+                }
+        }
+
+        if (json != NULL) {
+                fprintf(json, "\n  ]\n}\n");
+                fclose(json);
+        }
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,574 @@
+/**************************************************************
+*
+*                     bitpack40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       bitpack40.c implements the batched Bitpack interface. Each call
+*       checks its layout once and turns every field into a mask, a
+*       shift, and a bias, so the per-word work is masks, shifts, ors,
+*       and one compare per value for overflow:
+*
+*               value fits  <=>  (value + bias) & ~mask == 0
+*
+*       where bias is 2^(width - 1) for signed fields and 0 otherwise.
+*       Sign extension on unpacking is (x ^ bias) - bias.
+*
+*       There are three kernels, picked per call:
+*
+*         - scalar: one word and one field at a time; runs anywhere
+*         - avx2:   the scalar steps on four words at once in 256-bit
+*                   vectors
+*         - bmi2:   moves all the fields of a word at once. pext
+*                   gathers the fields' bits to the bottom of the word,
+*                   and pdep spreads them into four 16-bit lanes, so a
+*                   codeword's six fields take one pext and two pdeps;
+*                   packing runs the same steps backwards. Signed lanes
+*                   are extended all together (see sign_extend_lanes).
+*
+*       Only x86-64 builds have the avx2 and bmi2 kernels, and each is
+*       used only if CPUID says the CPU has the instructions. All three
+*       give the same results.
+*
+**************************************************************/
+#include "bitpack40.h"
+
+#include "assert.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BITPACK40_X86 1
+#include <immintrin.h>
+#else
+#define BITPACK40_X86 0
+#endif
+
+#define LANES 4
+#define LANE_BITS 16
+#define MAX_GROUPS ((BITPACK40_MAX_FIELDS + LANES - 1) / LANES)
+
+/********** Field_Plan **********
+ *
+ * struct to hold one field of a layout in the form the kernels use
+ *
+ * Contains:
+ *      uint64_t mask  - width low bits set
+ *      uint64_t bias  - 2^(width - 1) if the field is signed, else 0
+ *      unsigned lsb   - the field's shift
+ *
+ ************************/
+typedef struct Field_Plan {
+        uint64_t mask;
+        uint64_t bias;
+        unsigned lsb;
+} Field_Plan;
+
+/********** Lane_Group **********
+ *
+ * struct to hold up to four fields, adjacent in lsb order, that the bmi2
+ * kernel moves between a word and four 16-bit lanes with one pdep or pext
+ *
+ * Contains:
+ *      uint64_t lanes     - the low width bits of each field's lane
+ *      uint64_t bias      - each signed field's bias, in its lane
+ *      unsigned width     - the fields' total width
+ *      unsigned count     - how many fields (lanes) are used
+ *      unsigned field[]   - the layout index of the field in each lane
+ *
+ ************************/
+typedef struct Lane_Group {
+        uint64_t lanes;
+        uint64_t bias;
+        unsigned width;
+        unsigned count;
+        unsigned field[LANES];
+} Lane_Group;
+
+/********** Layout_Plan **********
+ *
+ * struct to hold a checked layout ready for the kernels
+ *
+ * Contains:
+ *      unsigned num_fields, Field_Plan fields[]
+ *          every field, in layout order
+ *
+ *      bool narrow
+ *          whether every field fits a 16-bit lane with its top bit to
+ *          spare (see sign_extend_lanes) and no two overlap, which the
+ *          bmi2 kernel needs
+ *
+ *      uint64_t used
+ *          every bit that belongs to a field
+ *
+ *      unsigned num_groups, Lane_Group groups[]
+ *          the fields in lsb order, four to a group (when narrow)
+ *
+ ************************/
+typedef struct Layout_Plan {
+        unsigned num_fields;
+        Field_Plan fields[BITPACK40_MAX_FIELDS];
+        bool narrow;
+        uint64_t used;
+        unsigned num_groups;
+        Lane_Group groups[MAX_GROUPS];
+} Layout_Plan;
+
+static Bitpack40_Kernel selected = BITPACK40_AUTO;
+
+static const char *kernel_names[] = { "auto", "scalar", "avx2", "bmi2" };
+
+
+/********** plan_groups **********
+ *
+ * Sorts the fields of a narrow layout by lsb and deals them out into
+ * lane groups; clears plan->narrow if two fields overlap
+ *
+ ************************/
+static void plan_groups(Layout_Plan *plan)
+{
+        unsigned order[BITPACK40_MAX_FIELDS];
+        for (unsigned f = 0; f < plan->num_fields; f++) {
+                unsigned i = f;
+                while (i > 0 && plan->fields[order[i - 1]].lsb
+                                > plan->fields[f].lsb) {
+                        order[i] = order[i - 1];
+                        i--;
+                }
+                order[i] = f;
+        }
+
+        plan->used = 0;
+        plan->num_groups = (plan->num_fields + LANES - 1) / LANES;
+        for (unsigned i = 0; i < plan->num_fields; i++) {
+                Field_Plan *field = &plan->fields[order[i]];
+                uint64_t bits = field->mask << field->lsb;
+                if ((plan->used & bits) != 0) {
+                        plan->narrow = false;
+                        return;
+                }
+                plan->used |= bits;
+
+                Lane_Group *group = &plan->groups[i / LANES];
+                unsigned lane = i % LANES;
+                if (lane == 0) {
+                        group->lanes = group->bias = 0;
+                        group->width = group->count = 0;
+                }
+                group->lanes |= field->mask << (lane * LANE_BITS);
+                group->bias |= field->bias << (lane * LANE_BITS);
+                group->width += __builtin_popcountll(field->mask);
+                group->field[lane] = order[i];
+                group->count++;
+        }
+}
+
+
+/********** plan_layout **********
+ *
+ * Checks every field of layout and fills in its plan
+ *
+ * Expects:
+ *      CRE if layout has more than BITPACK40_MAX_FIELDS fields, or a
+ *      field with width 0 or reaching past bit 63
+ ************************/
+static void plan_layout(const Bitpack40_Layout *layout, Layout_Plan *plan)
+{
+        assert(layout != NULL);
+        assert(layout->num_fields <= BITPACK40_MAX_FIELDS);
+
+        plan->num_fields = layout->num_fields;
+        plan->narrow = true;
+        for (unsigned f = 0; f < layout->num_fields; f++) {
+                Bitpack40_Field field = layout->fields[f];
+                assert(field.width >= 1 && field.width <= 64);
+                assert(field.width + field.lsb <= 64);
+
+                plan->fields[f].mask = field.width == 64
+                                       ? ~(uint64_t) 0
+                                       : ((uint64_t) 1 << field.width) - 1;
+                plan->fields[f].bias = field.isSigned
+                                       ? (uint64_t) 1 << (field.width - 1)
+                                       : 0;
+                plan->fields[f].lsb = field.lsb;
+                if (field.width >= LANE_BITS) {
+                        plan->narrow = false;
+                }
+        }
+        if (plan->narrow) {
+                plan_groups(plan);
+        }
+}
+
+
+/********** pack_scalar **********
+ *
+ * Packs words first through n - 1, returning the number of overflows
+ *
+ ************************/
+static size_t pack_scalar(const Layout_Plan *plan, const int64_t *values,
+                          uint64_t *words, size_t first, size_t n)
+{
+        unsigned num_fields = plan->num_fields;
+        size_t overflows = 0;
+
+        for (size_t i = first; i < n; i++) {
+                const int64_t *row = &values[i * num_fields];
+                uint64_t word = 0;
+                for (unsigned f = 0; f < num_fields; f++) {
+                        const Field_Plan *field = &plan->fields[f];
+                        uint64_t value = row[f];
+                        overflows += ((value + field->bias)
+                                      & ~field->mask) != 0;
+                        word |= (value & field->mask) << field->lsb;
+                }
+                words[i] = word;
+        }
+        return overflows;
+}
+
+
+/********** unpack_scalar **********
+ *
+ * Unpacks words first through n - 1
+ *
+ ************************/
+static void unpack_scalar(const Layout_Plan *plan, const uint64_t *words,
+                          int64_t *values, size_t first, size_t n)
+{
+        unsigned num_fields = plan->num_fields;
+
+        for (size_t i = first; i < n; i++) {
+                int64_t *row = &values[i * num_fields];
+                for (unsigned f = 0; f < num_fields; f++) {
+                        const Field_Plan *field = &plan->fields[f];
+                        uint64_t x = words[i] >> field->lsb & field->mask;
+                        row[f] = (x ^ field->bias) - field->bias;
+                }
+        }
+}
+
+
+#if BITPACK40_X86
+
+typedef uint64_t Lanes __attribute__((vector_size(LANES * sizeof(uint64_t))));
+typedef int64_t Flags __attribute__((vector_size(LANES * sizeof(int64_t))));
+
+
+/********** pack_avx2 **********
+ *
+ * Packs LANES words at a time, returning how many words it packed in
+ * *done and the number of overflows among them
+ *
+ ************************/
+__attribute__((target("avx2")))
+static size_t pack_avx2(const Layout_Plan *plan, const int64_t *values,
+                        uint64_t *words, size_t n, size_t *done)
+{
+        unsigned num_fields = plan->num_fields;
+        Flags overflows = { 0, 0, 0, 0 };
+        size_t i = 0;
+
+        for (; i + LANES <= n; i += LANES) {
+                const int64_t *rows = &values[i * num_fields];
+                Lanes word = { 0, 0, 0, 0 };
+                for (unsigned f = 0; f < num_fields; f++) {
+                        const Field_Plan *field = &plan->fields[f];
+                        Lanes value = { rows[f],
+                                        rows[num_fields + f],
+                                        rows[2 * num_fields + f],
+                                        rows[3 * num_fields + f] };
+                        /* a true compare is -1 in its lane */
+                        overflows -= ((value + field->bias)
+                                      & ~field->mask) != 0;
+                        word |= (value & field->mask) << field->lsb;
+                }
+                __builtin_memcpy(&words[i], &word, sizeof(word));
+        }
+
+        *done = i;
+        return overflows[0] + overflows[1] + overflows[2] + overflows[3];
+}
+
+
+/********** unpack_avx2 **********
+ *
+ * Unpacks LANES words at a time, returning how many words it unpacked
+ *
+ ************************/
+__attribute__((target("avx2")))
+static size_t unpack_avx2(const Layout_Plan *plan, const uint64_t *words,
+                          int64_t *values, size_t n)
+{
+        unsigned num_fields = plan->num_fields;
+        size_t i = 0;
+
+        for (; i + LANES <= n; i += LANES) {
+                Lanes word;
+                __builtin_memcpy(&word, &words[i], sizeof(word));
+                int64_t *rows = &values[i * num_fields];
+                for (unsigned f = 0; f < num_fields; f++) {
+                        const Field_Plan *field = &plan->fields[f];
+                        Lanes x = word >> field->lsb & field->mask;
+                        x = (x ^ field->bias) - field->bias;
+                        for (int lane = 0; lane < LANES; lane++) {
+                                rows[lane * num_fields + f] = x[lane];
+                        }
+                }
+        }
+        return i;
+}
+
+
+/********** sign_extend_lanes **********
+ *
+ * Sign-extends every lane of a group to 16 bits at once. Setting each
+ * lane's top bit first keeps the subtraction from borrowing across
+ * lanes, and flipping it back afterwards leaves (x ^ bias) - bias in
+ * every lane. That needs the top bit clear to begin with, so the bmi2
+ * kernel only takes fields of up to 15 bits.
+ *
+ ************************/
+static inline uint64_t sign_extend_lanes(uint64_t lanes, uint64_t bias)
+{
+        const uint64_t top = 0x8000800080008000;
+        return (((lanes ^ bias) | top) - bias) ^ top;
+}
+
+
+/********** pack_bmi2 **********
+ *
+ * Packs every word with pdep and pext, returning the number of overflows
+ *
+ ************************/
+__attribute__((target("bmi2")))
+static size_t pack_bmi2(const Layout_Plan *plan, const int64_t *values,
+                        uint64_t *words, size_t n)
+{
+        unsigned num_fields = plan->num_fields;
+        size_t overflows = 0;
+
+        for (size_t i = 0; i < n; i++) {
+                const int64_t *row = &values[i * num_fields];
+                uint64_t packed = 0;
+                unsigned shift = 0;
+                for (unsigned g = 0; g < plan->num_groups; g++) {
+                        const Lane_Group *group = &plan->groups[g];
+                        uint64_t lanes = 0;
+                        for (unsigned lane = 0; lane < group->count; lane++) {
+                                unsigned f = group->field[lane];
+                                uint64_t value = row[f];
+                                overflows += ((value + plan->fields[f].bias)
+                                              & ~plan->fields[f].mask) != 0;
+                                lanes |= (value & 0xffff)
+                                         << (lane * LANE_BITS);
+                        }
+                        packed |= _pext_u64(lanes, group->lanes) << shift;
+                        shift += group->width;
+                }
+                words[i] = _pdep_u64(packed, plan->used);
+        }
+        return overflows;
+}
+
+
+/********** unpack_bmi2 **********
+ *
+ * Unpacks every word with pext and pdep
+ *
+ ************************/
+__attribute__((target("bmi2")))
+static void unpack_bmi2(const Layout_Plan *plan, const uint64_t *words,
+                        int64_t *values, size_t n)
+{
+        unsigned num_fields = plan->num_fields;
+
+        for (size_t i = 0; i < n; i++) {
+                int64_t *row = &values[i * num_fields];
+                uint64_t packed = _pext_u64(words[i], plan->used);
+                for (unsigned g = 0; g < plan->num_groups; g++) {
+                        const Lane_Group *group = &plan->groups[g];
+                        uint64_t lanes = _pdep_u64(packed, group->lanes);
+                        lanes = sign_extend_lanes(lanes, group->bias);
+                        packed >>= group->width;
+                        for (unsigned lane = 0; lane < group->count; lane++) {
+                                row[group->field[lane]] = (int16_t)
+                                        (lanes >> (lane * LANE_BITS));
+                        }
+                }
+        }
+}
+
+#endif
+
+
+/********** choose_kernel **********
+ *
+ * Returns the kernel a call with plan will run: the selected one if this
+ * CPU and layout allow it, otherwise scalar. AUTO prefers avx2, then
+ * bmi2 for unpacking only: its packing loses to the scalar loop, since
+ * the overflow checks and building the lanes are still per field.
+ *
+ ************************/
+static Bitpack40_Kernel choose_kernel(const Layout_Plan *plan, bool unpacking)
+{
+#if BITPACK40_X86
+        bool avx2 = __builtin_cpu_supports("avx2");
+        bool bmi2 = __builtin_cpu_supports("bmi2") && plan->narrow;
+
+        switch (selected) {
+        case BITPACK40_AUTO:
+                if (avx2) {
+                        return BITPACK40_AVX2;
+                }
+                return bmi2 && unpacking ? BITPACK40_BMI2 : BITPACK40_SCALAR;
+        case BITPACK40_AVX2:
+                return avx2 ? BITPACK40_AVX2 : BITPACK40_SCALAR;
+        case BITPACK40_BMI2:
+                return bmi2 ? BITPACK40_BMI2 : BITPACK40_SCALAR;
+        default:
+                return BITPACK40_SCALAR;
+        }
+#else
+        (void)plan;
+        (void)unpacking;
+        return BITPACK40_SCALAR;
+#endif
+}
+
+
+/********** Bitpack40_pack **********
+ *
+ * Packs an array of words from their field values
+ *
+ * Parameters:
+ *      const Bitpack40_Layout *layout - The fields of each word
+ *      const int64_t *values          - n rows of layout->num_fields
+ *                                       values, in layout order
+ *      uint64_t *words                - Where the n words are written
+ *      size_t n                       - Number of words
+ *
+ * Return:
+ *      The number of values that did not fit their field
+ *
+ * Expects:
+ *      layout is non-null and valid (see plan_layout)
+ *      values and words are non-null when n > 0
+ *
+ * Notes:
+ *      A value that does not fit is truncated to its field's low bits,
+ *      like Bitpack_newu would store it, rather than raising
+ *      Bitpack_Overflow. Bits outside every field are zero.
+ ************************/
+size_t Bitpack40_pack(const Bitpack40_Layout *layout, const int64_t *values,
+                      uint64_t *words, size_t n)
+{
+        Layout_Plan plan;
+        plan_layout(layout, &plan);
+        assert(n == 0 || (values != NULL && words != NULL));
+
+        size_t done = 0;
+        size_t overflows = 0;
+#if BITPACK40_X86
+        switch (choose_kernel(&plan, false)) {
+        case BITPACK40_AVX2:
+                overflows = pack_avx2(&plan, values, words, n, &done);
+                break;
+        case BITPACK40_BMI2:
+                return pack_bmi2(&plan, values, words, n);
+        default:
+                break;
+        }
+#endif
+        return overflows + pack_scalar(&plan, values, words, done, n);
+}
+
+
+/********** Bitpack40_unpack **********
+ *
+ * Unpacks an array of words into their field values
+ *
+ * Parameters:
+ *      const Bitpack40_Layout *layout - The fields of each word
+ *      const uint64_t *words          - The n words
+ *      int64_t *values                - Where n rows of
+ *                                       layout->num_fields values go
+ *      size_t n                       - Number of words
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      layout is non-null and valid (see plan_layout)
+ *      values and words are non-null when n > 0
+ *
+ * Notes:
+ *      Signed fields are sign-extended, as by Bitpack_gets; unsigned
+ *      fields come back as Bitpack_getu would return them
+ ************************/
+void Bitpack40_unpack(const Bitpack40_Layout *layout, const uint64_t *words,
+                      int64_t *values, size_t n)
+{
+        Layout_Plan plan;
+        plan_layout(layout, &plan);
+        assert(n == 0 || (values != NULL && words != NULL));
+
+        size_t done = 0;
+#if BITPACK40_X86
+        switch (choose_kernel(&plan, true)) {
+        case BITPACK40_AVX2:
+                done = unpack_avx2(&plan, words, values, n);
+                break;
+        case BITPACK40_BMI2:
+                unpack_bmi2(&plan, words, values, n);
+                return;
+        default:
+                break;
+        }
+#endif
+        unpack_scalar(&plan, words, values, done, n);
+}
+
+
+/********** Bitpack40_use_kernel **********
+ *
+ * Selects the kernel later calls use
+ *
+ * Parameters:
+ *      Bitpack40_Kernel kernel - The kernel, or BITPACK40_AUTO
+ *
+ * Return:
+ *      None
+ *
+ * Notes:
+ *      A kernel this CPU or a call's layout cannot use falls back to
+ *      scalar for that call
+ ************************/
+void Bitpack40_use_kernel(Bitpack40_Kernel kernel)
+{
+        assert(kernel >= BITPACK40_AUTO && kernel <= BITPACK40_BMI2);
+        selected = kernel;
+}
+
+
+/********** Bitpack40_kernel **********
+ *
+ * Names the kernel calls with layout will use
+ *
+ * Parameters:
+ *      const Bitpack40_Layout *layout - The layout
+ *      bool unpacking                 - Whether for Bitpack40_unpack
+ *                                       rather than Bitpack40_pack
+ *
+ * Return:
+ *      "scalar", "avx2", or "bmi2"
+ *
+ * Expects:
+ *      layout is non-null and valid (see plan_layout)
+ ************************/
+const char *Bitpack40_kernel(const Bitpack40_Layout *layout, bool unpacking)
+{
+        Layout_Plan plan;
+        plan_layout(layout, &plan);
+        return kernel_names[choose_kernel(&plan, unpacking)];
+}
@@ -0,0 +1,92 @@
+/**************************************************************
+*
+*                     bitpack40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       bitpack40.h declares the batched companion to the Bitpack
+*       interface. A layout describing every field of a word is given
+*       once, and whole arrays of words are packed or unpacked per
+*       call. Values that do not fit their field are counted instead of
+*       raising Bitpack_Overflow one at a time.
+*
+*       There are scalar, AVX2, and BMI2 (pdep/pext) kernels, chosen
+*       when called from what the CPU supports.
+*
+**************************************************************/
+#ifndef BITPACK40_INCLUDED
+#define BITPACK40_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BITPACK40_MAX_FIELDS 16
+
+/********** Bitpack40_Field **********
+ *
+ * struct to hold one field of a layout
+ *
+ * Contains:
+ *      unsigned width - bits in the field, 1 to 64
+ *      unsigned lsb   - position of its least significant bit
+ *      bool isSigned  - whether it holds a two's complement value
+ *
+ ************************/
+typedef struct Bitpack40_Field {
+        unsigned width;
+        unsigned lsb;
+        bool isSigned;
+} Bitpack40_Field;
+
+/********** Bitpack40_Layout **********
+ *
+ * struct to hold the fields of a word, in the order values are given
+ *
+ ************************/
+typedef struct Bitpack40_Layout {
+        unsigned num_fields;
+        Bitpack40_Field fields[BITPACK40_MAX_FIELDS];
+} Bitpack40_Layout;
+
+/*
+ * Packs n words. values holds n rows of num_fields values, one per field
+ * in layout order (unsigned fields take the value's bits as uint64_t).
+ * Bits outside every field are zero. A value that does not fit is
+ * truncated to its field; the number of those is returned.
+ */
+extern size_t Bitpack40_pack(const Bitpack40_Layout *layout,
+                             const int64_t *values, uint64_t *words,
+                             size_t n);
+
+/* the inverse: n words out to n rows of field values, sign-extended */
+extern void Bitpack40_unpack(const Bitpack40_Layout *layout,
+                             const uint64_t *words, int64_t *values,
+                             size_t n);
+
+/********** Bitpack40_Kernel **********
+ *
+ * the implementations a call can use. AUTO picks the fastest one the CPU
+ * supports for the direction; any other choice falls back to SCALAR
+ * where it cannot run.
+ * BMI2 only takes layouts whose fields are at most 15 bits wide and do
+ * not overlap.
+ *
+ ************************/
+typedef enum Bitpack40_Kernel {
+        BITPACK40_AUTO = 0,
+        BITPACK40_SCALAR,
+        BITPACK40_AVX2,
+        BITPACK40_BMI2
+} Bitpack40_Kernel;
+
+/* selects the kernel for later calls (default BITPACK40_AUTO) */
+extern void Bitpack40_use_kernel(Bitpack40_Kernel kernel);
+
+/* "scalar", "avx2", or "bmi2": what packing (or unpacking) layout uses */
+extern const char *Bitpack40_kernel(const Bitpack40_Layout *layout,
+                                    bool unpacking);
+
+#endif
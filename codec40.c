@@ -0,0 +1,1761 @@
+/**************************************************************
+*
+*                     codec40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       codec40.c implements the per-block stages of the lossy image
+*       codec: RGB to component video conversion, the 2x2 discrete
+*       cosine transform, quantization, and codeword packing, along
+*       with their inverses for decompression, and reading and writing
+*       the compressed file format.
+*
+**************************************************************/
+#include "codec40.h"
+#include "fixed40.h"
+#include "bitpack.h"
+#include "assert.h"
+#include "arith40.h"
+#include "stats40.h"
+#include "mem.h"
+#include "a2plain.h"
+#include "a2methods.h"
+#include "a2parallel.h"
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#define A2 A2Methods_UArray2
+
+/********** Codec_Closure **********
+ *
+ * struct passed to the block apply functions and decode_row
+ *
+ * Contains:
+ *      Pnm_ppm image
+ *          the image being compressed (read) or decompressed (written)
+ *
+ *      A2 codewords
+ *          the codewords being decoded, or NULL when compressing
+ *
+ ************************/
+typedef struct Codec_Closure {
+        Pnm_ppm image;
+        A2 codewords;
+} Codec_Closure;
+
+/* whether blocks go through fixed40.c instead of the float stages */
+static bool fixed_point = false;
+
+static void applyCompress(int col, int row, A2 codewords, void *elem,
+                          void *cl);
+static void block_pixels(Pnm_ppm image, int col, int row,
+                         Pnm_rgb pixels[BLOCKAREA]);
+static void broadcast_pixels(Pnm_rgb start, size_t length);
+
+
+/******************************************************************************
+ * 
+ *     WHOLE-IMAGE COMPRESSION AND DECOMPRESSION
+ *
+ *****************************************************************************/
+
+
+/********** Codec40_trim **********
+ *
+ * Trims given PPM image so that its width and height are both even.
+ * If the image's width or height is odd, the image is trimmed by removing
+ * the last column and/or row
+ *
+ * Parameters:
+ *      Pnm_ppm image - Pointer to the Pnm_ppm image to be trimmed
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      image is non-null
+ *      CRE if image is NULL
+ *
+ * Notes:
+ *      Does nothing if the width and height are already even
+ *      Allocates a new pixel array with even values of width and height
+ *      Copies pixels to new pixel array without the last column and/or row
+ *      Frees the old pixel array
+ ************************/
+void Codec40_trim(Pnm_ppm image)
+{
+        
+        /* assert image is not NULL */
+        assert(image != NULL);
+
+        if (image->width % 2 == 0 && image->height % 2 == 0) {
+                return;
+        }
+
+        /* calculate new even width */
+        unsigned new_width;
+        if (image->width % 2 != 0) {
+                new_width = image->width - 1;
+        } else {
+                new_width = image->width;
+        }       
+        
+        /* calculate new even height */
+        unsigned new_height;
+        if (image->height % 2 != 0) {
+                new_height = image->height - 1;
+        } else {
+                new_height = image->height;
+        }
+
+        A2Methods_T methods = (A2Methods_T) image->methods;
+        A2Methods_UArray2 new_pixels = methods->new(new_width, new_height, 
+                                                    sizeof(struct Pnm_rgb));
+
+        /* copy image pixels to image of even new_width and new_height */
+        for (unsigned row = 0; row < new_height; row++) {
+            for (unsigned col = 0; col < new_width; col++) {
+
+                Pnm_rgb old_pixel = (Pnm_rgb) methods->at(image->pixels, col, 
+                                                          row);
+
+                Pnm_rgb new_pixel = (Pnm_rgb) methods->at(new_pixels, col, row);
+                *new_pixel = *old_pixel;
+
+            }
+        }
+
+        /* Free the old pixel array and update the image */
+        methods->free(&(image->pixels));
+        image->pixels = new_pixels;
+        image->width = new_width;
+        image->height = new_height;
+}
+
+
+/********** Codec40_encode **********
+ *
+ * Compresses every 2x2 block of an image into a 32-bit codeword
+ *
+ * Parameters:
+ *      Pnm_ppm image - The image to compress
+ *
+ * Return:
+ *      A new UArray2 of uint32_t codewords, one per block, that is
+ *      image->width / 2 wide and image->height / 2 tall
+ *
+ * Expects:
+ *      image is non-null and has even width and height
+ *      CRE if image is NULL or either dimension is odd
+ *
+ * Notes:
+ *      The caller frees the result with uarray2_methods_plain->free
+ *      Tile-sized bands of block rows are coded on the a2parallel.h
+ *      pool, which moves bands from busy workers to idle ones
+ ************************/
+A2 Codec40_encode(Pnm_ppm image)
+{
+        assert(image != NULL);
+        assert(image->width % BLOCKSIZE == 0 && image->height % BLOCKSIZE == 0);
+
+        A2Methods_T methods = uarray2_methods_plain;
+        A2 codewords = methods->new(image->width / BLOCKSIZE,
+                                    image->height / BLOCKSIZE,
+                                    sizeof(uint32_t));
+        Codec_Closure cl = { image, NULL };
+        void *cls[A2PARALLEL_MAX_WORKERS];
+        for (int w = 0; w < A2Parallel_workers(); w++) {
+                cls[w] = &cl;
+        }
+
+        uarray2_parallel_plain->map_row_major(codewords, applyCompress, cls);
+        return codewords;
+}
+
+
+/********** decode_row **********
+ *
+ * A2Parallel_run task that decodes block row row of the codewords in the
+ * Codec_Closure cl into its two pixel rows
+ *
+ * Notes:
+ *      A run of identical codewords is decoded once and the result
+ *      copied across the rest of the run
+ ************************/
+static void decode_row(size_t row, void *cl)
+{
+        Codec_Closure *closure = cl;
+        Pnm_ppm image = closure->image;
+        A2Methods_T methods = uarray2_methods_plain;
+        int blocks_wide = methods->width(closure->codewords);
+        if (blocks_wide == 0) {
+                return;         /* a row of no blocks has no element 0 */
+        }
+        uint32_t *words = methods->at(closure->codewords, 0, row);
+
+        int col = 0;
+        while (col < blocks_wide) {
+                int run = 1;
+                while (col + run < blocks_wide
+                       && words[col + run] == words[col]) {
+                        run++;
+                }
+
+                Pnm_rgb pixels[BLOCKAREA];
+                block_pixels(image, col, row, pixels);
+                Codec40_decode_block(words[col], image->denominator, pixels);
+                if (run > 1) {
+                        broadcast_pixels(pixels[0], run * BLOCKSIZE);
+                        broadcast_pixels(pixels[BLOCKSIZE], run * BLOCKSIZE);
+                        STATS_COUNT(STATS_BLOCKS, run - 1);
+                }
+                col += run;
+        }
+}
+
+
+/********** Codec40_decode **********
+ *
+ * Decompresses an array of codewords into a new image
+ *
+ * Parameters:
+ *      A2 codewords - UArray2 of uint32_t codewords, one per 2x2 block
+ *
+ * Return:
+ *      A new Pnm_ppm twice as wide and tall as codewords, with denominator
+ *      DECOMPRESSION_IMAGE_DENOMINATOR
+ *
+ * Expects:
+ *      codewords is non-null
+ *
+ * Notes:
+ *      The caller frees the result with Pnm_ppmfree
+ *      Each block row is a task for the a2parallel.h pool, which moves
+ *      rows from busy workers to idle ones as their cost varies
+ ************************/
+Pnm_ppm Codec40_decode(A2 codewords)
+{
+        assert(codewords != NULL);
+
+        A2Methods_T methods = uarray2_methods_plain;
+        Pnm_ppm image;
+        NEW(image);
+        image->width = methods->width(codewords) * BLOCKSIZE;
+        image->height = methods->height(codewords) * BLOCKSIZE;
+        image->denominator = DECOMPRESSION_IMAGE_DENOMINATOR;
+        image->methods = methods;
+        image->pixels = methods->new(image->width, image->height,
+                                     sizeof(struct Pnm_rgb));
+
+        Codec_Closure cl = { image, codewords };
+        void *cls[A2PARALLEL_MAX_WORKERS];
+        for (int w = 0; w < A2Parallel_workers(); w++) {
+                cls[w] = &cl;
+        }
+        A2Parallel_run(methods->height(codewords), decode_row, cls);
+        return image;
+}
+
+
+/******************************************************************************
+ * 
+ *     CODEWORD INPUT AND OUTPUT
+ *
+ *****************************************************************************/
+
+
+/* format 3 repeat tokens: a b field of -16, which the quantizer never
+ * produces, marks a token; the other 27 bits hold the repeat count */
+#define RUN_FIELD_LSB 18
+#define RUN_FIELD_MASK 0x1fu
+#define RUN_MARKER 0x10u
+#define RUN_LOW_BITS 18
+#define RUN_HIGH_LSB 23
+#define RUN_MAX_REPEATS ((1u << 27) - 1)
+
+/* shorter runs are cheaper, or no dearer, written out in full */
+#define RUN_MIN_REPEATS 2
+
+/* codewords converted to bytes per fwrite */
+#define WRITE_CHUNK 256
+
+/* whether Codec40_write and friends emit format 3 instead of format 2 */
+static bool run_length = false;
+
+/********** Read_Closure **********
+ *
+ * struct passed to applyRead
+ *
+ * Contains:
+ *      FILE *input
+ *          the stream being read
+ *
+ *      unsigned format
+ *          the container version from the header (2 or 3)
+ *
+ *      uint32_t previous, unsigned repeats
+ *          last codeword read, and copies of it still to be filled in from
+ *          a repeat token
+ *
+ *      bool started
+ *          whether previous holds a codeword yet
+ *
+ ************************/
+typedef struct Read_Closure {
+        FILE *input;
+        unsigned format;
+        uint32_t previous;
+        unsigned repeats;
+        bool started;
+} Read_Closure;
+
+/********** Write_Closure **********
+ *
+ * struct passed to applyWrite
+ *
+ ************************/
+typedef struct Write_Closure {
+        FILE *output;
+        Codec40_Runs runs;
+} Write_Closure;
+
+
+/********** is_run_token **********
+ *
+ * Returns whether a format 3 word is a repeat token rather than a codeword
+ *
+ ************************/
+static inline bool is_run_token(uint32_t word)
+{
+        return ((word >> RUN_FIELD_LSB) & RUN_FIELD_MASK) == RUN_MARKER;
+}
+
+
+/********** write_words **********
+ *
+ * Writes n words to output in big-endian order
+ *
+ ************************/
+static void write_words(FILE *output, const uint32_t *words, size_t n)
+{
+        unsigned char bytes[WRITE_CHUNK * 4];
+
+        while (n > 0) {
+                size_t chunk = n < WRITE_CHUNK ? n : WRITE_CHUNK;
+                for (size_t i = 0; i < chunk; i++) {
+                        bytes[4 * i] = words[i] >> 24;
+                        bytes[4 * i + 1] = words[i] >> 16;
+                        bytes[4 * i + 2] = words[i] >> 8;
+                        bytes[4 * i + 3] = words[i];
+                }
+                size_t wrote = fwrite(bytes, 4, chunk, output);
+                assert(wrote == chunk);
+                words += chunk;
+                n -= chunk;
+        }
+}
+
+
+/********** flush_repeats **********
+ *
+ * Writes the pending repeats of runs->codeword, as a token if the run is
+ * long enough and as plain copies otherwise
+ *
+ ************************/
+static void flush_repeats(FILE *output, Codec40_Runs *runs)
+{
+        if (runs->repeats >= RUN_MIN_REPEATS) {
+                uint32_t count = runs->repeats;
+                uint32_t token = (count >> RUN_LOW_BITS) << RUN_HIGH_LSB
+                                 | RUN_MARKER << RUN_FIELD_LSB
+                                 | (count & ((1u << RUN_LOW_BITS) - 1));
+                write_words(output, &token, 1);
+        } else {
+                for (unsigned i = 0; i < runs->repeats; i++) {
+                        write_words(output, &runs->codeword, 1);
+                }
+        }
+        runs->repeats = 0;
+}
+
+
+/********** Codec40_use_run_length **********
+ *
+ * Chooses between format 2 (every codeword written out) and format 3
+ * (runs of identical codewords written as repeat tokens) for output
+ *
+ * Parameters:
+ *      bool enable - true for format 3, false for format 2
+ *
+ * Return:
+ *      None
+ *
+ * Notes:
+ *      Codec40_read accepts both formats regardless
+ ************************/
+void Codec40_use_run_length(bool enable)
+{
+        run_length = enable;
+}
+
+
+/********** Codec40_write_header **********
+ *
+ * Writes the compressed image header for the current format
+ *
+ * Parameters:
+ *      FILE *output    - The stream to write to
+ *      unsigned width  - Width of the (trimmed) image in pixels
+ *      unsigned height - Height of the (trimmed) image in pixels
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      output is non-null
+ ************************/
+void Codec40_write_header(FILE *output, unsigned width, unsigned height)
+{
+        assert(output != NULL);
+        fprintf(output, "COMP40 Compressed image format %d\n%u %u\n",
+                run_length ? 3 : 2, width, height);
+}
+
+
+/********** Codec40_put_codewords **********
+ *
+ * Writes the next n codewords of an image, in row-major block order
+ *
+ * Parameters:
+ *      FILE *output          - The stream to write to
+ *      Codec40_Runs *runs    - Run state, zeroed before the first call
+ *      const uint32_t *codewords - The codewords
+ *      size_t n              - How many there are
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      output, runs, and codewords are non-null
+ *
+ * Notes:
+ *      In format 3 a run can continue across calls, so
+ *      Codec40_end_codewords must follow the last call
+ ************************/
+void Codec40_put_codewords(FILE *output, Codec40_Runs *runs,
+                           const uint32_t *codewords, size_t n)
+{
+        assert(output != NULL && runs != NULL && codewords != NULL);
+
+        if (!run_length) {
+                write_words(output, codewords, n);
+                return;
+        }
+        for (size_t i = 0; i < n; i++) {
+                if (runs->started && codewords[i] == runs->codeword
+                    && runs->repeats < RUN_MAX_REPEATS) {
+                        runs->repeats++;
+                        continue;
+                }
+                flush_repeats(output, runs);
+                write_words(output, &codewords[i], 1);
+                runs->codeword = codewords[i];
+                runs->started = true;
+        }
+}
+
+
+/********** Codec40_end_codewords **********
+ *
+ * Writes out any run still pending after the last Codec40_put_codewords
+ *
+ ************************/
+void Codec40_end_codewords(FILE *output, Codec40_Runs *runs)
+{
+        assert(output != NULL && runs != NULL);
+        flush_repeats(output, runs);
+}
+
+
+/********** applyWrite **********
+ *
+ * Apply function that writes one codeword through the closure's run state
+ *
+ ************************/
+static void applyWrite(int col, int row, A2 codewords, void *elem, void *cl)
+{
+        (void)col;
+        (void)row;
+        (void)codewords;
+        Write_Closure *closure = cl;
+        Codec40_put_codewords(closure->output, &closure->runs,
+                              (uint32_t *)elem, 1);
+}
+
+
+/********** applyRead **********
+ *
+ * Apply function that reads one codeword from the stream in cl, expanding
+ * format 3 repeat tokens
+ *
+ ************************/
+static void applyRead(int col, int row, A2 codewords, void *elem, void *cl)
+{
+        (void)col;
+        (void)row;
+        (void)codewords;
+        Read_Closure *closure = cl;
+
+        if (closure->repeats > 0) {
+                closure->repeats--;
+                *(uint32_t *)elem = closure->previous;
+                return;
+        }
+
+        uint64_t word;
+        read_codeword(closure->input, &word);
+        if (closure->format == 3 && is_run_token(word)) {
+                uint32_t count = (word >> RUN_HIGH_LSB) << RUN_LOW_BITS
+                                 | (word & ((1u << RUN_LOW_BITS) - 1));
+                assert(closure->started && count > 0);
+                closure->repeats = count - 1;
+                *(uint32_t *)elem = closure->previous;
+                return;
+        }
+        closure->previous = word;
+        closure->started = true;
+        *(uint32_t *)elem = word;
+}
+
+
+/********** Codec40_write **********
+ *
+ * Writes the compressed image header followed by every codeword in
+ * row-major block order
+ *
+ * Parameters:
+ *      FILE *output - The stream to write to
+ *      A2 codewords - UArray2 of uint32_t codewords, one per 2x2 block
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      output and codewords are non-null
+ *
+ * Notes:
+ *      Writes format 3 if Codec40_use_run_length has turned it on
+ ************************/
+void Codec40_write(FILE *output, A2 codewords)
+{
+        assert(output != NULL && codewords != NULL);
+        A2Methods_T methods = uarray2_methods_plain;
+        Write_Closure cl = { output, { 0, 0, false } };
+
+        Codec40_write_header(output, methods->width(codewords) * BLOCKSIZE,
+                             methods->height(codewords) * BLOCKSIZE);
+        methods->map_row_major(codewords, applyWrite, &cl);
+        Codec40_end_codewords(output, &cl.runs);
+}
+
+
+/********** Codec40_read_header **********
+ *
+ * Parses the header of a compressed file
+ *
+ * Parameters:
+ *      FILE *input      - The stream to read from
+ *      unsigned *width  - Set to the image width in pixels
+ *      unsigned *height - Set to the image height in pixels
+ *
+ * Return:
+ *      The format number from the header
+ *
+ * Expects:
+ *      input, width, and height are non-null, and input starts with
+ *              COMP40 Compressed image format N
+ *      followed by the width and height
+ *
+ * Notes:
+ *      Will CRE if the header is malformed, or a dimension is past
+ *      INT_MAX, the most a UArray2 can hold. Any format number is
+ *      accepted, so callers can dispatch on it (see gray40.h).
+ ************************/
+unsigned Codec40_read_header(FILE *input, unsigned *width, unsigned *height)
+{
+        assert(input != NULL && width != NULL && height != NULL);
+
+        unsigned format;
+        int read = fscanf(input, "COMP40 Compressed image format %u\n%u %u",
+                          &format, width, height);
+        assert(read == 3);
+        assert(*width <= INT_MAX && *height <= INT_MAX);
+        int c = getc(input);
+        assert(c == '\n');
+        return format;
+}
+
+
+/********** Codec40_read_codewords **********
+ *
+ * Reads every codeword of a format 2 or 3 file whose header has been read
+ *
+ * Parameters:
+ *      FILE *input     - The stream to read from
+ *      unsigned format - Format number from the header
+ *      unsigned width  - Image width from the header
+ *      unsigned height - Image height from the header
+ *
+ * Return:
+ *      A new UArray2 of uint32_t codewords, one per 2x2 block
+ *
+ * Notes:
+ *      Will CRE if the format is not 2 or 3, the input ends early, or a
+ *      repeat token has nothing to repeat or runs past the image
+ ************************/
+A2 Codec40_read_codewords(FILE *input, unsigned format, unsigned width,
+                          unsigned height)
+{
+        assert(input != NULL);
+        assert(format == 2 || format == 3);
+
+        A2 codewords = uarray2_methods_plain->new(width / BLOCKSIZE,
+                                                  height / BLOCKSIZE,
+                                                  sizeof(uint32_t));
+        Read_Closure cl = { input, format, 0, 0, false };
+        uarray2_methods_plain->map_row_major(codewords, applyRead, &cl);
+        assert(cl.repeats == 0);
+        return codewords;
+}
+
+
+/********** Codec40_read **********
+ *
+ * Parses the compressed image header and reads every codeword
+ *
+ * Parameters:
+ *      FILE *input - The stream to read from
+ *
+ * Return:
+ *      A new UArray2 of uint32_t codewords, one per 2x2 block
+ *
+ * Expects:
+ *      input is non-null and its header matches one of the formats:
+ *              COMP40 Compressed image format 2
+ *              COMP40 Compressed image format 3
+ *
+ * Notes:
+ *      Will CRE if the header is the wrong format, the input ends early,
+ *      or a repeat token has nothing to repeat or runs past the image
+ ************************/
+A2 Codec40_read(FILE *input)
+{
+        unsigned width, height;
+        unsigned format = Codec40_read_header(input, &width, &height);
+        return Codec40_read_codewords(input, format, width, height);
+}
+
+
+/******************************************************************************
+ * 
+ *     APPLY HELPER FUNCTIONS FOR COMPRESSION AND DECOMPRESSION
+ *
+ *****************************************************************************/
+
+
+/********** block_pixels **********
+ *
+ * Collects pointers to the four pixels of the 2x2 block at (col, row) of
+ * the block grid, in the order the codec numbers them (Y1..Y4)
+ *
+ ************************/
+static void block_pixels(Pnm_ppm image, int col, int row,
+                         Pnm_rgb pixels[BLOCKAREA])
+{
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                int block_col = col * BLOCKSIZE + block_i % BLOCKSIZE;
+                int block_row = row * BLOCKSIZE + block_i / BLOCKSIZE;
+                pixels[block_i] = image->methods->at(image->pixels,
+                                                     block_col, block_row);
+        }
+}
+
+
+/********** applyCompress **********
+ *
+ * Compresses one 2x2 block of the image into its codeword
+ *
+ * Parameters:
+ *      int col         - The column index of the block
+ *      int row         - The row index of the block
+ *      A2 codewords    - The 2D array of codewords being filled in
+ *      void *elem      - Pointer to the block's uint32_t codeword
+ *      void *cl        - Pointer to the Codec_Closure holding the image
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      cl and elem are non-null.
+ *
+ * Notes:
+ *      side effect - stores the block's codeword in *elem
+ ************************/
+static void applyCompress(int col, int row, A2 codewords, void *elem,
+                          void *cl) 
+{
+        (void)codewords;
+        assert(cl != NULL);
+        assert(elem != NULL);
+        
+        Pnm_ppm image = ((Codec_Closure *)cl)->image;
+        Pnm_rgb pixels[BLOCKAREA];
+
+        block_pixels(image, col, row, pixels);
+        *(uint32_t *)elem = Codec40_encode_block(pixels, image->denominator);
+}
+
+
+/********** broadcast_pixels **********
+ *
+ * Repeats the first BLOCKSIZE pixels at start until length pixels of the
+ * row are filled, doubling the copied span each time
+ *
+ * Expects:
+ *      the length pixels are contiguous, as in a plain UArray2 row
+ ************************/
+static void broadcast_pixels(Pnm_rgb start, size_t length)
+{
+        size_t filled = BLOCKSIZE;
+        while (filled < length) {
+                size_t n = filled < length - filled ? filled : length - filled;
+                memcpy(start + filled, start, n * sizeof(*start));
+                filled += n;
+        }
+}
+
+
+/******************************************************************************
+ * 
+ *     SINGLE-BLOCK COMPRESSION AND DECOMPRESSION
+ *
+ *****************************************************************************/
+
+
+/********** Codec40_use_fixed_point **********
+ *
+ * Chooses between the float stages below and the integer-only codec in
+ * fixed40.c for every block coded from now on
+ *
+ * Parameters:
+ *      bool enable - true for fixed point, false for float
+ *
+ * Return:
+ *      None
+ *
+ * Notes:
+ *      Both produce the same codeword format. Call this before any
+ *      threads start coding blocks.
+ ************************/
+void Codec40_use_fixed_point(bool enable)
+{
+        fixed_point = enable;
+}
+
+
+/********** encode_block_float **********
+ *
+ * Compresses one 2x2 block of pixels into its codeword with the float
+ * stages:
+ *    - Converts the block from RGB to component video
+ *    - Computes the DCT coefficients
+ *    - Quantizes the coefficients and chroma values
+ *    - Packs these values into a codeword using the Bitpack interface
+ *
+ * Parameters:
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4 (top-left,
+ *                             top-right, bottom-left, bottom-right)
+ *      unsigned denominator - The image denominator (max color value)
+ *
+ * Return:
+ *      The block's 32-bit codeword
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels
+ *
+ * Notes:
+ *      Safe to call from several threads at once
+ ************************/
+static uint32_t encode_block_float(Pnm_rgb pixels[BLOCKAREA],
+                                   unsigned denominator)
+{
+        Block_Pixel_Info block;
+        STATS_COUNT(STATS_BLOCKS, 1);
+        STATS_START(convert_start);
+        
+        /* loop through each pixel in the current 2x2 block */
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {    
+                /* convert RGB block to component video */
+                RGB_to_ComponentVideo(pixels[block_i], denominator, 
+                                      &block.compvidArr[block_i]);
+        }
+        STATS_STOP(STATS_CONVERT, convert_start);
+
+        /* apply discrete cosine transform */
+        STATS_START(dct_start);
+        discrete_Cosine_Transform(&block);
+        STATS_STOP(STATS_DCT, dct_start);
+
+        /* apply quantization of a, b, c, d values */
+        STATS_START(quantize_start);
+        abcd_quantization(&block);
+
+        /* apply quantization of chroma */
+        chroma_quantization(&block);
+        STATS_STOP(STATS_QUANTIZE, quantize_start);
+        
+        /* assign computed values to codeword elements */
+        CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = { CODEWORD_A, 
+                                                               CODEWORD_B,
+                                                               CODEWORD_C,
+                                                               CODEWORD_D,
+                                                               CODEWORD_PB,
+                                                               CODEWORD_PR };
+        code_elems[0].value = block.quantized_abcd[0];
+        code_elems[1].value = block.quantized_abcd[1];
+        code_elems[2].value = block.quantized_abcd[2];
+        code_elems[3].value = block.quantized_abcd[3];
+        code_elems[4].value = block.pb_chromaIndex;
+        code_elems[5].value = block.pr_chromaIndex;
+        
+        /* pack codeword with compressed image components */
+        STATS_START(pack_start);
+        uint32_t codeword = pack_codeword(code_elems);
+        STATS_STOP(STATS_PACK, pack_start);
+        return codeword;
+}
+
+
+/********** decode_block_float **********
+ *
+ * Decompresses one codeword into a 2x2 block of pixels with the float
+ * stages:
+ *    - Unpacks the quantized values
+ *    - Applies the inverse DCT
+ *    - Converts the component video values back to RGB values
+ *
+ * Parameters:
+ *      uint32_t codeword    - The block's codeword
+ *      unsigned denominator - The denominator of the decoded pixels
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4, to fill in
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels
+ *
+ * Notes:
+ *      side effect - writes the decoded values into the four pixels
+ *      Safe to call from several threads at once
+ ************************/
+static void decode_block_float(uint32_t codeword, unsigned denominator,
+                               Pnm_rgb pixels[BLOCKAREA])
+{
+        STATS_COUNT(STATS_BLOCKS, 1);
+
+        /* unpack codewords */
+        CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = { CODEWORD_A, 
+                                                               CODEWORD_B,
+                                                               CODEWORD_C,
+                                                               CODEWORD_D,
+                                                               CODEWORD_PB,
+                                                               CODEWORD_PR };
+        STATS_START(unpack_start);
+        extract_bitpack(codeword, code_elems);
+            
+        /* create block to store extracted codeword values */
+        Block_Pixel_Info block;
+        block.quantized_abcd[0] = code_elems[0].value;
+        block.quantized_abcd[1] = code_elems[1].value;
+        block.quantized_abcd[2] = code_elems[2].value;
+        block.quantized_abcd[3] = code_elems[3].value;
+        block.pb_chromaIndex = code_elems[4].value;
+        block.pr_chromaIndex = code_elems[5].value;
+        STATS_STOP(STATS_PACK, unpack_start);
+        
+        /* get index of chroma */
+        STATS_START(dequantize_start);
+        block.pb_mean = Arith40_chroma_of_index(block.pb_chromaIndex);
+        block.pr_mean = Arith40_chroma_of_index(block.pr_chromaIndex);
+        STATS_STOP(STATS_QUANTIZE, dequantize_start);
+
+        /* apply inverse discrete cosine transform */
+        STATS_START(idct_start);
+        inverse_discrete_Cosine_Transform(&block);
+        STATS_STOP(STATS_DCT, idct_start);
+
+        /* convert each pixel back to RGB values */
+        STATS_START(convert_start);
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {  
+                /* convert current pixel from component video to RGB */
+                ComponentVideo_to_RGB(block.pb_mean, block.pr_mean, 
+                                &block.compvidArr[block_i], 
+                                denominator, pixels[block_i]);
+        }
+        STATS_STOP(STATS_CONVERT, convert_start);
+}
+
+
+/******************************************************************************
+ * 
+ *     BLOCK CACHES
+ *
+ *****************************************************************************/
+
+
+/********** Encode_Entry **********
+ *
+ * struct to hold one slot of the encoder cache
+ *
+ * Contains:
+ *      uint32_t key[3]
+ *          the block's twelve 8-bit channels, packed four to a word
+ *
+ *      unsigned denominator
+ *          denominator the block was coded with; 0 marks an empty slot
+ *
+ *      bool fixed
+ *          whether the codeword came from the fixed-point path
+ *
+ *      uint32_t codeword
+ *          the block's codeword
+ *
+ ************************/
+typedef struct Encode_Entry {
+        uint32_t key[3];
+        unsigned denominator;
+        bool fixed;
+        uint32_t codeword;
+} Encode_Entry;
+
+/********** Decode_Entry **********
+ *
+ * struct to hold one slot of the decoder cache
+ *
+ * Contains:
+ *      uint32_t codeword
+ *          the codeword decoded
+ *
+ *      unsigned denominator
+ *          denominator it was decoded to; 0 marks an empty slot
+ *
+ *      bool fixed
+ *          whether the pixels came from the fixed-point path
+ *
+ *      struct Pnm_rgb pixels[]
+ *          the decoded block, Y1 to Y4
+ *
+ ************************/
+typedef struct Decode_Entry {
+        uint32_t codeword;
+        unsigned denominator;
+        bool fixed;
+        struct Pnm_rgb pixels[BLOCKAREA];
+} Decode_Entry;
+
+/*
+ * The caches are direct mapped and private to each thread, so workers
+ * never contend for them. Repeated blocks (flat fills, UI chrome, text
+ * on a plain background) hit; a miss costs one hash and a compare.
+ */
+#define CACHE_BITS 8
+#define CACHE_SIZE (1u << CACHE_BITS)
+
+static bool caching = true;
+static __thread Encode_Entry encode_cache[CACHE_SIZE];
+static __thread Decode_Entry decode_cache[CACHE_SIZE];
+
+
+/********** cache_slot **********
+ *
+ * Maps a 32-bit hash input to a cache slot (multiplicative hashing)
+ *
+ ************************/
+static inline unsigned cache_slot(uint32_t x)
+{
+        return (x * 0x9e3779b1u) >> (32 - CACHE_BITS);
+}
+
+
+/********** Codec40_use_cache **********
+ *
+ * Turns the encoder and decoder block caches on or off
+ *
+ * Parameters:
+ *      bool enable - true to cache (the default), false to code every
+ *                    block from scratch
+ *
+ * Return:
+ *      None
+ *
+ * Notes:
+ *      Output is identical either way. Call this before any threads start
+ *      coding blocks.
+ ************************/
+void Codec40_use_cache(bool enable)
+{
+        caching = enable;
+}
+
+
+/********** Codec40_encode_block **********
+ *
+ * Compresses one 2x2 block of pixels into its codeword, with the float or
+ * fixed-point path as chosen by Codec40_use_fixed_point
+ *
+ * Parameters:
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4 (top-left,
+ *                             top-right, bottom-left, bottom-right)
+ *      unsigned denominator - The image denominator (max color value)
+ *
+ * Return:
+ *      The block's 32-bit codeword
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels
+ *
+ * Notes:
+ *      Blocks of 8-bit images are looked up in the encoder cache by
+ *      their twelve channel bytes first, and repeated blocks skip the
+ *      transform entirely. Safe to call from several threads at once.
+ ************************/
+uint32_t Codec40_encode_block(Pnm_rgb pixels[BLOCKAREA], unsigned denominator)
+{
+        if (!caching || denominator > 255) {
+                return fixed_point ? Fixed40_encode_block(pixels, denominator)
+                                   : encode_block_float(pixels, denominator);
+        }
+
+        uint32_t key[3] = { 0, 0, 0 };
+        for (int i = 0; i < BLOCKAREA; i++) {
+                key[0] |= pixels[i]->red << (8 * i);
+                key[1] |= pixels[i]->green << (8 * i);
+                key[2] |= pixels[i]->blue << (8 * i);
+        }
+        Encode_Entry *entry = &encode_cache[cache_slot(key[0]
+                                                       ^ (key[1] * 31)
+                                                       ^ (key[2] * 961))];
+        if (entry->denominator == denominator && entry->fixed == fixed_point
+            && entry->key[0] == key[0] && entry->key[1] == key[1]
+            && entry->key[2] == key[2]) {
+                STATS_COUNT(STATS_BLOCKS, 1);
+                STATS_COUNT(STATS_CACHE_HITS, 1);
+                return entry->codeword;
+        }
+
+        STATS_COUNT(STATS_CACHE_MISSES, 1);
+        uint32_t codeword = fixed_point
+                            ? Fixed40_encode_block(pixels, denominator)
+                            : encode_block_float(pixels, denominator);
+        memcpy(entry->key, key, sizeof(key));
+        entry->denominator = denominator;
+        entry->fixed = fixed_point;
+        entry->codeword = codeword;
+        return codeword;
+}
+
+
+/********** Codec40_decode_block **********
+ *
+ * Decompresses one codeword into a 2x2 block of pixels, with the float or
+ * fixed-point path as chosen by Codec40_use_fixed_point
+ *
+ * Parameters:
+ *      uint32_t codeword    - The block's codeword
+ *      unsigned denominator - The denominator of the decoded pixels
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4, to fill in
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels
+ *
+ * Notes:
+ *      side effect - writes the decoded values into the four pixels
+ *      Codewords are looked up in the decoder cache first, and a repeated
+ *      codeword is copied out instead of decoded. Safe to call from
+ *      several threads at once.
+ ************************/
+void Codec40_decode_block(uint32_t codeword, unsigned denominator,
+                          Pnm_rgb pixels[BLOCKAREA])
+{
+        if (!caching) {
+                if (fixed_point) {
+                        Fixed40_decode_block(codeword, denominator, pixels);
+                } else {
+                        decode_block_float(codeword, denominator, pixels);
+                }
+                return;
+        }
+
+        Decode_Entry *entry = &decode_cache[cache_slot(codeword)];
+        if (entry->denominator == denominator && entry->fixed == fixed_point
+            && entry->codeword == codeword) {
+                STATS_COUNT(STATS_BLOCKS, 1);
+                STATS_COUNT(STATS_CACHE_HITS, 1);
+                for (int i = 0; i < BLOCKAREA; i++) {
+                        *pixels[i] = entry->pixels[i];
+                }
+                return;
+        }
+
+        STATS_COUNT(STATS_CACHE_MISSES, 1);
+        if (fixed_point) {
+                Fixed40_decode_block(codeword, denominator, pixels);
+        } else {
+                decode_block_float(codeword, denominator, pixels);
+        }
+        entry->codeword = codeword;
+        entry->denominator = denominator;
+        entry->fixed = fixed_point;
+        for (int i = 0; i < BLOCKAREA; i++) {
+                entry->pixels[i] = *pixels[i];
+        }
+}
+
+
+/******************************************************************************
+ * 
+ *     COMPRESSING HELPER FUNCTIONS
+ *
+ *****************************************************************************/
+
+
+
+/********** Channel_Terms **********
+ *
+ * struct to hold one channel value's share of Y, Pb, and Pr
+ *
+ ************************/
+typedef struct Channel_Terms {
+        double y;
+        double pb;
+        double pr;
+} Channel_Terms;
+
+/********** Convert_Table **********
+ *
+ * struct to hold the RGB to component video tables for one denominator
+ *
+ * Contains:
+ *      unsigned denominator
+ *          the denominator the tables were built for
+ *
+ *      Channel_Terms *terms[3]
+ *          for denominators up to TERMS_MAX, terms[channel][value] is
+ *          what value adds to Y, Pb, and Pr in that channel (red, green,
+ *          blue); NULL for larger denominators
+ *
+ *      float *scaled
+ *          otherwise, scaled[value] is value / denominator
+ *
+ ************************/
+typedef struct Convert_Table {
+        unsigned denominator;
+        Channel_Terms *terms[3];
+        float *scaled;
+} Convert_Table;
+
+/*
+ * Full tables cost 72 bytes per channel value, 18 KB at a denominator of
+ * 255. Past TERMS_MAX that would spill out of cache, so 16-bit images get
+ * one float per value instead, which saves the divisions but not the
+ * multiplies. Tables are built the first time a denominator is seen,
+ * then only read, and each thread remembers the one it used last.
+ */
+#define TERMS_MAX 255
+#define MAX_TABLES 16
+
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static Convert_Table *tables[MAX_TABLES];
+static int num_tables = 0;
+static __thread const Convert_Table *convert_table = NULL;
+
+
+/********** build_convert_table **********
+ *
+ * Returns new tables for denominator, whose entries add up to exactly what
+ * convert_pixel computes
+ *
+ ************************/
+static Convert_Table *build_convert_table(unsigned denominator)
+{
+        Convert_Table *table;
+        NEW0(table);
+        table->denominator = denominator;
+
+        if (denominator > TERMS_MAX) {
+                table->scaled = ALLOC(((size_t) denominator + 1)
+                                      * sizeof(float));
+                for (unsigned v = 0; v <= denominator; v++) {
+                        table->scaled[v] = (float) v / denominator;
+                }
+                return table;
+        }
+
+        for (int channel = 0; channel < 3; channel++) {
+                table->terms[channel] = ALLOC((denominator + 1)
+                                              * sizeof(Channel_Terms));
+        }
+        for (unsigned v = 0; v <= denominator; v++) {
+                float x = (float) v / denominator;
+                table->terms[0][v] = (Channel_Terms) { 0.299 * x,
+                                                       -0.168736 * x,
+                                                       0.5 * x };
+                table->terms[1][v] = (Channel_Terms) { 0.587 * x,
+                                                       -0.331264 * x,
+                                                       -0.418688 * x };
+                table->terms[2][v] = (Channel_Terms) { 0.114 * x,
+                                                       0.5 * x,
+                                                       -0.081312 * x };
+        }
+        return table;
+}
+
+
+/********** find_convert_table **********
+ *
+ * Returns the tables for denominator, building them if need be, or NULL
+ * once MAX_TABLES denominators have been seen
+ *
+ ************************/
+static const Convert_Table *find_convert_table(unsigned denominator)
+{
+        pthread_mutex_lock(&tables_lock);
+        Convert_Table *table = NULL;
+        for (int i = 0; i < num_tables && table == NULL; i++) {
+                if (tables[i]->denominator == denominator) {
+                        table = tables[i];
+                }
+        }
+        if (table == NULL && num_tables < MAX_TABLES) {
+                table = build_convert_table(denominator);
+                tables[num_tables++] = table;
+        }
+        pthread_mutex_unlock(&tables_lock);
+        return table;
+}
+
+
+/********** convert_pixel **********
+ *
+ * RGB to component video from the scaled channels r, g, and b
+ *
+ ************************/
+static inline void convert_pixel(float r, float g, float b,
+                                 ComponentVideo *compvid)
+{
+        /* calculate the Y, Pb, and Pr values with linear transformation */
+        compvid->y  =  0.299    * r + 0.587    * g + 0.114    * b;
+        compvid->pb = -0.168736 * r - 0.331264 * g + 0.5      * b;
+        compvid->pr =  0.5      * r - 0.418688 * g - 0.081312 * b;
+}
+
+
+/********** RGB_to_ComponentVideo **********
+ *
+ * Converts an RGB pixel to its component video representation (Y, Pb, Pr)
+ *
+ * Parameters:
+ *      Pnm_rgb pixel         - The source RGB pixel.
+ *      unsigned denominator  - The image denominator (max color value).
+ *      ComponentVideo *compvid - Pointer to struct to store Y, Pb, and Pr
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      pixel and compvid are non-null, denominator is positive
+ *
+ * Notes:
+ *      side effect - stores Y, Pb, and Pr in ComponentVideo struct by reference
+ *      Up to a denominator of 255 each channel's share of Y, Pb, and Pr
+ *      is looked up and the shares added, with the same roundings as the
+ *      direct formulas, so results are bit-identical; larger denominators
+ *      look up only the scaled channels (see Convert_Table)
+ *      Safe to call from several threads at once
+ ************************/
+
+void RGB_to_ComponentVideo(Pnm_rgb pixel, unsigned denominator, 
+                                  ComponentVideo *compvid)
+{
+        const Convert_Table *table = convert_table;
+        if (table == NULL || table->denominator != denominator) {
+                table = find_convert_table(denominator);
+                convert_table = table;
+        }
+
+        unsigned red = pixel->red;
+        unsigned green = pixel->green;
+        unsigned blue = pixel->blue;
+        if (table == NULL || red > denominator || green > denominator
+            || blue > denominator) {
+                convert_pixel((float) red / denominator,
+                              (float) green / denominator,
+                              (float) blue / denominator, compvid);
+                return;
+        }
+
+        if (table->scaled != NULL) {
+                convert_pixel(table->scaled[red], table->scaled[green],
+                              table->scaled[blue], compvid);
+                return;
+        }
+
+        const Channel_Terms *r = &table->terms[0][red];
+        const Channel_Terms *g = &table->terms[1][green];
+        const Channel_Terms *b = &table->terms[2][blue];
+        compvid->y = r->y + g->y + b->y;
+        compvid->pb = r->pb + g->pb + b->pb;
+        compvid->pr = r->pr + g->pr + b->pr;
+}
+
+
+
+/********** discrete_Cosine_Transform **********
+ *
+ * Applies a discrete cosine transform (DCT) on a 2x2 block, computing the 
+ * coefficients a, b, c, and d from the luminance (Y) values
+ *
+ * Parameters:
+ *     Block_Pixel_Info *block - Pointer to block_pixel_info struct containing 
+ *                               component video values for each pixel in block
+ *
+ * Return:
+ *     None
+ *
+ * Expects:
+ *     block is non-null and its compvidArr[] contains valid Y values.
+ *
+ * Notes:
+ *     side effect - calculates and updates  a, b, c, d values for 2x2 block
+ *     Uses the following formulas
+ *          a = (Y1 + Y2 + Y3 + Y4) / 4
+ *          b = (Y4 + Y3 - Y2 - Y1) / 4
+ *          c = (Y4 - Y3 + Y2 - Y1) / 4
+ *          d = (Y4 - Y3 - Y2 + Y1) / 4
+ ************************/
+void discrete_Cosine_Transform(Block_Pixel_Info *block) 
+{
+        /* extract Y values from the component video struct */
+        float y1 = block->compvidArr[0].y;
+        float y2 = block->compvidArr[1].y;
+        float y3 = block->compvidArr[2].y;
+        float y4 = block->compvidArr[3].y;
+
+        /* calculate DCT coefficients */
+        block->discreteCosineArr[0] = (y4 + y3 + y2 + y1) / (float) BLOCKAREA;
+        block->discreteCosineArr[1] = (y4 + y3 - y2 - y1) / (float) BLOCKAREA;
+        block->discreteCosineArr[2] = (y4 - y3 + y2 - y1) / (float) BLOCKAREA;
+        block->discreteCosineArr[3] = (y4 - y3 - y2 + y1) / (float) BLOCKAREA;
+}
+    
+
+/********** clamp **********
+ *
+ * Clamps a floating-point value between a specified minimum and maximum value
+ *
+ * Parameters:
+ *      float value - The value to be clamped
+ *      float min   - The minimum allowed value
+ *      float max   - The maximum allowed value
+ *
+ * Return:
+ *      The clamped value:
+ *          value if min <= value <= max,
+ *          min if value < min,
+ *          max if value > max
+ *
+ * Expects:
+ *      min is less than or equal to max
+ *
+ * Notes:
+ *     None
+ ************************/
+static inline float clamp(float value, float min, float max) 
+{
+        /* if value is less than min, return min */
+        if (value < min) {
+                return min;
+        }
+
+        /* if value is greater than max, return max */
+        if (value > max) {
+                return max;       
+        }
+        
+        /* else, return value */
+        return value;
+}
+
+
+/********** abcd_quantization **********
+ *
+ * Quantizes DCT coefficients a, b, c, d for a 2x2 block in the image
+ * 
+ *
+ * Parameters:
+ *      Block_Pixel_Info *block - Pointer to block whose DCT coefficients 
+ *                                are to be quantized
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      block is non-null and discreteCosineArr[] is computed
+ *
+ * Notes:
+ *      side effect - Stores the quantized values in block->quantized_abcd[]
+ *      Scales and rounds coefficient a (luminance) to 9 bits
+ *      clamps b, c, and d to the range [-0.3, 0.3] before scaling to 5 bits
+ ************************/
+void abcd_quantization(Block_Pixel_Info *block) 
+{
+        /* extract DCT values */
+        float a = block->discreteCosineArr[0];
+        float b = block->discreteCosineArr[1];
+        float c = block->discreteCosineArr[2];
+        float d = block->discreteCosineArr[3];
+
+        /* count coefficients that fall outside the quantizer's range */
+        STATS_COUNT(STATS_CLAMPED_COEFFS, (a < 0.0 || a > 1.0)
+                                          + (fabsf(b) > 0.3f)
+                                          + (fabsf(c) > 0.3f)
+                                          + (fabsf(d) > 0.3f));
+
+        /* clamp abcd */
+        a = clamp(a,  0.0, 1.0);
+        b = clamp(b, -0.3, 0.3);
+        c = clamp(c, -0.3, 0.3);
+        d = clamp(d, -0.3, 0.3);
+        
+        float a_scaling_factor = 511.0;
+        float bcd_scaling_factor = 50.0;
+        
+        /* quantize abcd */
+        unsigned quantized_a = (unsigned) round(a * a_scaling_factor);
+        int quantized_b = (int) round(b * bcd_scaling_factor);
+        int quantized_c = (int) round(c * bcd_scaling_factor);
+        int quantized_d = (int) round(d * bcd_scaling_factor);
+
+
+        /* store the quantized values in the block */
+        block->quantized_abcd[0] = quantized_a;
+        block->quantized_abcd[1] = quantized_b;
+        block->quantized_abcd[2] = quantized_c;
+        block->quantized_abcd[3] = quantized_d;
+}
+
+/********** chroma_quantization **********
+ *
+ * Computes and quantizes the average chroma (Pb and Pr) for a 2x2 block
+ *
+ * Parameters:
+ *      Block_Pixel_Info *block - Pointer to block whose chroma values 
+ *                                are to be quantized.
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      block is non-null and compvidArr[] calculated component video values
+ *
+ * Notes:
+ *      side effect - stores Pb, Pr means and quantized chroma indices in block
+ ************************/
+void chroma_quantization(Block_Pixel_Info *block) 
+{
+        float pb_mean = 0.0;
+        float pr_mean = 0.0;
+
+        /* calculate pb, pr mean value*/
+        for (unsigned pixel_index = 0; pixel_index < 4; pixel_index++) {
+                pb_mean += block->compvidArr[pixel_index].pb;
+                pr_mean += block->compvidArr[pixel_index].pr;
+        }
+
+        /* calculate mean values */
+        pb_mean /= (float) BLOCKAREA;
+        pr_mean /= (float) BLOCKAREA;
+
+        /* store mean values in block passed by reference */
+        block->pb_mean = pb_mean;
+        block->pr_mean = pr_mean;
+
+        /* get and store index of chroma corresponding to pb, pr means */
+        block->pb_chromaIndex = Arith40_index_of_chroma(pb_mean);
+        block->pr_chromaIndex = Arith40_index_of_chroma(pr_mean);
+}
+
+
+/********** pack_codeword **********
+ *
+ * Packs an array of CodeWord_Element structures into a single 32-bit codeword
+ *
+ * Parameters:
+ *      CodeWord_Element elementArr[] -  array of length NUM_CODEWORD_ELEMENTS
+ *                                       containing the fields to be packed:
+ *                                       (a, b, c, d, Pb index, Pr index)
+ *
+ * Return:
+ *      A 32-bit codeword stored in a uint64_t with fields packed as specified
+ *
+ * Expects:
+ *      elementArr contains Codeword_Elements correspoding to a, b, c, d,
+ *      and Pb, Pr index values
+ *
+ * Notes:
+ *      Uses Bitpack_newu or Bitpack_news depending on the field's signedness
+ ************************/
+uint64_t pack_codeword(CodeWord_Element elementArr[])
+{
+        uint64_t new_word = 0;
+
+        /* iterate over CodeWord_Element fields and pack into new_word */
+        for (unsigned field_i = 0; field_i < NUM_CODEWORD_ELEMENTS; field_i++) {
+                CodeWord_Element element = elementArr[field_i];
+                uint64_t value = element.value;
+                unsigned width = element.width;
+                unsigned lsb = element.lsb;
+
+                /* call right bitpacking function based on sign */
+                if (element.isSigned) {
+                        new_word = Bitpack_news(new_word, width, lsb, value);
+                } else {
+                        new_word = Bitpack_newu(new_word, width, lsb, value);
+                }
+        }
+        
+        /* return packed codeword */
+        return new_word;
+}
+
+
+/********** print_codeword **********
+ *
+ * Prints a 32-bit codeword (stored in a uint64_t) in big-endian order
+ *
+ * Parameters:
+ *      FILE *output      - The stream to write the codeword to
+ *      uint64_t codeword - The codeword to print
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      The lower 32 bits of codeword contain the valid codeword
+ *
+ * Notes:
+ *      side effect - writes codeword to output in big-endian order
+ *      Iterates from most significant byte to least significant byte
+ *      Codeword is divided into four 8-bit bytes, where each byte is extracted
+ *      using Bitpack_getu
+ ************************/
+void print_codeword(FILE *output, uint64_t codeword) 
+{
+        /* extract codeword in big-endian order */
+        for (int byte_index = 3; byte_index >= 0; byte_index--) {
+                uint64_t byte = Bitpack_getu(codeword, 8, byte_index * 8);
+                putc(byte, output);
+        }
+}
+
+
+/******************************************************************************
+ * 
+ *     DECOMPRESSING HELPER FUNCTIONS
+ *
+ *****************************************************************************/
+
+
+
+
+/********** read_codeword **********
+ *
+ * Reads a 32-bit codeword from input stream and reconstructs it
+ * by reading four bytes, storing the result in the provided codeword address
+ *
+ * Parameters:
+ *      FILE *input        - File pointer to file containing codewords from
+ *                           decompressed image 
+ *      uint64_t *codeword - Pointer to where read-in codeword will be stored
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and codeword are non-null
+ *
+ * Notes:
+ *      side effect - *codeword is set to the read in codeword
+ *      Reads in codeword in big-endian order 
+ *      Uses Bitpack_newu to insert each byte into its proper field
+ ************************/
+void read_codeword(FILE *input, uint64_t *codeword) 
+{
+        /* assert codeword is not NULL */
+        assert(codeword != NULL);
+
+        *codeword = 0;
+
+        /* read in codeword in big-endian order */
+        for (int byte_index = 3; byte_index >= 0; byte_index--) {
+                int curr_char = getc(input);
+                assert(curr_char != EOF);
+
+                uint64_t value = (uint64_t)curr_char;
+                *codeword = Bitpack_newu(*codeword, 8, byte_index * 8, value);
+        }
+}
+
+
+/********** extract_bitpack **********
+ *
+ * Extracts individual fields from a 32-bit codeword and stores them into array
+ * of CodeWord_Element structures
+ *
+ * Parameters:
+ *      uint64_t codeword            - 32-bit codeword packed with a, b, c, d
+ *                                     Pb chroma index, Pr chroma index values
+ *      CodeWord_Element *code_elems - Pointer to an array of CodeWord_Elements
+ *                                     formatted to support each codeword value
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      code_elems is not NULL and points to an array with NUM_CODEWORD_ELEMENTS
+ *      elements
+ *
+ * Notes:
+ *      side effect - code_elems array is updated with the extracted codeword 
+ *      Assumes that the codeword is formatted with values in the order:
+ *              a, b, c, d, Pb chroma index, Pr chroma index
+ ************************/
+void extract_bitpack(uint64_t codeword, CodeWord_Element *code_elems) 
+{
+        /* iterate over each field in the codeword */
+        for (int field_i = 0; field_i < NUM_CODEWORD_ELEMENTS; field_i++) {
+                /* extract value from codeword */
+                CodeWord_Element *elem = &code_elems[field_i];
+
+                /* call right bitpacking function based on sign */
+                if (elem->isSigned) {
+                        elem->value = Bitpack_gets(codeword, elem->width, 
+                                                             elem->lsb);
+                } else {
+                        elem->value = Bitpack_getu(codeword, elem->width, 
+                                                             elem->lsb);
+                }
+        }
+}
+
+
+/********** inverse_discrete_Cosine_Transform **********
+ *
+ * Applies the inverse discrete cosine transform to convert quantized DCT
+ * coefficients back into luminance (Y) values for a 2x2 block
+ *
+ * Parameters:
+ *      Block_Pixel_Info *block - Pointer to a block with quantized DCT 
+ *                                coefficients
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      block is non-null and quantized_abcd[] contains valid quantized values
+ *
+ * Notes:
+ *      side effect - stores calculated Y values in block passed by reference
+ *      Uses the formulas:
+ *          Y1 = a - b - c + d
+ *          Y2 = a - b + c - d
+ *          Y3 = a + b - c - d
+ *          Y4 = a + b + c + d
+ ************************/
+void inverse_discrete_Cosine_Transform(Block_Pixel_Info *block) 
+{
+        /* set scaling factors for a, b, c, d values */
+        float a_scaling_factor = 511.0;
+        float bcd_scaling_factor = 50.0;
+        
+        /* extract quantized a, b, c, d values */
+        float a = block->quantized_abcd[0] / a_scaling_factor;
+        float b = block->quantized_abcd[1] / bcd_scaling_factor;
+        float c = block->quantized_abcd[2] / bcd_scaling_factor;
+        float d = block->quantized_abcd[3] / bcd_scaling_factor;
+        
+        /* calculate Y values */
+        block->compvidArr[0].y = a - b - c + d;
+        block->compvidArr[1].y = a - b + c - d;
+        block->compvidArr[2].y = a + b - c - d;
+        block->compvidArr[3].y = a + b + c + d;
+}
+
+
+/********** ComponentVideo_to_RGB **********
+ *
+ * Converts a component video pixel back to its RGB representation
+ *
+ * Parameters:
+ *      float pb_mean           - Average Pb value for the block.
+ *      float pr_mean           - Average Pr value for the block.
+ *      ComponentVideo *compvid - Pointer to componentVideo data for 2x2 block 
+ *      unsigned denominator    - Image denominator (max color value)
+ *      Pnm_rgb pixel           - The destination RGB pixel
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      compvid and pixel are non-null
+ *      CRE if compvid is NULL
+ *      CRE if pixel is NULL
+ *
+ * Notes:
+ *      side effect - calculates & updates RGB pixel by reference
+ ************************/
+void ComponentVideo_to_RGB(float pb_mean, float pr_mean, 
+                           ComponentVideo *compvid, unsigned denominator, 
+                           Pnm_rgb pixel) 
+{
+        /* assert compvid and pixel are not NULL */
+        assert(compvid != NULL);
+        assert(pixel != NULL);
+        
+        /* read luminance (Y) from ComponentVideo struct */
+        float y  = compvid->y;
+        float pb = pb_mean;
+        float pr = pr_mean;
+
+        /* apply calculation to get r, b, g values from component video */
+        float r = 1.0 * y + 0.0      * pb + 1.402    * pr;
+        float g = 1.0 * y - 0.344136 * pb - 0.714136 * pr;
+        float b = 1.0 * y + 1.772    * pb + 0.0      * pr;
+
+        /* count channels that fall outside [0, 1] */
+        STATS_COUNT(STATS_CLAMPED_RGB, (r < 0 || r > 1) + (g < 0 || g > 1)
+                                       + (b < 0 || b > 1));
+
+        /* update pixel with calculated r, g, b values */
+        pixel->red   = (unsigned) clamp(r * denominator, 0, denominator);
+        pixel->green = (unsigned) clamp(g * denominator, 0, denominator);
+        pixel->blue  = (unsigned) clamp(b * denominator, 0, denominator);
+}
\ No newline at end of file
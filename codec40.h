@@ -0,0 +1,200 @@
+/**************************************************************
+*
+*                     codec40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       codec40.h declares the lossy image codec: whole-image
+*       compression to and from an in-memory array of codewords, and
+*       the per-block stages underneath it (color conversion, DCT,
+*       quantization, and codeword packing) so that the benchmark
+*       harness can run each stage on its own.
+*
+**************************************************************/
+#ifndef CODEC40_INCLUDED
+#define CODEC40_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pnm.h"
+#include "a2methods.h"
+
+/* Constants */
+#define BLOCKSIZE 2
+#define BLOCKAREA (BLOCKSIZE * BLOCKSIZE)
+#define NUM_CODEWORD_ELEMENTS 6
+#define DECOMPRESSION_IMAGE_DENOMINATOR 255
+
+/********** ComponentVideo **********
+ *
+ * struct to hold a pixel's component video color space
+ *
+ * Contains:
+ *      float y
+ *          represents luma (brightness) value in the range [0, 1]
+ *
+ *      float pb
+ *          represents the blue color difference chroma component
+ *
+ *      float pr
+ *          represents the red color difference chroma component
+ *
+ ************************/
+typedef struct ComponentVideo{
+        float y;
+        float pb;
+        float pr;
+} ComponentVideo;
+
+
+/********** Block_Pixel_Info **********
+ *
+ * struct to holds all data for processing a 2×2 pixel block during compression
+ * and decompression.
+ *
+ * Contains:
+ *      ComponentVideo compvidArr[4]
+ *          array of component video values (Y, Pb, Pr) for each pixel in block
+ *
+ *      float discreteCosineArr[4]
+ *          array storing the DCT coefficients computed from blocks luma values
+ *
+ *      int quantized_abcd[4]
+ *          array storing the quantized DCT coefficients (a, b, c, d) for block
+ *
+ *      unsigned pb_chromaIndex
+ *          quantized index for the average Pb value of the block
+ *
+ *      unsigned pr_chromaIndex
+ *          quantized index for the average Pr value of the block
+ *
+ *      float pb_mean
+ *          average Pb value computed from the block
+ *
+ *      float pr_mean
+ *          average Pr value computed from the block
+ *
+ ************************/
+typedef struct Block_Pixel_Info {
+        ComponentVideo compvidArr[4];
+        float discreteCosineArr[4];
+        int quantized_abcd[4];
+        unsigned pb_chromaIndex;
+        unsigned pr_chromaIndex;
+        float pb_mean;
+        float pr_mean;
+
+} Block_Pixel_Info;
+
+
+/********** CodeWord_Element **********
+ *
+ * struct to hold single field within a 32-bit codeword for image compression
+ *
+ * Contains:
+ *      uint64_t value
+ *          unasigned 64-bit integer value to store in the field
+ *
+ *      bool isSigned
+ *          represents a signed value - true for signed, false for unsigned
+ *
+ *      unsigned width
+ *          unsigned number of bits allocated for the field
+ *
+ *      unsigned lsb
+ *          the position (unsigned bit index) of the least-significant bit of
+ *          the field in the codeword.
+ *
+ ************************/
+typedef struct CodeWord_Element {
+        uint64_t value;
+        bool isSigned;
+        unsigned width;
+        unsigned lsb;
+} CodeWord_Element;
+
+
+/********** CodeWord Templates **********
+ *
+ * define bitfield templates for a 32-bit codeword
+ *
+ * these templates initialize a CodeWord_Element for a, b, c, d, Pb, and Pr:
+ *      .value    = the value to store in the field
+ *      .isSigned = a signed value - true for signed, false for unsigned
+ *      .width    = the number of bits allocated for the field
+ *      .lsb      = the position of the least-significant bit of the field
+ *
+ ************************/
+#define CODEWORD_A  { .value = 0, .isSigned = false, .width = 9, .lsb = 23 }
+#define CODEWORD_B  { .value = 0, .isSigned = true,  .width = 5, .lsb = 18 }
+#define CODEWORD_C  { .value = 0, .isSigned = true,  .width = 5, .lsb = 13 }
+#define CODEWORD_D  { .value = 0, .isSigned = true,  .width = 5, .lsb = 8  }
+#define CODEWORD_PB { .value = 0, .isSigned = false, .width = 4, .lsb = 4  }
+#define CODEWORD_PR { .value = 0, .isSigned = false, .width = 4, .lsb = 0  }
+
+
+/* whole-image codec: one uint32_t codeword per 2x2 block */
+void Codec40_trim(Pnm_ppm image);
+A2Methods_UArray2 Codec40_encode(Pnm_ppm image);
+Pnm_ppm Codec40_decode(A2Methods_UArray2 codewords);
+
+/********** Codec40_Runs **********
+ *
+ * struct to hold the run being built while writing codewords in format 3
+ *
+ * Contains:
+ *      uint32_t codeword - the last codeword written out
+ *      unsigned repeats  - copies of it seen since, not yet written
+ *      bool started      - whether codeword is set yet
+ *
+ ************************/
+typedef struct Codec40_Runs {
+        uint32_t codeword;
+        unsigned repeats;
+        bool started;
+} Codec40_Runs;
+
+/* compressed file format: header, then big-endian codewords; format 3
+ * writes runs of identical codewords as repeat tokens */
+void Codec40_use_run_length(bool enable);
+void Codec40_write(FILE *output, A2Methods_UArray2 codewords);
+A2Methods_UArray2 Codec40_read(FILE *input);
+unsigned Codec40_read_header(FILE *input, unsigned *width, unsigned *height);
+A2Methods_UArray2 Codec40_read_codewords(FILE *input, unsigned format,
+                                         unsigned width, unsigned height);
+
+/* the same output written a piece at a time, in row-major block order */
+void Codec40_write_header(FILE *output, unsigned width, unsigned height);
+void Codec40_put_codewords(FILE *output, Codec40_Runs *runs,
+                           const uint32_t *codewords, size_t n);
+void Codec40_end_codewords(FILE *output, Codec40_Runs *runs);
+
+/* single 2x2 block, pixels in order top-left, top-right, bottom-left,
+ * bottom-right; float stages by default, fixed40.c once enabled */
+void Codec40_use_fixed_point(bool enable);
+void Codec40_use_cache(bool enable);
+uint32_t Codec40_encode_block(Pnm_rgb pixels[BLOCKAREA], unsigned denominator);
+void Codec40_decode_block(uint32_t codeword, unsigned denominator,
+                          Pnm_rgb pixels[BLOCKAREA]);
+
+/* compression stages */
+void RGB_to_ComponentVideo(Pnm_rgb pixel, unsigned denominator,
+                           ComponentVideo *compvid);
+void discrete_Cosine_Transform(Block_Pixel_Info *block);
+void abcd_quantization(Block_Pixel_Info *block);
+void chroma_quantization(Block_Pixel_Info *block);
+uint64_t pack_codeword(CodeWord_Element elementArr[]);
+void print_codeword(FILE *output, uint64_t codeword);
+
+/* decompression stages */
+void read_codeword(FILE *input, uint64_t *codeword);
+void extract_bitpack(uint64_t codeword, CodeWord_Element *code_elems);
+void inverse_discrete_Cosine_Transform(Block_Pixel_Info *block);
+void ComponentVideo_to_RGB(float pb_mean, float pr_mean,
+                           ComponentVideo *compvid, unsigned denominator,
+                           Pnm_rgb pixel);
+
+#endif
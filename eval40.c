@@ -0,0 +1,142 @@
+/**************************************************************
+*
+*                     eval40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       eval40.c implements the round-trip evaluation mode of 40image.
+*       Each image is compressed and decompressed in memory, then
+*       scored against the original with quality40, so that any change
+*       to the codec can be judged on both speed and quality.
+*
+**************************************************************/
+#include "eval40.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "assert.h"
+#include "pnm.h"
+#include "pnm40.h"
+#include "a2plain.h"
+#include "a2methods.h"
+#include "codec40.h"
+#include "quality40.h"
+#include "gray40.h"
+
+
+/********** now_ns **********
+ *
+ * Returns the current value of the monotonic clock in nanoseconds
+ *
+ ************************/
+static double now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/********** Eval40_header **********
+ *
+ * Prints the column names of the table Eval40_image prints rows of
+ *
+ * Parameters:
+ *      FILE *output - The stream to print to
+ *
+ ************************/
+void Eval40_header(FILE *output)
+{
+        assert(output != NULL);
+        fprintf(output, "%-24s %6s %6s %10s %6s %8s %8s %7s %9s %9s\n",
+                "image", "width", "height", "bytes", "bpp", "rmse",
+                "psnr_db", "ssim", "enc_MB/s", "dec_MB/s");
+}
+
+
+/********** compressed_size **********
+ *
+ * Returns the number of bytes Codec40_write produces for codewords
+ *
+ * Notes:
+ *      Format 3 sizes depend on the content, so this writes the image to
+ *      memory rather than working the size out
+ ************************/
+static size_t compressed_size(A2Methods_UArray2 codewords)
+{
+        char *buffer = NULL;
+        size_t bytes = 0;
+        FILE *stream = open_memstream(&buffer, &bytes);
+        assert(stream != NULL);
+        Codec40_write(stream, codewords);
+        fclose(stream);
+        free(buffer);
+        return bytes;
+}
+
+
+/********** Eval40_image **********
+ *
+ * Compresses one image in memory, decodes it again, and prints a table row
+ * with its compressed size, quality, and throughput
+ *
+ * Parameters:
+ *      FILE *input      - Stream containing a valid PPM image
+ *      const char *name - Name to print in the image column
+ *      FILE *output     - The stream to print to
+ *
+ * Return:
+ *      true if a row was printed, false if input holds a graymap, which
+ *      is left unread
+ *
+ * Expects:
+ *      input, name, and output are non-null
+ *      CRE if input does not contain a valid PPM image or graymap
+ *
+ * Notes:
+ *      The size is exactly what compress40 would write, header included,
+ *      in whichever container format is selected.
+ *      Throughput is measured against the raw 24-bit pixel data of the
+ *      (trimmed) image and covers the codec only, not file I/O.
+ ************************/
+bool Eval40_image(FILE *input, const char *name, FILE *output)
+{
+        assert(input != NULL && name != NULL && output != NULL);
+        A2Methods_T methods = uarray2_methods_plain;
+
+        /* quality and throughput are defined on RGB pixels */
+        if (Gray40_is_graymap(input)) {
+                return false;
+        }
+
+        Pnm_ppm original = Pnm40_read_ppm(input, methods);
+        Codec40_trim(original);
+
+        double start = now_ns();
+        A2Methods_UArray2 codewords = Codec40_encode(original);
+        double encode_ns = now_ns() - start;
+
+        start = now_ns();
+        Pnm_ppm decoded = Codec40_decode(codewords);
+        double decode_ns = now_ns() - start;
+
+        Quality40 quality = Quality40_compare(original, decoded);
+
+        double num_pixels = (double) original->width * original->height;
+        double raw_mb = 3.0 * num_pixels / 1e6;
+        size_t bytes = compressed_size(codewords);
+
+        fprintf(output, "%-24s %6u %6u %10zu %6.3f %8.5f %8.2f %7.4f "
+                "%9.1f %9.1f\n", name, original->width, original->height,
+                bytes, num_pixels > 0 ? 8.0 * bytes / num_pixels : 0.0,
+                quality.rmse, quality.psnr, quality.ssim,
+                raw_mb / (encode_ns / 1e9), raw_mb / (decode_ns / 1e9));
+
+        methods->free(&codewords);
+        Pnm_ppmfree(&decoded);
+        Pnm_ppmfree(&original);
+        return true;
+}
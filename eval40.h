@@ -0,0 +1,24 @@
+/**************************************************************
+*
+*                     eval40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       eval40.h declares the round-trip evaluation mode: compress an
+*       image, decode it in memory, and report its quality, size, and
+*       encode/decode throughput as one line of a table.
+*
+**************************************************************/
+#ifndef EVAL40_INCLUDED
+#define EVAL40_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+
+extern void Eval40_header(FILE *output);
+/* prints input's row; false, printing nothing, if input is a graymap */
+extern bool Eval40_image(FILE *input, const char *name, FILE *output);
+
+#endif
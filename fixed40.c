@@ -0,0 +1,358 @@
+/**************************************************************
+*
+*                     fixed40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       fixed40.c implements the fixed-point block codec. Every stage
+*       of codec40.c is mirrored with 32-bit integer arithmetic on
+*       scaled values, so there are no float conversions or libm
+*       calls, and the results are the same on every compiler and CPU.
+*
+*       Scales used (Qn means "value times 2^n"):
+*
+*               encode: channels Q14, color coefficients Q14,
+*                       Y Q14, DCT sums Q16 (a sum of four Q14
+*                       values is the average in Q16), chroma
+*                       means Q30
+*               decode: Y, Pb, Pr Q16, color coefficients Q14
+*
+*       Every intermediate stays within 31 bits. Dividing by the
+*       denominator is replaced by multiplying by a reciprocal, and
+*       Arith40_index_of_chroma by a search of the midpoints between
+*       neighbouring entries of the Arith40 table, computed once.
+*
+*       Decoding is table driven. The low byte of a codeword is its
+*       (Pb, Pr) index pair, so the RGB offsets of all 256 pairs are
+*       computed once, and each of a, b, c, and d indexes a table of
+*       its contribution to the four pixels' luma, with the inverse
+*       DCT signs already applied. A block then costs four luma
+*       lookups, one offset lookup, integer adds, and a clamp.
+*
+**************************************************************/
+#include "fixed40.h"
+
+#include <pthread.h>
+#include "assert.h"
+#include "arith40.h"
+#include "stats40.h"
+
+#define NUM_CHROMA 16
+
+/* RGB to component video, Q14; each luma row sums to 1, chroma rows to 0 */
+#define Y_R    4899
+#define Y_G    9617
+#define Y_B    1868
+#define PB_R  -2765
+#define PB_G  -5427
+#define PB_B   8192
+#define PR_R   8192
+#define PR_G  -6860
+#define PR_B  -1332
+
+/* component video to RGB, Q14 */
+#define R_PR  22970
+#define G_PB   5638
+#define G_PR  11700
+#define B_PB  29032
+
+/* quantizer limits: a in [0, 1] and b, c, d in [-0.3, 0.3], in Q16 */
+#define A_MAX_Q16   65536
+#define BCD_MAX_Q16 19660
+#define BCD_LEVELS  15
+
+/* dequantization steps in Q24: 1/511 and 1/50 */
+#define A_STEP_Q24   32832
+#define BCD_STEP_Q24 335544
+
+/* field positions and widths, as in the CODEWORD_* templates in codec40.h */
+#define A_LSB  23
+#define B_LSB  18
+#define C_LSB  13
+#define D_LSB  8
+#define PB_LSB 4
+#define PR_LSB 0
+#define A_WIDTH   9
+#define BCD_WIDTH 5
+
+#define NUM_CHANNELS 3
+#define NUM_BCD 3
+
+/* encoder: midpoints between neighbouring chroma values, Q30 */
+static int32_t chroma_midpoint[NUM_CHROMA - 1];
+
+/* decoder: red, green, and blue offsets (Q16) of each chroma index pair,
+ * indexed by the codeword's low byte */
+static int32_t chroma_offset[NUM_CHROMA * NUM_CHROMA][NUM_CHANNELS];
+
+/* decoder: luma contributions (Q24) of each a field, with the rounding
+ * bias of the final shift folded in, and of each raw b, c, and d field
+ * to the four pixels */
+static int32_t luma_a[1 << A_WIDTH];
+static int32_t luma_bcd[NUM_BCD][1 << BCD_WIDTH][BLOCKAREA];
+
+/* sign of b, c, and d in each pixel's inverse DCT */
+static const int bcd_sign[NUM_BCD][BLOCKAREA] = {
+        { -1, -1,  1,  1 },
+        { -1,  1, -1,  1 },
+        {  1, -1, -1,  1 }
+};
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+
+/********** round_fixed **********
+ *
+ * Returns x * 2^shift rounded to the nearest integer
+ *
+ ************************/
+static int32_t round_fixed(double x, int shift)
+{
+        double scaled = x * (double) (1u << shift);
+        return (int32_t) (scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+
+/********** build_tables **********
+ *
+ * Fills in the chroma and luma tables
+ *
+ * Notes:
+ *      Run once, through pthread_once, before the first block is coded
+ ************************/
+static void build_tables(void)
+{
+        for (unsigned i = 0; i + 1 < NUM_CHROMA; i++) {
+                double low = Arith40_chroma_of_index(i);
+                double high = Arith40_chroma_of_index(i + 1);
+                assert(low < high);     /* index search needs sorted values */
+                chroma_midpoint[i] = round_fixed((low + high) / 2, 30);
+        }
+
+        for (unsigned pb_index = 0; pb_index < NUM_CHROMA; pb_index++) {
+                int32_t pb = round_fixed(Arith40_chroma_of_index(pb_index),
+                                         16);
+                for (unsigned pr_index = 0; pr_index < NUM_CHROMA;
+                     pr_index++) {
+                        int32_t pr = round_fixed(
+                                Arith40_chroma_of_index(pr_index), 16);
+                        int32_t *offset = chroma_offset[pb_index << PB_LSB
+                                                        | pr_index << PR_LSB];
+                        offset[0] = (R_PR * pr + (1 << 13)) >> 14;
+                        offset[1] = -((G_PB * pb + G_PR * pr + (1 << 13))
+                                      >> 14);
+                        offset[2] = (B_PB * pb + (1 << 13)) >> 14;
+                }
+        }
+
+        for (int32_t qa = 0; qa < (1 << A_WIDTH); qa++) {
+                luma_a[qa] = qa * A_STEP_Q24 + (1 << 7);
+        }
+        for (int32_t field = 0; field < (1 << BCD_WIDTH); field++) {
+                /* raw fields are 5-bit two's complement */
+                int32_t level = field < (1 << (BCD_WIDTH - 1))
+                                ? field : field - (1 << BCD_WIDTH);
+                for (int coeff = 0; coeff < NUM_BCD; coeff++) {
+                        for (int i = 0; i < BLOCKAREA; i++) {
+                                luma_bcd[coeff][field][i] = bcd_sign[coeff][i]
+                                                            * level
+                                                            * BCD_STEP_Q24;
+                        }
+                }
+        }
+}
+
+
+/********** index_of_chroma **********
+ *
+ * Returns the index of the Arith40 chroma value nearest mean (Q30)
+ *
+ * Notes:
+ *      Counting the midpoints below mean finds the nearest value; a tie
+ *      goes to the lower index, as in Arith40_index_of_chroma
+ ************************/
+static inline unsigned index_of_chroma(int32_t mean)
+{
+        unsigned index = 0;
+        for (unsigned i = 0; i + 1 < NUM_CHROMA; i++) {
+                index += mean > chroma_midpoint[i];
+        }
+        return index;
+}
+
+
+/********** quantize_bcd **********
+ *
+ * Quantizes a b, c, or d coefficient (Q16) to a level in [-15, 15]
+ *
+ * Notes:
+ *      Rounds half away from zero, like round() on the float path
+ ************************/
+static inline int32_t quantize_bcd(int32_t coeff)
+{
+        int32_t magnitude = coeff < 0 ? -coeff : coeff;
+        int32_t level = (magnitude * 50 + (1 << 15)) >> 16;
+        if (level > BCD_LEVELS) {
+                level = BCD_LEVELS;
+        }
+        return coeff < 0 ? -level : level;
+}
+
+
+/********** clamp_q16 **********
+ *
+ * Clamps a Q16 channel value to [0, 1]
+ *
+ ************************/
+static inline int32_t clamp_q16(int32_t value)
+{
+        return value < 0 ? 0 : value > (1 << 16) ? (1 << 16) : value;
+}
+
+
+/********** Fixed40_encode_block **********
+ *
+ * Compresses one 2x2 block of pixels into its codeword using only integer
+ * arithmetic
+ *
+ * Parameters:
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4
+ *      unsigned denominator - The image denominator (max color value)
+ *
+ * Return:
+ *      The block's 32-bit codeword
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels with channels no greater
+ *      than denominator, and 0 < denominator <= 65535
+ *
+ * Notes:
+ *      Safe to call from several threads at once
+ ************************/
+uint32_t Fixed40_encode_block(Pnm_rgb pixels[BLOCKAREA], unsigned denominator)
+{
+        pthread_once(&tables_once, build_tables);
+        STATS_COUNT(STATS_BLOCKS, 1);
+
+        /* channel / denominator in Q14 is (channel * reciprocal) >> 16 */
+        uint32_t reciprocal = ((1u << 30) + denominator / 2) / denominator;
+
+        STATS_START(convert_start);
+        int32_t y[BLOCKAREA];
+        int32_t pb_sum = 0;
+        int32_t pr_sum = 0;
+        for (int i = 0; i < BLOCKAREA; i++) {
+                int32_t r = (pixels[i]->red * reciprocal + (1u << 15)) >> 16;
+                int32_t g = (pixels[i]->green * reciprocal + (1u << 15)) >> 16;
+                int32_t b = (pixels[i]->blue * reciprocal + (1u << 15)) >> 16;
+
+                y[i] = (Y_R * r + Y_G * g + Y_B * b + (1 << 13)) >> 14;
+                pb_sum += PB_R * r + PB_G * g + PB_B * b;
+                pr_sum += PR_R * r + PR_G * g + PR_B * b;
+        }
+        STATS_STOP(STATS_CONVERT, convert_start);
+
+        /* sums of four Q14 values are the DCT coefficients in Q16 */
+        STATS_START(dct_start);
+        int32_t a = y[3] + y[2] + y[1] + y[0];
+        int32_t b = y[3] + y[2] - y[1] - y[0];
+        int32_t c = y[3] - y[2] + y[1] - y[0];
+        int32_t d = y[3] - y[2] - y[1] + y[0];
+        STATS_STOP(STATS_DCT, dct_start);
+
+        STATS_START(quantize_start);
+        STATS_COUNT(STATS_CLAMPED_COEFFS, (a < 0 || a > A_MAX_Q16)
+                                          + (b > BCD_MAX_Q16
+                                             || b < -BCD_MAX_Q16)
+                                          + (c > BCD_MAX_Q16
+                                             || c < -BCD_MAX_Q16)
+                                          + (d > BCD_MAX_Q16
+                                             || d < -BCD_MAX_Q16));
+        a = a < 0 ? 0 : a > A_MAX_Q16 ? A_MAX_Q16 : a;
+        uint32_t qa = (a * 511 + (1 << 15)) >> 16;
+        int32_t qb = quantize_bcd(b);
+        int32_t qc = quantize_bcd(c);
+        int32_t qd = quantize_bcd(d);
+
+        /* sums of four Q28 values are the chroma means in Q30 */
+        unsigned pb_index = index_of_chroma(pb_sum);
+        unsigned pr_index = index_of_chroma(pr_sum);
+        STATS_STOP(STATS_QUANTIZE, quantize_start);
+
+        STATS_START(pack_start);
+        uint32_t codeword = qa << A_LSB
+                            | ((uint32_t) qb & 0x1f) << B_LSB
+                            | ((uint32_t) qc & 0x1f) << C_LSB
+                            | ((uint32_t) qd & 0x1f) << D_LSB
+                            | pb_index << PB_LSB
+                            | pr_index << PR_LSB;
+        STATS_STOP(STATS_PACK, pack_start);
+        return codeword;
+}
+
+
+/********** Fixed40_decode_block **********
+ *
+ * Decompresses one codeword into a 2x2 block of pixels using table
+ * lookups and integer arithmetic
+ *
+ * Parameters:
+ *      uint32_t codeword    - The block's codeword
+ *      unsigned denominator - The denominator of the decoded pixels
+ *      Pnm_rgb pixels[]     - The block's four pixels, Y1 to Y4, to fill in
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      pixels holds BLOCKAREA non-null pixels, and denominator <= 65535
+ *
+ * Notes:
+ *      side effect - writes the decoded values into the four pixels
+ *      Channels are scaled to the denominator by truncation, as on the
+ *      float path. Safe to call from several threads at once.
+ ************************/
+void Fixed40_decode_block(uint32_t codeword, unsigned denominator,
+                          Pnm_rgb pixels[BLOCKAREA])
+{
+        pthread_once(&tables_once, build_tables);
+        STATS_COUNT(STATS_BLOCKS, 1);
+
+        /* fields index the tables directly, without sign extension */
+        STATS_START(unpack_start);
+        int32_t a = luma_a[codeword >> A_LSB];
+        const int32_t *b = luma_bcd[0][(codeword >> B_LSB) & 0x1f];
+        const int32_t *c = luma_bcd[1][(codeword >> C_LSB) & 0x1f];
+        const int32_t *d = luma_bcd[2][(codeword >> D_LSB) & 0x1f];
+        const int32_t *offset = chroma_offset[codeword & 0xff];
+        STATS_STOP(STATS_PACK, unpack_start);
+
+        STATS_START(idct_start);
+        int32_t y[BLOCKAREA];
+        for (int i = 0; i < BLOCKAREA; i++) {
+                y[i] = (a + b[i] + c[i] + d[i]) >> 8;
+        }
+        STATS_STOP(STATS_DCT, idct_start);
+
+        STATS_START(convert_start);
+        for (int i = 0; i < BLOCKAREA; i++) {
+                int32_t red = y[i] + offset[0];
+                int32_t green = y[i] + offset[1];
+                int32_t blue = y[i] + offset[2];
+
+                STATS_COUNT(STATS_CLAMPED_RGB,
+                            (red != clamp_q16(red))
+                            + (green != clamp_q16(green))
+                            + (blue != clamp_q16(blue)));
+
+                pixels[i]->red = ((uint64_t) clamp_q16(red) * denominator)
+                                 >> 16;
+                pixels[i]->green = ((uint64_t) clamp_q16(green) * denominator)
+                                   >> 16;
+                pixels[i]->blue = ((uint64_t) clamp_q16(blue) * denominator)
+                                  >> 16;
+        }
+        STATS_STOP(STATS_CONVERT, convert_start);
+}
@@ -0,0 +1,31 @@
+/**************************************************************
+*
+*                     fixed40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       fixed40.h declares the fixed-point block codec, an
+*       integer-only alternative to the float stages in codec40.c.
+*       It reads and writes the same codewords, so files from either
+*       path decode with the other. Codeword fields agree with the
+*       float path to within one quantization level, and decoded
+*       channels to within one 8-bit output step; at a denominator
+*       of 65535 that is a few units, as decoding works in Q16 (see
+*       bench40 -V).
+*
+**************************************************************/
+#ifndef FIXED40_INCLUDED
+#define FIXED40_INCLUDED
+
+#include <stdint.h>
+#include "codec40.h"
+
+/* pixels in order top-left, top-right, bottom-left, bottom-right */
+extern uint32_t Fixed40_encode_block(Pnm_rgb pixels[BLOCKAREA],
+                                     unsigned denominator);
+extern void Fixed40_decode_block(uint32_t codeword, unsigned denominator,
+                                 Pnm_rgb pixels[BLOCKAREA]);
+
+#endif
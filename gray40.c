@@ -0,0 +1,348 @@
+/**************************************************************
+*
+*                     gray40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       gray40.c implements the graymap codec. A graymap sample is
+*       already luma, so a block goes straight to the 2x2 DCT and the
+*       a, b, c, d quantizer in codec40.c, with no YPbPr conversion and
+*       no chroma averaging, and is packed into 24 bits:
+*
+*               a 9 bits @ 15, b 5 @ 10, c 5 @ 5, d 5 @ 0
+*
+*       Codewords are written as three big-endian bytes each, in
+*       row-major block order. Both directions stream two pixel rows
+*       at a time, so no whole-image array is built.
+*
+**************************************************************/
+#include "gray40.h"
+
+#include "assert.h"
+#include "mem.h"
+#include "pnm40.h"
+#include "bitpack.h"
+#include "stats40.h"
+
+#define BYTES_PER_CODEWORD 3
+#define NUM_GRAY_ELEMENTS 4
+
+/********** Gray CodeWord Templates **********
+ *
+ * bitfield templates for a 24-bit graymap codeword, as for CODEWORD_A..D
+ * in codec40.h with the chroma fields dropped
+ *
+ ************************/
+#define GRAY_CODEWORD_A { .value = 0, .isSigned = false, .width = 9, .lsb = 15 }
+#define GRAY_CODEWORD_B { .value = 0, .isSigned = true,  .width = 5, .lsb = 10 }
+#define GRAY_CODEWORD_C { .value = 0, .isSigned = true,  .width = 5, .lsb = 5  }
+#define GRAY_CODEWORD_D { .value = 0, .isSigned = true,  .width = 5, .lsb = 0  }
+
+
+/******************************************************************************
+ *
+ *                          SINGLE-BLOCK CODEC
+ *
+ *****************************************************************************/
+
+
+/********** Gray40_encode_block **********
+ *
+ * Compresses one 2x2 block of graymap samples into a 24-bit codeword
+ *
+ * Parameters:
+ *      const unsigned samples[BLOCKAREA] - The block's samples
+ *      unsigned denominator             - The graymap's maxval
+ *
+ * Return:
+ *      The codeword, in the low 24 bits
+ *
+ * Expects:
+ *      denominator > 0 and every sample is at most denominator
+ ************************/
+uint32_t Gray40_encode_block(const unsigned samples[BLOCKAREA],
+                             unsigned denominator)
+{
+        Block_Pixel_Info block;
+        STATS_COUNT(STATS_BLOCKS, 1);
+
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                block.compvidArr[block_i].y = (float) samples[block_i]
+                                              / denominator;
+        }
+
+        STATS_START(dct_start);
+        discrete_Cosine_Transform(&block);
+        STATS_STOP(STATS_DCT, dct_start);
+
+        STATS_START(quantize_start);
+        abcd_quantization(&block);
+        STATS_STOP(STATS_QUANTIZE, quantize_start);
+
+        STATS_START(pack_start);
+        CodeWord_Element code_elems[NUM_GRAY_ELEMENTS] = { GRAY_CODEWORD_A,
+                                                           GRAY_CODEWORD_B,
+                                                           GRAY_CODEWORD_C,
+                                                           GRAY_CODEWORD_D };
+        uint64_t codeword = 0;
+        for (int i = 0; i < NUM_GRAY_ELEMENTS; i++) {
+                if (code_elems[i].isSigned) {
+                        codeword = Bitpack_news(codeword, code_elems[i].width,
+                                                code_elems[i].lsb,
+                                                block.quantized_abcd[i]);
+                } else {
+                        codeword = Bitpack_newu(codeword, code_elems[i].width,
+                                                code_elems[i].lsb,
+                                                block.quantized_abcd[i]);
+                }
+        }
+        STATS_STOP(STATS_PACK, pack_start);
+        return codeword;
+}
+
+
+/********** Gray40_decode_block **********
+ *
+ * Decompresses a 24-bit codeword into a 2x2 block of samples
+ *
+ * Parameters:
+ *      uint32_t codeword    - The codeword to decode
+ *      unsigned denominator - Maxval of the output graymap
+ *      unsigned samples[BLOCKAREA] - Filled in with the block's samples
+ *
+ * Return:
+ *      None
+ *
+ * Notes:
+ *      Samples are scaled and clamped the way ComponentVideo_to_RGB
+ *      treats a channel
+ ************************/
+void Gray40_decode_block(uint32_t codeword, unsigned denominator,
+                         unsigned samples[BLOCKAREA])
+{
+        Block_Pixel_Info block;
+        STATS_COUNT(STATS_BLOCKS, 1);
+
+        STATS_START(unpack_start);
+        CodeWord_Element code_elems[NUM_GRAY_ELEMENTS] = { GRAY_CODEWORD_A,
+                                                           GRAY_CODEWORD_B,
+                                                           GRAY_CODEWORD_C,
+                                                           GRAY_CODEWORD_D };
+        for (int i = 0; i < NUM_GRAY_ELEMENTS; i++) {
+                block.quantized_abcd[i] = code_elems[i].isSigned
+                        ? Bitpack_gets(codeword, code_elems[i].width,
+                                       code_elems[i].lsb)
+                        : (int64_t) Bitpack_getu(codeword, code_elems[i].width,
+                                                 code_elems[i].lsb);
+        }
+        STATS_STOP(STATS_PACK, unpack_start);
+
+        STATS_START(idct_start);
+        inverse_discrete_Cosine_Transform(&block);
+        STATS_STOP(STATS_DCT, idct_start);
+
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                float y = block.compvidArr[block_i].y;
+                STATS_COUNT(STATS_CLAMPED_RGB, y < 0 || y > 1);
+
+                float value = y * denominator;
+                if (value < 0) {
+                        value = 0;
+                } else if (value > denominator) {
+                        value = denominator;
+                }
+                samples[block_i] = (unsigned) value;
+        }
+}
+
+
+/******************************************************************************
+ *
+ *                          GRAYMAP INPUT
+ *
+ *****************************************************************************/
+
+
+/********** Gray40_is_graymap **********
+ *
+ * Returns whether input starts with a P2 or P5 magic number
+ *
+ * Parameters:
+ *      FILE *input - The stream to look at
+ *
+ * Return:
+ *      true for a graymap, false otherwise
+ *
+ * Expects:
+ *      input is non-null
+ *
+ * Notes:
+ *      Both characters are pushed back with ungetc, which relies on the
+ *      C library allowing more than one character of push-back (glibc
+ *      does); the assert catches one that does not
+ ************************/
+bool Gray40_is_graymap(FILE *input)
+{
+        assert(input != NULL);
+
+        int magic = getc(input);
+        if (magic == EOF) {
+                return false;
+        }
+        int kind = getc(input);
+        if (kind != EOF) {
+                int pushed = ungetc(kind, input);
+                assert(pushed == kind);
+        }
+        int pushed = ungetc(magic, input);
+        assert(pushed == magic);
+
+        return magic == 'P' && (kind == '2' || kind == '5');
+}
+
+
+/********** Gray40_compress **********
+ *
+ * Reads a graymap from input and writes it to output in format 4
+ *
+ * Parameters:
+ *      FILE *input  - A stream holding a P2 or P5 graymap
+ *      FILE *output - The stream to write to
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null
+ *      CRE if input is not a well-formed P2 or P5 graymap
+ *
+ * Notes:
+ *      Odd last rows and columns are trimmed, as Codec40_trim does
+ ************************/
+void Gray40_compress(FILE *input, FILE *output)
+{
+        assert(input != NULL && output != NULL);
+
+        STATS_START(read_start);
+        Pnm40_T reader = Pnm40_open(input);
+        assert(Pnm40_channels(reader) == 1);
+        unsigned file_width = Pnm40_width(reader);
+        unsigned denominator = Pnm40_maxval(reader);
+        unsigned width = file_width - file_width % BLOCKSIZE;
+        unsigned height = Pnm40_height(reader)
+                          - Pnm40_height(reader) % BLOCKSIZE;
+        STATS_STOP(STATS_READ, read_start);
+
+        fprintf(output, "COMP40 Compressed image format %d\n%u %u\n",
+                GRAY40_FORMAT, width, height);
+
+        size_t blocks_wide = width / BLOCKSIZE;
+        unsigned *rows = ALLOC(BLOCKSIZE * (size_t) file_width
+                               * sizeof(unsigned) + 1);
+        unsigned char *bytes = ALLOC(blocks_wide * BYTES_PER_CODEWORD + 1);
+        unsigned *top = rows;
+        unsigned *bottom = rows + file_width;
+
+        for (unsigned row = 0; row < height; row += BLOCKSIZE) {
+                STATS_START(row_start);
+                Pnm40_read_row(reader, top);
+                Pnm40_read_row(reader, bottom);
+                STATS_STOP(STATS_READ, row_start);
+
+                for (size_t block = 0; block < blocks_wide; block++) {
+                        size_t col = block * BLOCKSIZE;
+                        unsigned samples[BLOCKAREA] = {
+                                top[col], top[col + 1],
+                                bottom[col], bottom[col + 1]
+                        };
+                        uint32_t codeword = Gray40_encode_block(
+                                                samples, denominator);
+                        unsigned char *out = bytes
+                                             + block * BYTES_PER_CODEWORD;
+                        out[0] = codeword >> 16;
+                        out[1] = codeword >> 8;
+                        out[2] = codeword;
+                }
+
+                STATS_START(write_start);
+                size_t wrote = fwrite(bytes, BYTES_PER_CODEWORD, blocks_wide,
+                                      output);
+                assert(wrote == blocks_wide);
+                STATS_STOP(STATS_WRITE, write_start);
+        }
+
+        FREE(bytes);
+        FREE(rows);
+        Pnm40_close(&reader);
+}
+
+
+/********** Gray40_decompress **********
+ *
+ * Reads format 4 codewords and writes the image as a P5 graymap
+ *
+ * Parameters:
+ *      FILE *input     - Stream positioned just after the header
+ *      unsigned width  - Image width from the header
+ *      unsigned height - Image height from the header
+ *      FILE *output    - The stream to write to
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null
+ *      CRE if input ends before every codeword has been read
+ *
+ * Notes:
+ *      The graymap's maxval is DECOMPRESSION_IMAGE_DENOMINATOR
+ ************************/
+void Gray40_decompress(FILE *input, unsigned width, unsigned height,
+                       FILE *output)
+{
+        assert(input != NULL && output != NULL);
+        assert(width % BLOCKSIZE == 0 && height % BLOCKSIZE == 0);
+
+        fprintf(output, "P5\n%u %u\n%u\n", width, height,
+                DECOMPRESSION_IMAGE_DENOMINATOR);
+
+        size_t blocks_wide = width / BLOCKSIZE;
+        unsigned char *bytes = ALLOC(blocks_wide * BYTES_PER_CODEWORD + 1);
+        unsigned char *rows = ALLOC(BLOCKSIZE * (size_t) width + 1);
+        unsigned char *top = rows;
+        unsigned char *bottom = rows + width;
+
+        for (unsigned row = 0; row < height; row += BLOCKSIZE) {
+                STATS_START(read_start);
+                size_t got = fread(bytes, BYTES_PER_CODEWORD, blocks_wide,
+                                   input);
+                assert(got == blocks_wide);
+                STATS_STOP(STATS_READ, read_start);
+
+                for (size_t block = 0; block < blocks_wide; block++) {
+                        unsigned char *in = bytes + block * BYTES_PER_CODEWORD;
+                        uint32_t codeword = (uint32_t) in[0] << 16
+                                            | (uint32_t) in[1] << 8 | in[2];
+                        unsigned samples[BLOCKAREA];
+                        Gray40_decode_block(codeword,
+                                            DECOMPRESSION_IMAGE_DENOMINATOR,
+                                            samples);
+                        size_t col = block * BLOCKSIZE;
+                        top[col] = samples[0];
+                        top[col + 1] = samples[1];
+                        bottom[col] = samples[2];
+                        bottom[col + 1] = samples[3];
+                }
+
+                STATS_START(write_start);
+                size_t wrote = fwrite(rows, 1, BLOCKSIZE * (size_t) width,
+                                      output);
+                assert(wrote == BLOCKSIZE * (size_t) width);
+                STATS_STOP(STATS_WRITE, write_start);
+        }
+
+        FREE(rows);
+        FREE(bytes);
+}
@@ -0,0 +1,45 @@
+/**************************************************************
+*
+*                     gray40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       gray40.h declares the graymap codec. P2/P5 input has no
+*       chroma, so its blocks skip colour conversion entirely and are
+*       packed as a, b, c, d only, in 24-bit codewords written to
+*       compressed image format 4. Decoding it produces a P5 graymap.
+*
+**************************************************************/
+#ifndef GRAY40_INCLUDED
+#define GRAY40_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "codec40.h"
+
+/* format number in the header of a compressed graymap */
+#define GRAY40_FORMAT 4
+
+/* samples in order top-left, top-right, bottom-left, bottom-right */
+extern uint32_t Gray40_encode_block(const unsigned samples[BLOCKAREA],
+                                    unsigned denominator);
+extern void Gray40_decode_block(uint32_t codeword, unsigned denominator,
+                                unsigned samples[BLOCKAREA]);
+
+/* true if input starts with a P2 or P5 magic number; consumes nothing */
+extern bool Gray40_is_graymap(FILE *input);
+
+/* reads a P2 or P5 graymap from input and writes format 4 to output */
+extern void Gray40_compress(FILE *input, FILE *output);
+
+/*
+ * Reads the codewords of a format 4 file whose header Codec40_read_header
+ * has already consumed, and writes the image to output as a P5 graymap
+ */
+extern void Gray40_decompress(FILE *input, unsigned width, unsigned height,
+                              FILE *output);
+
+#endif
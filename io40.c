@@ -0,0 +1,472 @@
+/**************************************************************
+*
+*                     io40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       io40.c implements the asynchronous whole-file I/O backend.
+*
+*       Every request is a Request record that owns an open file
+*       descriptor and a buffer. With io_uring, a request is one
+*       read or write SQE at a time; short transfers are resubmitted
+*       from where they stopped until the whole buffer is done. The
+*       pread/pwrite fallback runs the same loop synchronously. In
+*       both cases finished requests (and ones that fail or need no
+*       I/O at all, like an empty file) go on a FIFO of completions
+*       that Io40_wait hands back to the caller.
+*
+**************************************************************/
+#include "io40.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "assert.h"
+#include "mem.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#define T Io40_T
+
+/* largest single transfer; io_uring lengths are 32-bit */
+#define MAX_TRANSFER (1u << 30)
+
+/********** Request **********
+ *
+ * struct to hold one read or write from submission to completion
+ *
+ * Contains:
+ *      Io40_Kind kind
+ *          read or write
+ *
+ *      int fd
+ *          the open file, closed when the request completes
+ *
+ *      void *tag
+ *          caller's tag
+ *
+ *      unsigned char *data, size_t length, size_t done
+ *          the buffer, its size, and how much has been transferred
+ *
+ *      int error
+ *          errno value if the request failed
+ *
+ *      struct Request *next
+ *          link in the completion queue
+ *
+ ************************/
+typedef struct Request {
+        Io40_Kind kind;
+        int fd;
+        void *tag;
+        unsigned char *data;
+        size_t length;
+        size_t done;
+        int error;
+        struct Request *next;
+} Request;
+
+/********** Io40_T **********
+ *
+ * struct to hold the state of the backend
+ *
+ * Contains:
+ *      unsigned depth
+ *          maximum requests in flight
+ *
+ *      unsigned pending
+ *          requests submitted and not yet collected
+ *
+ *      Request *first, *last
+ *          FIFO of finished requests
+ *
+ *      bool uring, struct io_uring ring
+ *          whether the io_uring is in use, and the ring itself
+ *
+ ************************/
+struct T {
+        unsigned depth;
+        unsigned pending;
+        Request *first;
+        Request *last;
+        bool uring;
+#ifdef HAVE_LIBURING
+        struct io_uring ring;
+#endif
+};
+
+
+/********** complete **********
+ *
+ * Closes a request's file and adds it to the completion queue
+ *
+ ************************/
+static void complete(T io, Request *req)
+{
+        close(req->fd);
+        req->next = NULL;
+        if (io->last == NULL) {
+                io->first = req;
+        } else {
+                io->last->next = req;
+        }
+        io->last = req;
+}
+
+
+/********** transfer_size **********
+ *
+ * Returns how many bytes the next transfer of req should move
+ *
+ ************************/
+static size_t transfer_size(Request *req)
+{
+        size_t left = req->length - req->done;
+        return left > MAX_TRANSFER ? MAX_TRANSFER : left;
+}
+
+
+/********** run_sync **********
+ *
+ * Carries out the whole of req with pread or pwrite, then completes it
+ *
+ ************************/
+static void run_sync(T io, Request *req)
+{
+        while (req->done < req->length) {
+                ssize_t n;
+                if (req->kind == IO40_READ) {
+                        n = pread(req->fd, req->data + req->done,
+                                  transfer_size(req), req->done);
+                } else {
+                        n = pwrite(req->fd, req->data + req->done,
+                                   transfer_size(req), req->done);
+                }
+                if (n < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (n <= 0) {
+                        req->error = n < 0 ? errno : EIO;
+                        break;
+                }
+                req->done += n;
+        }
+        complete(io, req);
+}
+
+
+#ifdef HAVE_LIBURING
+
+/********** submit_uring **********
+ *
+ * Queues the next transfer of req on the ring
+ *
+ * Notes:
+ *      At most depth requests are ever pending, so an SQE is always free
+ ************************/
+static void submit_uring(T io, Request *req)
+{
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&io->ring);
+        assert(sqe != NULL);
+
+        if (req->kind == IO40_READ) {
+                io_uring_prep_read(sqe, req->fd, req->data + req->done,
+                                   transfer_size(req), req->done);
+        } else {
+                io_uring_prep_write(sqe, req->fd, req->data + req->done,
+                                    transfer_size(req), req->done);
+        }
+        io_uring_sqe_set_data(sqe, req);
+        int submitted = io_uring_submit(&io->ring);
+        assert(submitted == 1);
+}
+
+
+/********** reap_uring **********
+ *
+ * Handles one CQE from the ring, waiting for it if block is true
+ *
+ * Return:
+ *      true if a CQE was handled
+ *
+ * Notes:
+ *      A short transfer is resubmitted rather than completed
+ ************************/
+static bool reap_uring(T io, bool block)
+{
+        struct io_uring_cqe *cqe;
+        int err = block ? io_uring_wait_cqe(&io->ring, &cqe)
+                        : io_uring_peek_cqe(&io->ring, &cqe);
+        if (err == -EINTR || err == -EAGAIN) {
+                return false;
+        }
+        assert(err == 0);
+
+        Request *req = io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&io->ring, cqe);
+
+        if (res == -EINTR || res == -EAGAIN) {
+                submit_uring(io, req);
+        } else if (res <= 0) {
+                req->error = res < 0 ? -res : EIO;
+                complete(io, req);
+        } else {
+                req->done += res;
+                if (req->done < req->length) {
+                        submit_uring(io, req);
+                } else {
+                        complete(io, req);
+                }
+        }
+        return true;
+}
+
+#endif
+
+
+/********** start **********
+ *
+ * Starts a request that has its file open and buffer ready
+ *
+ ************************/
+static void start(T io, Request *req)
+{
+        io->pending++;
+        if (req->length == 0) {
+                complete(io, req);
+                return;
+        }
+#ifdef HAVE_LIBURING
+        if (io->uring) {
+                submit_uring(io, req);
+                return;
+        }
+#endif
+        run_sync(io, req);
+}
+
+
+/********** Io40_new **********
+ *
+ * Creates an I/O backend
+ *
+ * Parameters:
+ *      unsigned depth - Maximum number of requests in flight at once
+ *
+ * Return:
+ *      The new backend, freed with Io40_free
+ *
+ * Expects:
+ *      depth > 0
+ *
+ * Notes:
+ *      Falls back to pread/pwrite if the io_uring cannot be set up
+ ************************/
+T Io40_new(unsigned depth)
+{
+        assert(depth > 0);
+
+        T io;
+        NEW(io);
+        io->depth = depth;
+        io->pending = 0;
+        io->first = NULL;
+        io->last = NULL;
+        io->uring = false;
+#ifdef HAVE_LIBURING
+        io->uring = io_uring_queue_init(depth, &io->ring, 0) == 0;
+#endif
+        return io;
+}
+
+
+/********** Io40_free **********
+ *
+ * Frees an I/O backend
+ *
+ * Expects:
+ *      io and *io are non-null, and every request has been collected
+ ************************/
+void Io40_free(T *io)
+{
+        assert(io != NULL && *io != NULL);
+        assert((*io)->pending == 0);
+#ifdef HAVE_LIBURING
+        if ((*io)->uring) {
+                io_uring_queue_exit(&(*io)->ring);
+        }
+#endif
+        FREE(*io);
+}
+
+
+/********** Io40_backend **********
+ *
+ * Returns the name of the mechanism the backend uses
+ *
+ ************************/
+const char *Io40_backend(T io)
+{
+        assert(io != NULL);
+        return io->uring ? "io_uring" : "pread";
+}
+
+
+/********** Io40_read_file **********
+ *
+ * Opens a file and submits a read of the whole of it
+ *
+ * Parameters:
+ *      T io             - The backend
+ *      const char *path - File to read
+ *      void *tag        - Returned with the completion
+ *
+ * Return:
+ *      true if the read was submitted, false (with errno set) if the file
+ *      could not be opened
+ *
+ * Expects:
+ *      io and path are non-null and fewer than depth requests are pending
+ ************************/
+bool Io40_read_file(T io, const char *path, void *tag)
+{
+        assert(io != NULL && path != NULL);
+        assert(io->pending < io->depth);
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+                return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) < 0) {
+                int saved = errno;
+                close(fd);
+                errno = saved;
+                return false;
+        }
+
+        Request *req;
+        NEW(req);
+        req->kind = IO40_READ;
+        req->fd = fd;
+        req->tag = tag;
+        req->length = info.st_size;
+        req->data = ALLOC(req->length + 1);
+        req->done = 0;
+        req->error = 0;
+        start(io, req);
+        return true;
+}
+
+
+/********** Io40_write_file **********
+ *
+ * Creates (or truncates) a file and submits a write of data to it
+ *
+ * Parameters:
+ *      T io                - The backend
+ *      const char *path    - File to write
+ *      unsigned char *data - Bytes to write; must outlive the request
+ *      size_t length       - Number of bytes
+ *      void *tag           - Returned with the completion
+ *
+ * Return:
+ *      true if the write was submitted, false (with errno set) if the file
+ *      could not be created
+ *
+ * Expects:
+ *      io and path are non-null and fewer than depth requests are pending
+ ************************/
+bool Io40_write_file(T io, const char *path, unsigned char *data,
+                     size_t length, void *tag)
+{
+        assert(io != NULL && path != NULL);
+        assert(data != NULL || length == 0);
+        assert(io->pending < io->depth);
+
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0) {
+                return false;
+        }
+
+        Request *req;
+        NEW(req);
+        req->kind = IO40_WRITE;
+        req->fd = fd;
+        req->tag = tag;
+        req->data = data;
+        req->length = length;
+        req->done = 0;
+        req->error = 0;
+        start(io, req);
+        return true;
+}
+
+
+/********** Io40_pending **********
+ *
+ * Returns the number of requests submitted but not yet collected
+ *
+ ************************/
+unsigned Io40_pending(T io)
+{
+        assert(io != NULL);
+        return io->pending;
+}
+
+
+/********** Io40_wait **********
+ *
+ * Collects the next finished request
+ *
+ * Parameters:
+ *      T io                 - The backend
+ *      Io40_Completion *done - Filled in with the finished request
+ *      bool block           - Whether to wait if nothing has finished yet
+ *
+ * Return:
+ *      true if *done was filled in
+ *
+ * Expects:
+ *      io and done are non-null
+ ************************/
+bool Io40_wait(T io, Io40_Completion *done, bool block)
+{
+        assert(io != NULL && done != NULL);
+
+#ifdef HAVE_LIBURING
+        if (io->uring) {
+                /* drain what is ready, then wait if asked and still empty */
+                while (reap_uring(io, false)) {
+                }
+                while (io->first == NULL && block && io->pending > 0) {
+                        reap_uring(io, true);
+                }
+        }
+#else
+        (void)block;    /* pread requests are finished when submitted */
+#endif
+        Request *req = io->first;
+        if (req == NULL) {
+                return false;
+        }
+        io->first = req->next;
+        if (io->first == NULL) {
+                io->last = NULL;
+        }
+        io->pending--;
+
+        done->kind = req->kind;
+        done->tag = req->tag;
+        done->data = req->data;
+        done->length = req->done;
+        done->error = req->error;
+        FREE(req);
+        return true;
+}
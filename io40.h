@@ -0,0 +1,94 @@
+/**************************************************************
+*
+*                     io40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       io40.h is the interface to the asynchronous whole-file I/O
+*       backend used by batch mode. A caller submits reads of input
+*       files and writes of finished outputs, keeps computing, and
+*       collects completions as they arrive.
+*
+*       When built with HAVE_LIBURING (make URING=1) requests go through
+*       a Linux io_uring, so up to the queue depth of them are in flight
+*       at once. Otherwise, or if the kernel refuses to set up a ring,
+*       each request is carried out with pread/pwrite when it is
+*       submitted and its completion is queued straight away.
+*
+**************************************************************/
+#ifndef IO40_INCLUDED
+#define IO40_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define T Io40_T
+typedef struct T *T;
+
+/********** Io40_Kind **********
+ *
+ * the kind of request a completion belongs to
+ *
+ ************************/
+typedef enum Io40_Kind {
+        IO40_READ = 0,
+        IO40_WRITE
+} Io40_Kind;
+
+/********** Io40_Completion **********
+ *
+ * struct to hold the result of one finished request
+ *
+ * Contains:
+ *      Io40_Kind kind
+ *          whether a read or a write finished
+ *
+ *      void *tag
+ *          the tag passed when the request was submitted
+ *
+ *      unsigned char *data, size_t length
+ *          for a read, the whole file in a buffer the caller frees with
+ *          FREE; for a write, the buffer that was passed in
+ *
+ *      int error
+ *          0 on success, otherwise an errno value
+ *
+ ************************/
+typedef struct Io40_Completion {
+        Io40_Kind kind;
+        void *tag;
+        unsigned char *data;
+        size_t length;
+        int error;
+} Io40_Completion;
+
+/* creates a backend that keeps at most depth requests in flight */
+extern T Io40_new(unsigned depth);
+extern void Io40_free(T *io);
+
+/* "io_uring" or "pread", whichever the backend ended up using */
+extern const char *Io40_backend(T io);
+
+/*
+ * Submit requests. The file is opened straight away: if that fails, no
+ * request is made, errno is set, and false is returned. A write's data
+ * must stay valid until its completion is collected.
+ */
+extern bool Io40_read_file(T io, const char *path, void *tag);
+extern bool Io40_write_file(T io, const char *path, unsigned char *data,
+                            size_t length, void *tag);
+
+/* requests submitted but not yet collected */
+extern unsigned Io40_pending(T io);
+
+/*
+ * Collects one completion into *done. If none is ready, waits for one when
+ * block is true and there is a request in flight, and otherwise returns
+ * false.
+ */
+extern bool Io40_wait(T io, Io40_Completion *done, bool block);
+
+#undef T
+#endif
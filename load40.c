@@ -0,0 +1,382 @@
+/**************************************************************
+*
+*                     load40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       load40.c is a load generator for server mode (40image --serve).
+*       It sends one image to the server over and over, as compress
+*       requests (or, with -d, decompress requests), from several
+*       connections at once, each waiting for its answer before sending
+*       its next request. When all requests are answered it prints the
+*       requests per second achieved and percentiles of the time from
+*       sending a request to having its whole answer.
+*
+*       One request is made before the clock starts, to check that the
+*       server answers and to keep its result; every timed answer must
+*       match it byte for byte, and any that does not, or any error
+*       answer, is counted as failed.
+*
+*       Usage:
+*               load40 [-d] [-n requests] [-c connections] socket image
+*
+**************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "assert.h"
+#include "mem.h"
+#include "wire40.h"
+
+#define DEFAULT_REQUESTS 1000
+#define DEFAULT_CONNECTIONS 4
+#define MAX_CONNECTIONS 256
+#define NS_PER_SEC 1e9
+#define NS_PER_MS 1e6
+
+/********** Load **********
+ *
+ * struct to hold the state shared by the connection threads
+ *
+ * Contains:
+ *      const char *path
+ *          the server's socket
+ *
+ *      unsigned char tag, unsigned char *image, size_t image_length
+ *          the request sent every time
+ *
+ *      unsigned char *expected, size_t expected_length
+ *          the answer to the untimed first request
+ *
+ *      size_t num_requests, next
+ *          requests to send, and the index of the next one to send,
+ *          taken atomically
+ *
+ *      double *latencies
+ *          time in ns each request took, by index
+ *
+ *      size_t failed
+ *          requests answered with an error or a different result, or
+ *          never sent because a connection broke; added to atomically
+ *
+ ************************/
+typedef struct Load {
+        const char *path;
+        unsigned char tag;
+        unsigned char *image;
+        size_t image_length;
+        unsigned char *expected;
+        size_t expected_length;
+        size_t num_requests;
+        size_t next;
+        double *latencies;
+        size_t failed;
+} Load;
+
+
+/********** now_ns **********
+ *
+ * Returns the current value of the monotonic clock in nanoseconds
+ *
+ ************************/
+static double now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+
+/********** read_file **********
+ *
+ * Reads the whole file at path into a new buffer
+ *
+ * Return:
+ *      the buffer, freed with FREE, or NULL after reporting the error
+ ************************/
+static unsigned char *read_file(const char *path, size_t *length)
+{
+        FILE *fp = fopen(path, "rb");
+        if (fp == NULL) {
+                perror(path);
+                return NULL;
+        }
+        size_t capacity = 1 << 16;
+        unsigned char *bytes = ALLOC(capacity);
+        *length = 0;
+        for (;;) {
+                *length += fread(bytes + *length, 1, capacity - *length, fp);
+                if (*length < capacity) {
+                        break;
+                }
+                capacity *= 2;
+                RESIZE(bytes, capacity);
+        }
+        fclose(fp);
+        return bytes;
+}
+
+
+/********** connection_main **********
+ *
+ * Connection thread: sends requests until all have been taken, timing
+ * each one
+ *
+ ************************/
+static void *connection_main(void *arg)
+{
+        Load *load = arg;
+        unsigned char *answer = NULL;
+        size_t capacity = 0;
+        int fd = Wire40_connect(load->path);
+
+        for (;;) {
+                size_t index = __atomic_fetch_add(&load->next, 1,
+                                                  __ATOMIC_RELAXED);
+                if (index >= load->num_requests) {
+                        break;
+                }
+                unsigned char tag;
+                size_t length;
+                double start = now_ns();
+                if (fd < 0
+                    || !Wire40_write(fd, load->tag, load->image,
+                                     load->image_length)
+                    || Wire40_read(fd, &tag, &answer, &capacity, &length,
+                                   WIRE40_MAX_LENGTH) != WIRE40_FRAME) {
+                        /* this connection is broken: count what it had left */
+                        __atomic_fetch_add(&load->failed, 1,
+                                           __ATOMIC_RELAXED);
+                        load->latencies[index] = 0;
+                        if (fd >= 0) {
+                                close(fd);
+                                fd = -1;
+                        }
+                        continue;
+                }
+                load->latencies[index] = now_ns() - start;
+                if (tag != WIRE40_OK || length != load->expected_length
+                    || memcmp(answer, load->expected, length) != 0) {
+                        __atomic_fetch_add(&load->failed, 1,
+                                           __ATOMIC_RELAXED);
+                }
+        }
+
+        if (fd >= 0) {
+                close(fd);
+        }
+        free(answer);
+        return NULL;
+}
+
+
+/********** compare_doubles **********
+ *
+ * qsort comparison for ascending doubles
+ *
+ ************************/
+static int compare_doubles(const void *a, const void *b)
+{
+        double x = *(const double *) a;
+        double y = *(const double *) b;
+        return (x > y) - (x < y);
+}
+
+
+/********** percentile **********
+ *
+ * Returns the smallest of the n sorted values that at least fraction of
+ * them are no larger than
+ *
+ ************************/
+static double percentile(const double *sorted, size_t n, double fraction)
+{
+        size_t rank = (size_t) (fraction * n + 0.999999);
+        if (rank < 1) {
+                rank = 1;
+        }
+        if (rank > n) {
+                rank = n;
+        }
+        return sorted[rank - 1];
+}
+
+
+/********** report **********
+ *
+ * Prints throughput and latency percentiles for a finished run
+ *
+ * Parameters:
+ *      Load *load       - the run, its latencies filled in
+ *      int connections  - connections used
+ *      double elapsed   - ns from the first request sent to the last
+ *                         answer received
+ *
+ * Notes:
+ *      Failed requests are left out of the percentiles
+ ************************/
+static void report(Load *load, int connections, double elapsed)
+{
+        double *timed = ALLOC(load->num_requests * sizeof(double));
+        size_t n = 0;
+        double total = 0;
+        for (size_t i = 0; i < load->num_requests; i++) {
+                if (load->latencies[i] > 0) {
+                        timed[n++] = load->latencies[i];
+                        total += load->latencies[i];
+                }
+        }
+        qsort(timed, n, sizeof(double), compare_doubles);
+
+        double seconds = elapsed / NS_PER_SEC;
+        printf("%zu requests on %d connections in %.3f s: %.1f requests/s, "
+               "%.1f MB/s in, %.1f MB/s out\n",
+               load->num_requests, connections, seconds,
+               load->num_requests / seconds,
+               load->num_requests * load->image_length / seconds / 1e6,
+               load->num_requests * load->expected_length / seconds / 1e6);
+        if (n > 0) {
+                printf("latency ms: mean %.3f  p50 %.3f  p90 %.3f  "
+                       "p99 %.3f  p99.9 %.3f  max %.3f\n",
+                       total / n / NS_PER_MS,
+                       percentile(timed, n, 0.5) / NS_PER_MS,
+                       percentile(timed, n, 0.9) / NS_PER_MS,
+                       percentile(timed, n, 0.99) / NS_PER_MS,
+                       percentile(timed, n, 0.999) / NS_PER_MS,
+                       timed[n - 1] / NS_PER_MS);
+        }
+        if (load->failed > 0) {
+                printf("%zu requests failed\n", load->failed);
+        }
+        FREE(timed);
+}
+
+
+/********** first_request **********
+ *
+ * Makes the untimed first request and keeps its answer in load
+ *
+ * Return:
+ *      true if the server answered it successfully
+ ************************/
+static bool first_request(Load *load)
+{
+        size_t capacity = 0;
+        unsigned char tag;
+        int fd = Wire40_connect(load->path);
+        if (fd < 0) {
+                perror(load->path);
+                return false;
+        }
+        /* a server refusing a request may close before reading all of
+         * it, so look for its answer even if the write failed */
+        Wire40_write(fd, load->tag, load->image, load->image_length);
+        bool answered = Wire40_read(fd, &tag, &load->expected, &capacity,
+                                    &load->expected_length,
+                                    WIRE40_MAX_LENGTH) == WIRE40_FRAME;
+        close(fd);
+        if (!answered) {
+                fprintf(stderr, "%s: no answer from the server\n",
+                        load->path);
+                return false;
+        }
+        if (tag != WIRE40_OK) {
+                fprintf(stderr, "%s: server error: %.*s", load->path,
+                        (int) load->expected_length, load->expected);
+                return false;
+        }
+        return true;
+}
+
+
+/********** usage **********
+ *
+ * Prints the command line usage and exits with failure
+ *
+ ************************/
+static void usage(const char *progname)
+{
+        fprintf(stderr, "Usage: %s [-d] [-n requests] [-c connections] "
+                "socket image\n", progname);
+        exit(1);
+}
+
+
+/********** main **********
+ *
+ * Parses the command line, then runs the load and reports on it
+ *
+ * Return:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the server could not be reached
+ *      or any request failed
+ ************************/
+int main(int argc, char *argv[])
+{
+        Load load = { .tag = WIRE40_COMPRESS,
+                      .num_requests = DEFAULT_REQUESTS };
+        int connections = DEFAULT_CONNECTIONS;
+        int i;
+
+        for (i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-d") == 0) {
+                        load.tag = WIRE40_DECOMPRESS;
+                } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+                        long n = atol(argv[++i]);
+                        if (n < 1) {
+                                usage(argv[0]);
+                        }
+                        load.num_requests = n;
+                } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+                        connections = atoi(argv[++i]);
+                        if (connections < 1 || connections > MAX_CONNECTIONS) {
+                                usage(argv[0]);
+                        }
+                } else if (argv[i][0] == '-') {
+                        usage(argv[0]);
+                } else {
+                        break;
+                }
+        }
+        if (argc - i != 2) {
+                usage(argv[0]);
+        }
+        load.path = argv[i];
+
+        load.image = read_file(argv[i + 1], &load.image_length);
+        if (load.image == NULL) {
+                return EXIT_FAILURE;
+        }
+        if (load.image_length > WIRE40_MAX_LENGTH) {
+                fprintf(stderr, "%s: too large to send\n", argv[i + 1]);
+                return EXIT_FAILURE;
+        }
+        if (!first_request(&load)) {
+                return EXIT_FAILURE;
+        }
+
+        load.latencies = CALLOC(load.num_requests, sizeof(double));
+        pthread_t threads[MAX_CONNECTIONS];
+        double start = now_ns();
+        for (int c = 0; c < connections; c++) {
+                int error = pthread_create(&threads[c], NULL, connection_main,
+                                           &load);
+                assert(error == 0);
+        }
+        for (int c = 0; c < connections; c++) {
+                pthread_join(threads[c], NULL);
+        }
+        double elapsed = now_ns() - start;
+
+        report(&load, connections, elapsed);
+
+        FREE(load.latencies);
+        free(load.expected);
+        FREE(load.image);
+        return load.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
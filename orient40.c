@@ -0,0 +1,292 @@
+/**************************************************************
+*
+*                     orient40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       orient40.c implements rotation and flipping of compressed
+*       images. With pixels Y1 Y2 / Y3 Y4 and
+*
+*               b = (Y4 + Y3 - Y2 - Y1) / 4    (bottom minus top)
+*               c = (Y4 - Y3 + Y2 - Y1) / 4    (right minus left)
+*               d = (Y4 - Y3 - Y2 + Y1) / 4    (diagonal)
+*
+*       a transpose swaps Y2 and Y3 and so swaps b and c; a horizontal
+*       flip swaps the columns and negates c and d; a vertical flip
+*       swaps the rows and negates b and d. a and the chroma averages
+*       are unchanged by all three. The quantized b, c, d fields lie in
+*       [-15, 15], so negating them is exact.
+*
+*       Every orientation is kept as transpose, then hflip, then vflip;
+*       adding a rotation or flip afterwards is rewritten into that
+*       form using T.H = V.T and T.V = H.T.
+*
+**************************************************************/
+#include "orient40.h"
+
+#include "assert.h"
+#include "bitpack.h"
+#include "a2plain.h"
+#include "a2parallel.h"
+#include "codec40.h"
+
+#define A2 A2Methods_UArray2
+
+/********** Orient_Closure **********
+ *
+ * struct passed to applyOrient
+ *
+ * Contains:
+ *      A2 result
+ *          the reoriented codewords being filled in
+ *
+ *      Orient40 orientation
+ *          the orientation to apply
+ *
+ ************************/
+typedef struct Orient_Closure {
+        A2 result;
+        Orient40 orientation;
+} Orient_Closure;
+
+
+/********** add_transpose **********
+ *
+ * Adds a transpose after orientation
+ *
+ ************************/
+static void add_transpose(Orient40 *orientation)
+{
+        bool hflip = orientation->hflip;
+        orientation->hflip = orientation->vflip;
+        orientation->vflip = hflip;
+        orientation->transpose = !orientation->transpose;
+}
+
+
+/********** Orient40_rotate **********
+ *
+ * Adds a clockwise rotation after orientation
+ *
+ * Parameters:
+ *      Orient40 *orientation - The orientation to update
+ *      unsigned degrees      - 0, 90, 180, or 270
+ *
+ * Return:
+ *      true, or false (leaving orientation alone) for any other angle
+ *
+ * Expects:
+ *      orientation is non-null
+ *
+ * Notes:
+ *      90 is a transpose then an hflip; 270 a transpose then a vflip
+ ************************/
+bool Orient40_rotate(Orient40 *orientation, unsigned degrees)
+{
+        assert(orientation != NULL);
+
+        switch (degrees) {
+        case 0:
+                return true;
+        case 90:
+                add_transpose(orientation);
+                orientation->hflip = !orientation->hflip;
+                return true;
+        case 180:
+                orientation->hflip = !orientation->hflip;
+                orientation->vflip = !orientation->vflip;
+                return true;
+        case 270:
+                add_transpose(orientation);
+                orientation->vflip = !orientation->vflip;
+                return true;
+        default:
+                return false;
+        }
+}
+
+
+/********** Orient40_flip **********
+ *
+ * Adds a flip after orientation
+ *
+ * Parameters:
+ *      Orient40 *orientation - The orientation to update
+ *      char axis             - 'h' to mirror left to right, 'v' top to
+ *                              bottom
+ *
+ * Return:
+ *      true, or false (leaving orientation alone) for any other axis
+ *
+ * Expects:
+ *      orientation is non-null
+ ************************/
+bool Orient40_flip(Orient40 *orientation, char axis)
+{
+        assert(orientation != NULL);
+
+        if (axis == 'h') {
+                orientation->hflip = !orientation->hflip;
+        } else if (axis == 'v') {
+                orientation->vflip = !orientation->vflip;
+        } else {
+                return false;
+        }
+        return true;
+}
+
+
+/********** Orient40_codeword **********
+ *
+ * Rewrites a codeword's b, c, and d fields for the block reoriented
+ *
+ * Parameters:
+ *      uint32_t codeword    - A format 2/3 codeword (not a repeat token)
+ *      Orient40 orientation - The orientation to apply
+ *
+ * Return:
+ *      The codeword of the reoriented block
+ *
+ * Notes:
+ *      a, Pb, and Pr are copied unchanged
+ ************************/
+uint32_t Orient40_codeword(uint32_t codeword, Orient40 orientation)
+{
+        CodeWord_Element fields[3] = { CODEWORD_B, CODEWORD_C, CODEWORD_D };
+        int64_t b = Bitpack_gets(codeword, fields[0].width, fields[0].lsb);
+        int64_t c = Bitpack_gets(codeword, fields[1].width, fields[1].lsb);
+        int64_t d = Bitpack_gets(codeword, fields[2].width, fields[2].lsb);
+
+        if (orientation.transpose) {
+                int64_t swap = b;
+                b = c;
+                c = swap;
+        }
+        if (orientation.hflip) {
+                c = -c;
+                d = -d;
+        }
+        if (orientation.vflip) {
+                b = -b;
+                d = -d;
+        }
+
+        uint64_t word = codeword;
+        word = Bitpack_news(word, fields[0].width, fields[0].lsb, b);
+        word = Bitpack_news(word, fields[1].width, fields[1].lsb, c);
+        word = Bitpack_news(word, fields[2].width, fields[2].lsb, d);
+        return word;
+}
+
+
+/********** applyOrient **********
+ *
+ * Apply function that moves one codeword to its reoriented block and
+ * rewrites it
+ *
+ ************************/
+static void applyOrient(int col, int row, A2 codewords, void *elem, void *cl)
+{
+        (void)codewords;
+        Orient_Closure *closure = cl;
+        A2Methods_T methods = uarray2_methods_plain;
+        Orient40 orientation = closure->orientation;
+
+        if (orientation.transpose) {
+                int swap = col;
+                col = row;
+                row = swap;
+        }
+        if (orientation.hflip) {
+                col = methods->width(closure->result) - 1 - col;
+        }
+        if (orientation.vflip) {
+                row = methods->height(closure->result) - 1 - row;
+        }
+
+        uint32_t *out = methods->at(closure->result, col, row);
+        *out = Orient40_codeword(*(uint32_t *)elem, orientation);
+}
+
+
+/********** Orient40_codewords **********
+ *
+ * Reorients a whole image of codewords
+ *
+ * Parameters:
+ *      A2 codewords         - UArray2 of uint32_t codewords, one per block
+ *      Orient40 orientation - The orientation to apply
+ *
+ * Return:
+ *      A new UArray2 of the reoriented codewords, with width and height
+ *      swapped if orientation transposes
+ *
+ * Expects:
+ *      codewords is non-null
+ *
+ * Notes:
+ *      The caller frees the result with uarray2_methods_plain->free
+ ************************/
+A2 Orient40_codewords(A2 codewords, Orient40 orientation)
+{
+        assert(codewords != NULL);
+        A2Methods_T methods = uarray2_methods_plain;
+
+        int width = methods->width(codewords);
+        int height = methods->height(codewords);
+        Orient_Closure cl;
+        cl.orientation = orientation;
+        cl.result = orientation.transpose
+                    ? methods->new(height, width, sizeof(uint32_t))
+                    : methods->new(width, height, sizeof(uint32_t));
+
+        void *cls[A2PARALLEL_MAX_WORKERS];
+        for (int w = 0; w < A2Parallel_workers(); w++) {
+                cls[w] = &cl;
+        }
+
+        /* every codeword lands in its own block of result */
+        uarray2_parallel_plain->map_row_major(codewords, applyOrient, cls);
+        return cl.result;
+}
+
+
+/********** Orient40_stream **********
+ *
+ * Reads a compressed image, reorients it, and writes it back out
+ *
+ * Parameters:
+ *      FILE *input          - A format 2 or 3 compressed image
+ *      FILE *output         - The stream to write to
+ *      Orient40 orientation - The orientation to apply
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null
+ *      CRE if input is not a format 2 or 3 compressed image
+ *
+ * Notes:
+ *      Format 3 input stays format 3; format 2 is written as format 2
+ *      unless format 3 has been selected with Codec40_use_run_length
+ ************************/
+void Orient40_stream(FILE *input, FILE *output, Orient40 orientation)
+{
+        assert(input != NULL && output != NULL);
+
+        unsigned width, height;
+        unsigned format = Codec40_read_header(input, &width, &height);
+        A2 codewords = Codec40_read_codewords(input, format, width, height);
+        if (format == 3) {
+                Codec40_use_run_length(true);
+        }
+
+        A2 result = Orient40_codewords(codewords, orientation);
+        Codec40_write(output, result);
+
+        uarray2_methods_plain->free(&result);
+        uarray2_methods_plain->free(&codewords);
+}
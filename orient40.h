@@ -0,0 +1,58 @@
+/**************************************************************
+*
+*                     orient40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       orient40.h declares rotation and flipping of compressed
+*       images. Each of the eight orientations of a 2x2 block maps its
+*       DCT coefficients onto each other with at most a swap and sign
+*       changes, so a compressed image can be reoriented by moving its
+*       codewords around the block grid and rewriting their b, c, and d
+*       fields, without decoding a pixel or losing any quality.
+*
+**************************************************************/
+#ifndef ORIENT40_INCLUDED
+#define ORIENT40_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "a2methods.h"
+
+/********** Orient40 **********
+ *
+ * struct to hold an orientation as the steps that produce it, applied in
+ * the order transpose, then horizontal flip, then vertical flip
+ *
+ * Contains:
+ *      bool transpose - swap rows and columns
+ *      bool hflip     - mirror left to right
+ *      bool vflip     - mirror top to bottom
+ *
+ ************************/
+typedef struct Orient40 {
+        bool transpose;
+        bool hflip;
+        bool vflip;
+} Orient40;
+
+/*
+ * A zeroed Orient40 changes nothing. These add a clockwise rotation by
+ * degrees (0, 90, 180, or 270), or a flip ('h' or 'v'), after orientation;
+ * they return false if the argument is not one of those
+ */
+extern bool Orient40_rotate(Orient40 *orientation, unsigned degrees);
+extern bool Orient40_flip(Orient40 *orientation, char axis);
+
+/* reorient one format 2/3 codeword, or a whole array of them (a new one) */
+extern uint32_t Orient40_codeword(uint32_t codeword, Orient40 orientation);
+extern A2Methods_UArray2 Orient40_codewords(A2Methods_UArray2 codewords,
+                                            Orient40 orientation);
+
+/* read a compressed image from input and write it reoriented to output */
+extern void Orient40_stream(FILE *input, FILE *output, Orient40 orientation);
+
+#endif
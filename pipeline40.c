@@ -0,0 +1,462 @@
+/**************************************************************
+*
+*                     pipeline40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       pipeline40.c implements the pipelined compressor. Three kinds
+*       of thread share one bounded ring of slots, each slot holding a
+*       block row (two pixel rows) of the image:
+*
+*               reader  - parses pixel rows from the input into free
+*                         slots, in order
+*               workers - each claims the next block row, compresses it,
+*                         and stores its codewords in the slot
+*               writer  - (the calling thread) writes finished slots to
+*                         the output in order and frees them
+*
+*       Slots move FREE -> READ -> COMPUTED -> FREE. Each transition
+*       is a single release store by the thread that owns the slot at
+*       that moment, seen by the next owner through an acquire load, so
+*       the ring needs no locks. Threads that find nothing to do back
+*       off (pause, then yield, then sleep briefly) rather than block.
+*
+*       Because input is consumed as it arrives and output is written
+*       as soon as a block row is finished, disk or pipe I/O overlaps
+*       with the transform work.
+*
+**************************************************************/
+#include "pipeline40.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "assert.h"
+#include "mem.h"
+#include "pnm.h"
+#include "pnm40.h"
+#include "codec40.h"
+#include "stats40.h"
+#include "a2parallel.h"
+
+#define MAX_WORKERS 64
+#define SLOTS_PER_WORKER 4
+#define MIN_SLOTS 8
+
+/* backoff thresholds, in failed polls */
+#define SPIN_POLLS 64
+#define YIELD_POLLS 256
+#define SLEEP_NS 20000
+
+/********** Slot_State **********
+ *
+ * where a slot is in its FREE -> READ -> COMPUTED -> FREE cycle
+ *
+ ************************/
+typedef enum Slot_State {
+        SLOT_FREE = 0,
+        SLOT_READ,
+        SLOT_COMPUTED
+} Slot_State;
+
+/********** Slot **********
+ *
+ * struct to hold one block row as it moves through the pipeline
+ *
+ * Contains:
+ *      int state
+ *          a Slot_State, only accessed with __atomic builtins
+ *
+ *      size_t seq
+ *          index of the block row held, set by the reader before state
+ *          becomes READ (atomically, since other threads poll it)
+ *
+ *      struct Pnm_rgb *pixels
+ *          the block row's two pixel rows, each file_width pixels long;
+ *          the slot's own buffer, or rows of Pipeline's image
+ *
+ *      uint32_t *codewords
+ *          the block row's codewords
+ *
+ ************************/
+typedef struct Slot {
+        int state;
+        size_t seq;
+        struct Pnm_rgb *pixels;
+        uint32_t *codewords;
+} Slot;
+
+/********** Pipeline **********
+ *
+ * struct to hold the state shared by the reader, workers, and writer
+ *
+ * Contains:
+ *      Pnm40_T reader, FILE *output
+ *          the input image being read, and the stream being written
+ *
+ *      unsigned file_width, width, height, denominator
+ *          the input's width, and the even (trimmed) size being compressed
+ *
+ *      size_t num_rows, blocks_wide
+ *          block rows in the image and blocks per block row
+ *
+ *      Slot *ring, size_t num_slots
+ *          the ring of block-row slots
+ *
+ *      size_t next_row
+ *          next block row for a worker to claim, updated atomically
+ *
+ *      struct Pnm_rgb *image
+ *          every row, if a plain image was parsed up front in parallel,
+ *          else NULL
+ *
+ ************************/
+typedef struct Pipeline {
+        Pnm40_T reader;
+        FILE *output;
+        unsigned file_width;
+        unsigned width;
+        unsigned height;
+        unsigned denominator;
+        size_t num_rows;
+        size_t blocks_wide;
+        Slot *ring;
+        size_t num_slots;
+        size_t next_row;
+        struct Pnm_rgb *image;
+} Pipeline;
+
+/********** Worker **********
+ *
+ * struct to hold what one worker thread is started with: the pipeline
+ * and the worker's index, under which stats40 accounts for its rows
+ *
+ ************************/
+typedef struct Worker {
+        Pipeline *p;
+        int index;
+} Worker;
+
+
+/******************************************************************************
+ *
+ *                          SYNCHRONIZATION
+ *
+ *****************************************************************************/
+
+
+/********** backoff **********
+ *
+ * Waits a little before polling a slot again, waiting longer the more
+ * polls have failed in a row
+ *
+ ************************/
+static void backoff(unsigned *polls)
+{
+        (*polls)++;
+        if (*polls < SPIN_POLLS) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+        } else if (*polls < YIELD_POLLS) {
+                sched_yield();
+        } else {
+                struct timespec pause = { 0, SLEEP_NS };
+                nanosleep(&pause, NULL);
+        }
+}
+
+
+/********** wait_for_slot **********
+ *
+ * Waits until slot is in state want and holds block row seq
+ *
+ * Notes:
+ *      The acquire load pairs with the release store that set the state,
+ *      so everything the previous owner wrote to the slot is visible
+ ************************/
+static void wait_for_slot(Slot *slot, Slot_State want, size_t seq)
+{
+        unsigned polls = 0;
+        while (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != (int) want
+               || __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+                backoff(&polls);
+        }
+}
+
+
+/********** publish_slot **********
+ *
+ * Hands a slot to the next stage by moving it to state
+ *
+ ************************/
+static void publish_slot(Slot *slot, Slot_State state)
+{
+        __atomic_store_n(&slot->state, state, __ATOMIC_RELEASE);
+}
+
+
+/******************************************************************************
+ *
+ *                          READER
+ *
+ *****************************************************************************/
+
+
+/********** read_header **********
+ *
+ * Opens the pipeline's input and works out the size of the image to
+ * compress
+ *
+ ************************/
+static void read_header(Pipeline *p, FILE *input)
+{
+        p->reader = Pnm40_open(input);
+        assert(Pnm40_channels(p->reader) == 3);
+
+        p->file_width = Pnm40_width(p->reader);
+        unsigned file_height = Pnm40_height(p->reader);
+        p->denominator = Pnm40_maxval(p->reader);
+
+        /* odd rows and columns are trimmed, as Codec40_trim does */
+        p->width = p->file_width - p->file_width % BLOCKSIZE;
+        p->height = file_height - file_height % BLOCKSIZE;
+        p->blocks_wide = p->width / BLOCKSIZE;
+        p->num_rows = p->height / BLOCKSIZE;
+}
+
+
+/********** reader_main **********
+ *
+ * Reader thread: fills slots with block rows, in order, or points them
+ * at the rows of an image already parsed
+ *
+ ************************/
+static void *reader_main(void *arg)
+{
+        Pipeline *p = arg;
+
+        for (size_t seq = 0; seq < p->num_rows; seq++) {
+                Slot *slot = &p->ring[seq % p->num_slots];
+                size_t prev = seq < p->num_slots ? 0 : seq - p->num_slots;
+                wait_for_slot(slot, SLOT_FREE, prev);
+
+                if (p->image != NULL) {
+                        slot->pixels = p->image
+                                       + seq * BLOCKSIZE * p->file_width;
+                } else {
+                        STATS_START(read_start);
+                        Pnm40_read_rows(p->reader, (unsigned *) slot->pixels,
+                                        BLOCKSIZE, 1);
+                        STATS_STOP(STATS_READ, read_start);
+                }
+
+                __atomic_store_n(&slot->seq, seq, __ATOMIC_RELAXED);
+                publish_slot(slot, SLOT_READ);
+        }
+
+        return NULL;
+}
+
+
+/******************************************************************************
+ *
+ *                          WORKERS
+ *
+ *****************************************************************************/
+
+
+/********** compress_row **********
+ *
+ * Compresses every block of the block row in slot into its codeword
+ *
+ ************************/
+static void compress_row(Pipeline *p, Slot *slot)
+{
+        struct Pnm_rgb *top = slot->pixels;
+        struct Pnm_rgb *bottom = slot->pixels + p->file_width;
+
+        for (size_t block = 0; block < p->blocks_wide; block++) {
+                size_t col = block * BLOCKSIZE;
+                Pnm_rgb pixels[BLOCKAREA] = {
+                        &top[col], &top[col + 1],
+                        &bottom[col], &bottom[col + 1]
+                };
+                slot->codewords[block] = Codec40_encode_block(pixels,
+                                                        p->denominator);
+        }
+}
+
+
+/********** worker_main **********
+ *
+ * Worker thread: claims block rows in order until none are left
+ *
+ * Notes:
+ *      Each row is one task in the stats40 worker table; time spent
+ *      waiting for the reader is not counted as busy. Rows are claimed
+ *      from one shared counter, so a worker never has to steal.
+ ************************/
+static void *worker_main(void *arg)
+{
+        Worker *worker = arg;
+        Pipeline *p = worker->p;
+
+        for (;;) {
+                size_t seq = __atomic_fetch_add(&p->next_row, 1,
+                                                __ATOMIC_RELAXED);
+                if (seq >= p->num_rows) {
+                        return NULL;
+                }
+                Slot *slot = &p->ring[seq % p->num_slots];
+                wait_for_slot(slot, SLOT_READ, seq);
+                STATS_START(task_start);
+                compress_row(p, slot);
+                STATS_TASK(worker->index, task_start);
+                publish_slot(slot, SLOT_COMPUTED);
+        }
+}
+
+
+/******************************************************************************
+ *
+ *                          DRIVER
+ *
+ *****************************************************************************/
+
+
+/********** Pipeline40_threads **********
+ *
+ * Returns the number of compute workers the pipeline should use
+ *
+ * Notes:
+ *      Reads the count from A2Parallel_requested. Only here does
+ *      COMP40_THREADS=0 mean something: it turns the pipeline off, so
+ *      the sequential compressor runs instead. A negative count means one.
+ ************************/
+int Pipeline40_threads(void)
+{
+        long n = A2Parallel_requested();
+        if (n < 0) {
+                n = 1;
+        }
+        return n > MAX_WORKERS ? MAX_WORKERS : (int) n;
+}
+
+
+/********** Pipeline40_compress **********
+ *
+ * Compresses a PPM image with overlapped reading, compression, and writing
+ *
+ * Parameters:
+ *      FILE *input     - Stream containing a P3 or P6 image
+ *      FILE *output    - Stream to write the compressed image to
+ *      int num_workers - Number of compute threads to start
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null; num_workers >= 1
+ *      CRE if the input is not a well-formed P3 or P6 image
+ *
+ * Notes:
+ *      The calling thread acts as the writer. The output is identical to
+ *      the sequential compressor's, including trimming of odd dimensions.
+ *      A plain (P3) image in a regular file is parsed on num_workers
+ *      threads before compression starts, and the slots point into it.
+ ************************/
+void Pipeline40_compress(FILE *input, FILE *output, int num_workers)
+{
+        assert(input != NULL && output != NULL);
+        assert(num_workers >= 1 && num_workers <= MAX_WORKERS);
+
+        Pipeline p;
+        memset(&p, 0, sizeof(p));
+        p.output = output;
+        read_header(&p, input);
+
+        /* a mapped plain image parses faster on every thread at once */
+        if (num_workers > 1 && Pnm40_can_split(p.reader)) {
+                STATS_START(read_start);
+                p.image = ALLOC((size_t) p.height * p.file_width
+                                * sizeof(struct Pnm_rgb) + 1);
+                Pnm40_read_rows(p.reader, (unsigned *) p.image, p.height,
+                                num_workers);
+                STATS_STOP(STATS_READ, read_start);
+        }
+
+        Codec40_write_header(output, p.width, p.height);
+
+        /* allocate the ring */
+        p.num_slots = (size_t) num_workers * SLOTS_PER_WORKER;
+        if (p.num_slots < MIN_SLOTS) {
+                p.num_slots = MIN_SLOTS;
+        }
+        p.ring = CALLOC(p.num_slots, sizeof(Slot));
+        for (size_t i = 0; i < p.num_slots; i++) {
+                if (p.image == NULL) {
+                        p.ring[i].pixels = ALLOC(BLOCKSIZE
+                                                 * (size_t) p.file_width
+                                                 * sizeof(struct Pnm_rgb)
+                                                 + 1);
+                }
+                p.ring[i].codewords = ALLOC(p.blocks_wide
+                                            * sizeof(uint32_t) + 1);
+        }
+
+        /* start the reader and the workers */
+        pthread_t reader;
+        pthread_t workers[MAX_WORKERS];
+        Worker worker_args[MAX_WORKERS];
+        if (Stats40_num_workers < num_workers) {
+                Stats40_num_workers = num_workers;
+        }
+        STATS_START(span_start);
+        int err = pthread_create(&reader, NULL, reader_main, &p);
+        assert(err == 0);
+        for (int w = 0; w < num_workers; w++) {
+                worker_args[w].p = &p;
+                worker_args[w].index = w;
+                err = pthread_create(&workers[w], NULL, worker_main,
+                                     &worker_args[w]);
+                assert(err == 0);
+        }
+
+        /* write finished block rows in order; runs continue across rows */
+        Codec40_Runs runs = { 0, 0, false };
+        for (size_t seq = 0; seq < p.num_rows; seq++) {
+                Slot *slot = &p.ring[seq % p.num_slots];
+                wait_for_slot(slot, SLOT_COMPUTED, seq);
+
+                STATS_START(write_start);
+                Codec40_put_codewords(output, &runs, slot->codewords,
+                                      p.blocks_wide);
+                STATS_STOP(STATS_WRITE, write_start);
+
+                publish_slot(slot, SLOT_FREE);
+        }
+        Codec40_end_codewords(output, &runs);
+        fflush(output);
+
+        pthread_join(reader, NULL);
+        for (int w = 0; w < num_workers; w++) {
+                pthread_join(workers[w], NULL);
+        }
+        STATS_PARALLEL(span_start);
+        Pnm40_close(&p.reader);
+
+        for (size_t i = 0; i < p.num_slots; i++) {
+                if (p.image == NULL) {
+                        FREE(p.ring[i].pixels);
+                }
+                FREE(p.ring[i].codewords);
+        }
+        FREE(p.ring);
+        FREE(p.image);
+}
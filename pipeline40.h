@@ -0,0 +1,32 @@
+/**************************************************************
+*
+*                     pipeline40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       pipeline40.h declares the pipelined compressor, which overlaps
+*       reading the PPM, compressing blocks on worker threads, and
+*       writing codewords, instead of doing each for the whole image
+*       in turn.
+*
+**************************************************************/
+#ifndef PIPELINE40_INCLUDED
+#define PIPELINE40_INCLUDED
+
+#include <stdio.h>
+
+/*
+ * Number of compute workers to use: COMP40_THREADS from the environment if
+ * set, otherwise one per online CPU. 0 means "do not use the pipeline".
+ */
+extern int Pipeline40_threads(void);
+
+/*
+ * Reads a P3 or P6 image from input and writes its compressed form to
+ * output, byte for byte the same as the sequential compressor would.
+ */
+extern void Pipeline40_compress(FILE *input, FILE *output, int num_workers);
+
+#endif
@@ -0,0 +1,1171 @@
+/**************************************************************
+*
+*                     pnm40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       pnm40.c implements the in-tree PNM reader. The unread input is
+*       kept as one span of bytes:
+*
+*               - a regular file is mapped whole, so raw (P5/P6) rows
+*                 are converted straight out of the page cache with no
+*                 copy through stdio
+*               - anything else (a pipe, a memory stream) is read into a
+*                 buffer that slides along the input; for raw images it
+*                 only ever reads the bytes the next row needs
+*
+*       Plain (P2/P3) rasters are parsed 16 bytes at a time. SSE2
+*       compares classify the 16 bytes as digits or whitespace at once,
+*       bit tricks on the resulting masks find where each number starts
+*       and ends, and a number's digits (up to 8 of them) are converted
+*       together with three multiplies (see swar_number). Numbers that
+*       cross a 16-byte window are picked up by the next window; anything
+*       unusual (comments, long numbers, the end of the input) goes to
+*       the byte-at-a-time parser, which is also used for headers.
+*
+*       Pnm40_write_ppm writes 8-bit P6 output a megabyte of scanlines at
+*       a time with write(2), or hands the pages to a pipe with vmsplice.
+*
+**************************************************************/
+/* vmsplice */
+#define _GNU_SOURCE
+
+#include "pnm40.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "assert.h"
+#include "mem.h"
+#include "a2plain.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PNM40_SSE2 1
+#else
+#define PNM40_SSE2 0
+#endif
+
+#define T Pnm40_T
+
+#define BUFFER_BYTES 65536
+#define WINDOW 16
+#define SWAR_DIGITS 8
+
+/* plain rasters with fewer samples than this are not worth splitting */
+#define MIN_SPLIT_SAMPLES (1 << 20)
+#define MAX_SPLIT_THREADS 64
+
+/* bytes of P6 output gathered per write or vmsplice */
+#define WRITE_BYTES (1 << 20)
+#define MAX_HEADER 64
+
+/********** Pnm40_T **********
+ *
+ * struct to hold a reader's header and its view of the input
+ *
+ * Contains:
+ *      FILE *input
+ *          the stream the image is read from
+ *
+ *      char kind
+ *          the digit of the magic number: '2', '3', '5', or '6'
+ *
+ *      unsigned width, height, maxval, channels, rows_read
+ *          the header, and how many rows have been delivered
+ *
+ *      unsigned char *data, size_t capacity
+ *          the mapped file, or the buffer and its size
+ *
+ *      size_t pos, end
+ *          the unread bytes are data[pos] up to data[end]
+ *
+ *      bool mapped, eof
+ *          whether data is a mapping, and whether there is nothing to
+ *          read past end (always true for a mapping)
+ *
+ *      off_t base
+ *          file offset of data[0], or -1 if input cannot seek
+ *
+ ************************/
+struct T {
+        FILE *input;
+        char kind;
+        unsigned width;
+        unsigned height;
+        unsigned maxval;
+        unsigned channels;
+        unsigned rows_read;
+        unsigned char *data;
+        size_t capacity;
+        size_t pos;
+        size_t end;
+        bool mapped;
+        bool eof;
+        off_t base;
+};
+
+
+/******************************************************************************
+ *
+ *                          INPUT
+ *
+ *****************************************************************************/
+
+
+/********** map_input **********
+ *
+ * Maps input whole if it is a regular file, starting the reader at the
+ * stream's current position; returns false if it cannot be mapped
+ *
+ ************************/
+static bool map_input(T reader)
+{
+        int fd = fileno(reader->input);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)
+            || info.st_size == 0) {
+                return false;
+        }
+        off_t offset = ftello(reader->input);
+        if (offset < 0 || offset >= info.st_size) {
+                return false;
+        }
+
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+                return false;
+        }
+        madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+        reader->data = map;
+        reader->capacity = info.st_size;
+        reader->pos = offset;
+        reader->end = info.st_size;
+        reader->mapped = true;
+        reader->eof = true;
+        reader->base = 0;
+        return true;
+}
+
+
+/********** fill **********
+ *
+ * Makes at least need unread bytes available, reading more of the input
+ * if it has to. Plain images are read a buffer at a time; raw ones only
+ * as far as need, so the stream is left where their last row ends.
+ *
+ * Return:
+ *      false if the input ends first
+ *
+ ************************/
+static bool fill(T reader, size_t need)
+{
+        if (reader->end - reader->pos >= need) {
+                return true;
+        }
+        if (reader->eof) {
+                return false;
+        }
+
+        /* slide the unread bytes to the front */
+        size_t unread = reader->end - reader->pos;
+        memmove(reader->data, reader->data + reader->pos, unread);
+        if (reader->base >= 0) {
+                reader->base += reader->pos;
+        }
+        reader->pos = 0;
+        reader->end = unread;
+        if (need > reader->capacity) {
+                RESIZE(reader->data, need);
+                reader->capacity = need;
+        }
+
+        bool raw = reader->kind != '2' && reader->kind != '3';
+        while (reader->end < need) {
+                size_t want = raw ? need - reader->end
+                                  : reader->capacity - reader->end;
+                size_t got = fread(reader->data + reader->end, 1, want,
+                                   reader->input);
+                reader->end += got;
+                if (got < want) {
+                        reader->eof = true;
+                        break;
+                }
+        }
+        return reader->end >= need;
+}
+
+
+/********** next_byte **********
+ *
+ * Returns the next byte of input, or EOF
+ *
+ ************************/
+static inline int next_byte(T reader)
+{
+        if (!fill(reader, 1)) {
+                return EOF;
+        }
+        return reader->data[reader->pos++];
+}
+
+
+/********** scalar_number **********
+ *
+ * Reads one unsigned decimal number, skipping whitespace and comments
+ * before it
+ *
+ * Notes:
+ *      Consumes the single character after the number, which for the
+ *      maxval of a raw header is the whitespace before the raster
+ ************************/
+static unsigned scalar_number(T reader)
+{
+        int c = next_byte(reader);
+        while (c == '#' || isspace(c)) {
+                if (c == '#') {
+                        while (c != '\n' && c != EOF) {
+                                c = next_byte(reader);
+                        }
+                }
+                c = next_byte(reader);
+        }
+        assert(isdigit(c));
+
+        unsigned long n = 0;
+        while (isdigit(c)) {
+                n = n * 10 + (c - '0');
+                assert(n <= 0xffffffffu);
+                c = next_byte(reader);
+        }
+        return n;
+}
+
+
+/******************************************************************************
+ *
+ *                          PLAIN RASTERS
+ *
+ *****************************************************************************/
+
+
+/********** swar_number **********
+ *
+ * Converts the len (1 to 8) digits at digits to a number, all at once
+ *
+ * Notes:
+ *      Reads 8 bytes. With the first digit in the lowest byte, shifting
+ *      the digits to the top of the word puts zeros in front of them;
+ *      then each step combines neighbouring bytes, 16-bit halves, and
+ *      32-bit halves as (high * 10^k + low)
+ ************************/
+static inline unsigned swar_number(const unsigned char *digits, unsigned len)
+{
+        uint64_t chunk;
+        memcpy(&chunk, digits, sizeof(chunk));
+        chunk -= 0x3030303030303030;
+        chunk <<= 8 * (SWAR_DIGITS - len);
+
+        chunk = (chunk * 10 + (chunk >> 8)) & 0x00ff00ff00ff00ff;
+        chunk = (chunk * 100 + (chunk >> 16)) & 0x0000ffff0000ffff;
+        chunk = (chunk * 10000 + (chunk >> 32)) & 0xffffffff;
+        return chunk;
+}
+
+
+#if PNM40_SSE2
+
+/********** classify **********
+ *
+ * Sets bit i of *digits if window[i] is a digit, and of *spaces if it is
+ * whitespace, for the 16 bytes of window
+ *
+ ************************/
+static inline void classify(const unsigned char *window, unsigned *digits,
+                            unsigned *spaces)
+{
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i four = _mm_set1_epi8(4);
+        __m128i bytes = _mm_loadu_si128((const __m128i *) window);
+
+        /* digit: byte - '0' <= 9; space: ' ' or byte - '\t' <= 4 */
+        __m128i digit = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+        __m128i control = _mm_sub_epi8(bytes, nine);
+        *digits = _mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit));
+        *spaces = _mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                _mm_cmpeq_epi8(_mm_min_epu8(control, four), control)));
+}
+
+
+/********** parse_windows **********
+ *
+ * Parses numbers from data[*pos] on, 16 bytes at a time, for as long as
+ * whole windows before end are available and hold only digits and
+ * whitespace. Digits are read 8 bytes at a time, so data must be
+ * readable up to readable, which may be past end.
+ *
+ * Return:
+ *      How many of the count numbers wanted it parsed
+ *
+ ************************/
+static size_t parse_windows(const unsigned char *data, size_t *pos,
+                            size_t end, size_t readable, unsigned *samples,
+                            size_t count)
+{
+        size_t n = 0;
+
+        while (n < count && end - *pos >= WINDOW) {
+                const unsigned char *window = data + *pos;
+                unsigned digits, spaces;
+                classify(window, &digits, &spaces);
+                if ((digits | spaces) != 0xffff) {
+                        break;
+                }
+
+                unsigned consumed = WINDOW;
+                unsigned rest = digits;
+                while (rest != 0 && n < count) {
+                        unsigned start = __builtin_ctz(rest);
+                        unsigned len = __builtin_ctz(~(digits >> start));
+                        if (start + len == WINDOW) {
+                                /* it may go on into the next window */
+                                consumed = start;
+                                break;
+                        }
+                        if (len > SWAR_DIGITS
+                            || *pos + start + SWAR_DIGITS > readable) {
+                                consumed = start;
+                                break;
+                        }
+                        samples[n++] = swar_number(window + start, len);
+                        consumed = start + len;
+                        rest = digits & (~0u << consumed);
+                }
+
+                *pos += consumed;
+                if (consumed == 0) {
+                        break;
+                }
+        }
+        return n;
+}
+
+#endif
+
+
+/********** read_plain **********
+ *
+ * Parses count numbers from a plain raster into samples
+ *
+ ************************/
+static void read_plain(T reader, unsigned *samples, size_t count)
+{
+        size_t n = 0;
+        while (n < count) {
+#if PNM40_SSE2
+                n += parse_windows(reader->data, &reader->pos, reader->end,
+                                   reader->end, samples + n, count - n);
+                if (n == count) {
+                        break;
+                }
+#endif
+                samples[n++] = scalar_number(reader);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+                assert(samples[i] <= reader->maxval);
+        }
+}
+
+
+/********** read_raw **********
+ *
+ * Converts count one- or two-byte (big-endian) samples of a raw raster
+ * into samples
+ *
+ ************************/
+static void read_raw(T reader, unsigned *samples, size_t count)
+{
+        bool wide = reader->maxval > 255;
+        size_t bytes = wide ? 2 * count : count;
+        bool ok = fill(reader, bytes);
+        assert(ok);
+
+        const unsigned char *raw = reader->data + reader->pos;
+        reader->pos += bytes;
+        if (!wide) {
+                for (size_t i = 0; i < count; i++) {
+                        samples[i] = raw[i];
+                }
+        } else {
+                for (size_t i = 0; i < count; i++) {
+                        samples[i] = (unsigned) raw[2 * i] << 8
+                                     | raw[2 * i + 1];
+                }
+        }
+
+        if (reader->maxval != 255 && reader->maxval != 65535) {
+                for (size_t i = 0; i < count; i++) {
+                        assert(samples[i] <= reader->maxval);
+                }
+        }
+}
+
+
+/******************************************************************************
+ *
+ *                          PARALLEL PLAIN RASTERS
+ *
+ *****************************************************************************/
+
+
+/********** Chunk **********
+ *
+ * struct to hold one thread's share of a plain raster being parsed in
+ * parallel
+ *
+ * Contains:
+ *      const unsigned char *data, size_t begin, end, readable
+ *          the input, the chunk's span of it, and how far data may be
+ *          read
+ *
+ *      size_t tokens, first
+ *          numbers in the chunk, and the index in the raster of its first
+ *
+ *      unsigned *samples, size_t count, unsigned maxval
+ *          where the raster's numbers go, how many are wanted, and the
+ *          largest allowed
+ *
+ *      bool bad
+ *          set for a byte that is neither a digit nor whitespace (such
+ *          as a comment), or a number past maxval
+ *
+ *      size_t stop
+ *          just past the last number stored
+ *
+ ************************/
+typedef struct Chunk {
+        const unsigned char *data;
+        size_t begin;
+        size_t end;
+        size_t readable;
+        size_t tokens;
+        size_t first;
+        unsigned *samples;
+        size_t count;
+        unsigned maxval;
+        bool bad;
+        size_t stop;
+} Chunk;
+
+
+/********** count_chunk **********
+ *
+ * Thread that counts the numbers in a chunk: the digits that follow a
+ * non-digit
+ *
+ ************************/
+static void *count_chunk(void *arg)
+{
+        Chunk *chunk = arg;
+        const unsigned char *data = chunk->data;
+        size_t pos = chunk->begin;
+        size_t tokens = 0;
+        unsigned digit_before = 0;
+
+#if PNM40_SSE2
+        while (chunk->end - pos >= WINDOW) {
+                unsigned digits, spaces;
+                classify(data + pos, &digits, &spaces);
+                if ((digits | spaces) != 0xffff) {
+                        chunk->bad = true;
+                        return NULL;
+                }
+                tokens += __builtin_popcount(digits
+                                             & ~(digits << 1 | digit_before));
+                digit_before = digits >> (WINDOW - 1);
+                pos += WINDOW;
+        }
+#endif
+        for (; pos < chunk->end; pos++) {
+                unsigned digit = isdigit(data[pos]) != 0;
+                if (!digit && !isspace(data[pos])) {
+                        chunk->bad = true;
+                        return NULL;
+                }
+                tokens += digit & ~digit_before;
+                digit_before = digit;
+        }
+
+        chunk->tokens = tokens;
+        return NULL;
+}
+
+
+/********** bounded_number **********
+ *
+ * Parses the next number before end, skipping the whitespace before it;
+ * one too large for 32 bits comes back as 0xffffffff
+ *
+ ************************/
+static unsigned bounded_number(const unsigned char *data, size_t *pos,
+                               size_t end)
+{
+        while (*pos < end && !isdigit(data[*pos])) {
+                (*pos)++;
+        }
+
+        unsigned long long n = 0;
+        while (*pos < end && isdigit(data[*pos])) {
+                n = n * 10 + (data[(*pos)++] - '0');
+                if (n > 0xffffffffu) {
+                        n = 0xffffffffu;
+                }
+        }
+        return n;
+}
+
+
+/********** parse_chunk **********
+ *
+ * Thread that parses a chunk's numbers into their places in the raster,
+ * stopping at the last number wanted
+ *
+ ************************/
+static void *parse_chunk(void *arg)
+{
+        Chunk *chunk = arg;
+        chunk->stop = chunk->begin;
+        if (chunk->first >= chunk->count) {
+                return NULL;
+        }
+
+        size_t want = chunk->tokens;
+        if (want > chunk->count - chunk->first) {
+                want = chunk->count - chunk->first;
+        }
+        unsigned *samples = chunk->samples + chunk->first;
+        size_t pos = chunk->begin;
+        size_t n = 0;
+        while (n < want) {
+#if PNM40_SSE2
+                n += parse_windows(chunk->data, &pos, chunk->end,
+                                   chunk->readable, samples + n, want - n);
+                if (n == want) {
+                        break;
+                }
+#endif
+                samples[n++] = bounded_number(chunk->data, &pos, chunk->end);
+        }
+        chunk->stop = pos;
+
+        for (size_t i = 0; i < want; i++) {
+                if (samples[i] > chunk->maxval) {
+                        chunk->bad = true;
+                }
+        }
+        return NULL;
+}
+
+
+/********** run_chunks **********
+ *
+ * Runs work on every chunk, each in its own thread
+ *
+ ************************/
+static void run_chunks(Chunk *chunks, int num_chunks, void *work(void *))
+{
+        pthread_t threads[MAX_SPLIT_THREADS];
+        for (int i = 0; i < num_chunks; i++) {
+                int err = pthread_create(&threads[i], NULL, work,
+                                         &chunks[i]);
+                assert(err == 0);
+        }
+        for (int i = 0; i < num_chunks; i++) {
+                pthread_join(threads[i], NULL);
+        }
+}
+
+
+/********** read_split **********
+ *
+ * Parses count numbers of a mapped plain raster on num_chunks threads.
+ * The rest of the file is cut into that many chunks, each moved forward
+ * to a byte that is not a digit so no number is cut in two. A first pass
+ * counts each chunk's numbers; a running total of the counts gives each
+ * chunk the index of its first number, and a second pass parses every
+ * chunk straight into place.
+ *
+ * Return:
+ *      false, having read nothing, if the raster holds anything but
+ *      digits and whitespace, which the sequential parser handles
+ *
+ ************************/
+static bool read_split(T reader, unsigned *samples, size_t count,
+                       int num_chunks)
+{
+        Chunk chunks[MAX_SPLIT_THREADS];
+        size_t span = (reader->end - reader->pos) / num_chunks;
+        size_t begin = reader->pos;
+
+        for (int i = 0; i < num_chunks; i++) {
+                size_t end = reader->end;
+                if (i < num_chunks - 1) {
+                        end = begin + span < reader->end ? begin + span
+                                                         : reader->end;
+                        while (end < reader->end
+                               && isdigit(reader->data[end])) {
+                                end++;
+                        }
+                }
+                chunks[i] = (Chunk) {
+                        .data = reader->data, .begin = begin, .end = end,
+                        .readable = reader->end, .samples = samples,
+                        .count = count, .maxval = reader->maxval
+                };
+                begin = end;
+        }
+
+        run_chunks(chunks, num_chunks, count_chunk);
+        size_t first = 0;
+        for (int i = 0; i < num_chunks; i++) {
+                if (chunks[i].bad) {
+                        return false;
+                }
+                chunks[i].first = first;
+                first += chunks[i].tokens;
+        }
+        assert(first >= count);
+
+        run_chunks(chunks, num_chunks, parse_chunk);
+        for (int i = 0; i < num_chunks; i++) {
+                assert(!chunks[i].bad);
+                if (chunks[i].first < count) {
+                        reader->pos = chunks[i].stop;
+                }
+        }
+        return true;
+}
+
+
+/******************************************************************************
+ *
+ *                          INTERFACE
+ *
+ *****************************************************************************/
+
+
+/********** Pnm40_open **********
+ *
+ * Starts reading a PNM image
+ *
+ * Parameters:
+ *      FILE *input - The stream, positioned at the magic number
+ *
+ * Return:
+ *      A reader positioned at the first row, freed with Pnm40_close
+ *
+ * Expects:
+ *      input is non-null
+ *      CRE if the header is not a P2, P3, P5, or P6 header with non-zero
+ *      width and height and a maxval from 1 to 65535
+ *
+ * Notes:
+ *      A regular file is mapped; other input is buffered
+ ************************/
+T Pnm40_open(FILE *input)
+{
+        assert(input != NULL);
+
+        T reader;
+        NEW0(reader);
+        reader->input = input;
+        if (!map_input(reader)) {
+                reader->capacity = BUFFER_BYTES;
+                reader->data = ALLOC(reader->capacity);
+                reader->base = ftello(input);
+        }
+
+        /* until the kind is known, fill reads exactly what it needs */
+        reader->kind = '6';
+        int magic = next_byte(reader);
+        int kind = next_byte(reader);
+        assert(magic == 'P' && (kind == '2' || kind == '3' || kind == '5'
+                                || kind == '6'));
+        reader->kind = kind;
+        reader->channels = (kind == '3' || kind == '6') ? 3 : 1;
+
+        reader->width = scalar_number(reader);
+        reader->height = scalar_number(reader);
+        reader->maxval = scalar_number(reader);
+        assert(reader->width > 0 && reader->height > 0);
+        assert(reader->maxval > 0 && reader->maxval <= 65535);
+        assert((size_t) reader->width * reader->channels
+               <= 0xffffffffu / 2);
+        return reader;
+}
+
+
+/********** Pnm40_close **********
+ *
+ * Frees a reader
+ *
+ * Parameters:
+ *      T *reader - The reader
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      reader and *reader are non-null
+ *
+ * Notes:
+ *      If the input can seek, it is left just past the last byte the
+ *      reader used. A plain image from a pipe may have been read further.
+ ************************/
+void Pnm40_close(T *reader)
+{
+        assert(reader != NULL && *reader != NULL);
+        T r = *reader;
+
+        if (r->base >= 0) {
+                fseeko(r->input, r->base + (off_t) r->pos, SEEK_SET);
+        }
+        if (r->mapped) {
+                munmap(r->data, r->capacity);
+        } else {
+                FREE(r->data);
+        }
+        FREE(*reader);
+}
+
+
+unsigned Pnm40_width(T reader)
+{
+        assert(reader != NULL);
+        return reader->width;
+}
+
+
+unsigned Pnm40_height(T reader)
+{
+        assert(reader != NULL);
+        return reader->height;
+}
+
+
+unsigned Pnm40_maxval(T reader)
+{
+        assert(reader != NULL);
+        return reader->maxval;
+}
+
+
+unsigned Pnm40_channels(T reader)
+{
+        assert(reader != NULL);
+        return reader->channels;
+}
+
+
+/********** Pnm40_read_row **********
+ *
+ * Reads the next row of the image
+ *
+ * Parameters:
+ *      T reader          - The reader
+ *      unsigned *samples - Where width * channels samples are stored
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      reader and samples are non-null
+ *      CRE if every row has been read, the input ends inside the row, or
+ *      a sample is greater than maxval
+ ************************/
+void Pnm40_read_row(T reader, unsigned *samples)
+{
+        assert(reader != NULL && samples != NULL);
+        assert(reader->rows_read < reader->height);
+
+        size_t count = (size_t) reader->width * reader->channels;
+        if (reader->kind == '2' || reader->kind == '3') {
+                read_plain(reader, samples, count);
+        } else {
+                read_raw(reader, samples, count);
+        }
+        reader->rows_read++;
+}
+
+
+/********** Pnm40_can_split **********
+ *
+ * Returns whether Pnm40_read_rows can parse in parallel: the image is a
+ * plain one in a mapped file
+ *
+ ************************/
+bool Pnm40_can_split(T reader)
+{
+        assert(reader != NULL);
+        return reader->mapped && (reader->kind == '2' || reader->kind == '3');
+}
+
+
+/********** Pnm40_read_rows **********
+ *
+ * Reads the next rows of the image
+ *
+ * Parameters:
+ *      T reader          - The reader
+ *      unsigned *samples - Where rows * width * channels samples are
+ *                          stored
+ *      unsigned rows     - How many rows to read
+ *      int threads       - How many threads may parse
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      reader and samples are non-null
+ *      CRE as for Pnm40_read_row
+ *
+ * Notes:
+ *      Gives the same samples as calling Pnm40_read_row rows times. A
+ *      large plain raster in a mapped file, with no comments in it, is
+ *      parsed on up to threads threads (see read_split).
+ ************************/
+void Pnm40_read_rows(T reader, unsigned *samples, unsigned rows, int threads)
+{
+        assert(reader != NULL && samples != NULL);
+        assert(rows <= reader->height - reader->rows_read);
+
+        size_t row_samples = (size_t) reader->width * reader->channels;
+        size_t count = row_samples * rows;
+        if (threads > MAX_SPLIT_THREADS) {
+                threads = MAX_SPLIT_THREADS;
+        }
+        if (threads > 1 && Pnm40_can_split(reader)
+            && count >= MIN_SPLIT_SAMPLES
+            && read_split(reader, samples, count, threads)) {
+                reader->rows_read += rows;
+                return;
+        }
+
+        for (unsigned r = 0; r < rows; r++) {
+                Pnm40_read_row(reader, samples + r * row_samples);
+        }
+}
+
+
+/********** Pnm40_read_ppm **********
+ *
+ * Reads a whole P3 or P6 image
+ *
+ * Parameters:
+ *      FILE *input         - The stream, positioned at the magic number
+ *      A2Methods_T methods - Methods for the pixel array
+ *
+ * Return:
+ *      The image, freed with Pnm_ppmfree
+ *
+ * Expects:
+ *      input and methods are non-null
+ *      CRE if input does not hold a well-formed P3 or P6 image, or
+ *      either dimension is past INT_MAX
+ *
+ * Notes:
+ *      With uarray2_methods_plain, whose rows are contiguous arrays of
+ *      struct Pnm_rgb, rows are read straight into the image
+ ************************/
+Pnm_ppm Pnm40_read_ppm(FILE *input, A2Methods_T methods)
+{
+        assert(input != NULL && methods != NULL);
+
+        T reader = Pnm40_open(input);
+        assert(reader->channels == 3);
+        assert(reader->width <= INT_MAX && reader->height <= INT_MAX);
+
+        Pnm_ppm image;
+        NEW(image);
+        image->width = reader->width;
+        image->height = reader->height;
+        image->denominator = reader->maxval;
+        image->methods = methods;
+        image->pixels = methods->new(reader->width, reader->height,
+                                     sizeof(struct Pnm_rgb));
+
+        bool direct = (methods == uarray2_methods_plain);
+        struct Pnm_rgb *row = direct ? NULL
+                                     : ALLOC(reader->width
+                                             * sizeof(struct Pnm_rgb));
+        for (unsigned r = 0; r < reader->height; r++) {
+                if (direct) {
+                        Pnm40_read_row(reader, methods->at(image->pixels,
+                                                           0, r));
+                        continue;
+                }
+                Pnm40_read_row(reader, (unsigned *) row);
+                for (unsigned c = 0; c < reader->width; c++) {
+                        *(struct Pnm_rgb *) methods->at(image->pixels, c, r)
+                                = row[c];
+                }
+        }
+
+        FREE(row);
+        Pnm40_close(&reader);
+        return image;
+}
+
+
+/******************************************************************************
+ *
+ *                          OUTPUT
+ *
+ *****************************************************************************/
+
+
+/********** Sink **********
+ *
+ * struct to hold where Pnm40_write_ppm sends its bytes
+ *
+ * Contains:
+ *      FILE *output
+ *          the stream, used through stdio only if it has no descriptor
+ *
+ *      int fd
+ *          output's descriptor, or -1
+ *
+ *      bool splice
+ *          whether fd is a pipe that vmsplice has not refused yet
+ *
+ *      unsigned char *buffer
+ *          the chunk reused for each write when not splicing, or NULL
+ *
+ ************************/
+typedef struct Sink {
+        FILE *output;
+        int fd;
+        bool splice;
+        unsigned char *buffer;
+} Sink;
+
+
+/********** pack_samples **********
+ *
+ * Narrows count samples, each at most 255, to one byte apiece
+ *
+ ************************/
+static void pack_samples(const unsigned *samples, unsigned char *bytes,
+                         size_t count)
+{
+        size_t i = 0;
+#if PNM40_SSE2
+        for (; i + 16 <= count; i += 16) {
+                const __m128i *in = (const __m128i *) (samples + i);
+                __m128i low = _mm_packs_epi32(_mm_loadu_si128(in),
+                                              _mm_loadu_si128(in + 1));
+                __m128i high = _mm_packs_epi32(_mm_loadu_si128(in + 2),
+                                               _mm_loadu_si128(in + 3));
+                _mm_storeu_si128((__m128i *) (bytes + i),
+                                 _mm_packus_epi16(low, high));
+        }
+#endif
+        for (; i < count; i++) {
+                bytes[i] = samples[i];
+        }
+}
+
+
+/********** write_fd **********
+ *
+ * Writes all n bytes to fd, CRE if the write fails
+ *
+ ************************/
+static void write_fd(int fd, const unsigned char *bytes, size_t n)
+{
+        while (n > 0) {
+                ssize_t wrote = write(fd, bytes, n);
+                if (wrote < 0 && errno == EINTR) {
+                        continue;
+                }
+                assert(wrote > 0);
+                bytes += wrote;
+                n -= wrote;
+        }
+}
+
+
+/********** new_chunk **********
+ *
+ * Returns a buffer of WRITE_BYTES for the next chunk of output. A chunk
+ * bound for vmsplice gets fresh pages, because the pipe keeps reading
+ * them after vmsplice returns; otherwise one buffer is reused
+ *
+ ************************/
+static unsigned char *new_chunk(Sink *sink)
+{
+        if (!sink->splice) {
+                if (sink->buffer == NULL) {
+                        sink->buffer = ALLOC(WRITE_BYTES);
+                }
+                return sink->buffer;
+        }
+        void *pages = mmap(NULL, WRITE_BYTES, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(pages != MAP_FAILED);
+        return pages;
+}
+
+
+/********** emit_chunk **********
+ *
+ * Sends the first n bytes of chunk to the sink. When the chunk was
+ * spliced it is unmapped here: the pipe holds its own reference to the
+ * pages, and nothing will write to them again
+ *
+ ************************/
+static void emit_chunk(Sink *sink, unsigned char *chunk, size_t n)
+{
+        if (sink->splice) {
+                struct iovec iov = { chunk, n };
+                while (iov.iov_len > 0) {
+                        ssize_t moved = vmsplice(sink->fd, &iov, 1, 0);
+                        if (moved < 0 && errno == EINTR) {
+                                continue;
+                        }
+                        if (moved < 0) {
+                                /* not supported here: write from now on */
+                                assert(errno == EINVAL || errno == ENOSYS);
+                                sink->splice = false;
+                                write_fd(sink->fd, iov.iov_base,
+                                         iov.iov_len);
+                                break;
+                        }
+                        iov.iov_base = (unsigned char *) iov.iov_base
+                                       + moved;
+                        iov.iov_len -= moved;
+                }
+                munmap(chunk, WRITE_BYTES);
+        } else if (sink->fd >= 0) {
+                write_fd(sink->fd, chunk, n);
+        } else {
+                size_t wrote = fwrite(chunk, 1, n, sink->output);
+                assert(wrote == n);
+        }
+}
+
+
+/********** Pnm40_write_ppm **********
+ *
+ * Writes image as a P6 pixmap, as Pnm_ppmwrite does
+ *
+ * Parameters:
+ *      FILE *output  - The stream to write to
+ *      Pnm_ppm image - The image
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      output and image are non-null
+ *      CRE if the output cannot be written
+ *
+ * Notes:
+ *      Scanlines are narrowed to bytes into 1 MB chunks, each sent with
+ *      one write(2) on output's descriptor, after output is flushed; a
+ *      pipe gets the chunks' pages with vmsplice instead of a copy
+ *      Images with a denominator past 255 go to Pnm_ppmwrite
+ ************************/
+void Pnm40_write_ppm(FILE *output, Pnm_ppm image)
+{
+        assert(output != NULL && image != NULL);
+        if (image->denominator > 255) {
+                Pnm_ppmwrite(output, image);
+                return;
+        }
+
+        fflush(output);
+        Sink sink = { output, fileno(output), false, NULL };
+        struct stat info;
+        if (sink.fd >= 0 && fstat(sink.fd, &info) == 0) {
+                sink.splice = S_ISFIFO(info.st_mode);
+        }
+
+        A2Methods_T methods = (A2Methods_T) image->methods;
+        bool direct = (methods == uarray2_methods_plain);
+        size_t row_bytes = 3 * (size_t) image->width;
+        unsigned char *row = row_bytes > WRITE_BYTES ? ALLOC(row_bytes)
+                                                     : NULL;
+
+        unsigned char *chunk = new_chunk(&sink);
+        size_t used = (size_t) snprintf((char *) chunk, MAX_HEADER,
+                                        "P6\n%u %u\n%u\n", image->width,
+                                        image->height, image->denominator);
+        for (unsigned r = 0; r < image->height; r++) {
+                /* rows longer than a chunk are built aside and copied */
+                unsigned char *out = row;
+                if (out == NULL) {
+                        if (used + row_bytes > WRITE_BYTES) {
+                                emit_chunk(&sink, chunk, used);
+                                chunk = new_chunk(&sink);
+                                used = 0;
+                        }
+                        out = chunk + used;
+                }
+
+                if (row_bytes == 0) {
+                        /* an empty row has no pixel 0 to pack from */
+                } else if (direct) {
+                        pack_samples(methods->at(image->pixels, 0, r), out,
+                                     row_bytes);
+                } else {
+                        for (unsigned c = 0; c < image->width; c++) {
+                                Pnm_rgb pixel = methods->at(image->pixels,
+                                                            c, r);
+                                out[3 * c] = pixel->red;
+                                out[3 * c + 1] = pixel->green;
+                                out[3 * c + 2] = pixel->blue;
+                        }
+                }
+
+                if (out == row) {
+                        for (size_t done = 0; done < row_bytes; ) {
+                                if (used == WRITE_BYTES) {
+                                        emit_chunk(&sink, chunk, used);
+                                        chunk = new_chunk(&sink);
+                                        used = 0;
+                                }
+                                size_t n = row_bytes - done;
+                                if (n > WRITE_BYTES - used) {
+                                        n = WRITE_BYTES - used;
+                                }
+                                memcpy(chunk + used, row + done, n);
+                                used += n;
+                                done += n;
+                        }
+                } else {
+                        used += row_bytes;
+                }
+        }
+        emit_chunk(&sink, chunk, used);
+
+        FREE(sink.buffer);
+        FREE(row);
+}
+
+#undef T
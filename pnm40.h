@@ -0,0 +1,70 @@
+/**************************************************************
+*
+*                     pnm40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       pnm40.h declares the in-tree PNM reader. It reads P2, P3, P5,
+*       and P6 images with any maxval up to 65535, one row of samples
+*       at a time, so a caller can work on the top of an image before
+*       the bottom has been read. Pnm40_read_ppm reads a whole P3 or P6
+*       image into a Pnm_ppm in place of Pnm_ppmread, and
+*       Pnm40_write_ppm writes one out in place of Pnm_ppmwrite.
+*
+**************************************************************/
+#ifndef PNM40_INCLUDED
+#define PNM40_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "a2methods.h"
+#include "pnm.h"
+
+#define T Pnm40_T
+typedef struct T *T;
+
+/*
+ * Reads the header of the image at input's position, CRE if it is not a
+ * well-formed PNM header. A regular file is mapped and read in place.
+ */
+extern T Pnm40_open(FILE *input);
+
+/* frees the reader, leaving input just past the rows read, if it can seek */
+extern void Pnm40_close(T *reader);
+
+extern unsigned Pnm40_width(T reader);
+extern unsigned Pnm40_height(T reader);
+extern unsigned Pnm40_maxval(T reader);
+
+/* 1 for a graymap (P2, P5), 3 for a pixmap (P3, P6) */
+extern unsigned Pnm40_channels(T reader);
+
+/*
+ * Reads the next row into samples: width * channels values, in the
+ * order red, green, blue for pixmaps, which is the layout of an array of
+ * struct Pnm_rgb. CRE if a sample is past maxval or the input ends early.
+ */
+extern void Pnm40_read_row(T reader, unsigned *samples);
+
+/*
+ * Reads the next rows rows into samples, as that many Pnm40_read_row
+ * calls would. Where Pnm40_can_split is true, a large raster is parsed
+ * on up to threads threads.
+ */
+extern void Pnm40_read_rows(T reader, unsigned *samples, unsigned rows,
+                            int threads);
+extern bool Pnm40_can_split(T reader);
+
+/* reads a whole P3 or P6 image, as Pnm_ppmread does */
+extern Pnm_ppm Pnm40_read_ppm(FILE *input, A2Methods_T methods);
+
+/*
+ * Writes image as a P6 pixmap, as Pnm_ppmwrite does, in large writes
+ * straight to output's descriptor (see pnm40.c)
+ */
+extern void Pnm40_write_ppm(FILE *output, Pnm_ppm image);
+
+#undef T
+#endif
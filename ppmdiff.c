@@ -0,0 +1,104 @@
+/**************************************************************
+*
+*                     ppmdiff.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       ppmdiff.c compares two PPM images and prints the root mean
+*       square difference between them, which is how we measure the
+*       quality lost by compression. Either file (but not both) may
+*       be "-" to read from stdin.
+*
+*       With -a it also prints PSNR and SSIM.
+*
+*       Usage:
+*               ppmdiff [-a] image1 image2
+*
+**************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "assert.h"
+#include "pnm.h"
+#include "a2plain.h"
+#include "quality40.h"
+
+/********** open_image **********
+ *
+ * Reads the PPM image named by path, or stdin if path is "-"
+ *
+ ************************/
+static Pnm_ppm open_image(const char *path)
+{
+        if (strcmp(path, "-") == 0) {
+                return Pnm_ppmread(stdin, uarray2_methods_plain);
+        }
+
+        FILE *fp = fopen(path, "rb");
+        if (fp == NULL) {
+                perror(path);
+                exit(1);
+        }
+        Pnm_ppm image = Pnm_ppmread(fp, uarray2_methods_plain);
+        fclose(fp);
+        return image;
+}
+
+
+/********** main **********
+ *
+ * Reads both images and prints their difference
+ *
+ * Notes:
+ *      Images whose widths or heights differ by more than one pixel are
+ *      not comparable: an error is printed and the worst score, 1.0, is
+ *      reported. Smaller differences (from trimming odd dimensions) are
+ *      allowed and only the shared region is compared.
+ ************************/
+int main(int argc, char *argv[])
+{
+        bool all_metrics = false;
+        int i = 1;
+
+        if (i < argc && strcmp(argv[i], "-a") == 0) {
+                all_metrics = true;
+                i++;
+        }
+        if (argc - i != 2 || (strcmp(argv[i], "-") == 0
+                              && strcmp(argv[i + 1], "-") == 0)) {
+                fprintf(stderr, "Usage: %s [-a] image1 image2\n"
+                        "       (at most one image may be \"-\")\n",
+                        argv[0]);
+                exit(1);
+        }
+
+        Pnm_ppm first = open_image(argv[i]);
+        Pnm_ppm second = open_image(argv[i + 1]);
+
+        int width_diff = (int) first->width - (int) second->width;
+        int height_diff = (int) first->height - (int) second->height;
+        if (abs(width_diff) > 1 || abs(height_diff) > 1) {
+                fprintf(stderr, "%s: images are %ux%u and %ux%u\n", argv[0],
+                        first->width, first->height,
+                        second->width, second->height);
+                printf("1.0\n");
+                Pnm_ppmfree(&first);
+                Pnm_ppmfree(&second);
+                return EXIT_FAILURE;
+        }
+
+        Quality40 quality = Quality40_compare(first, second);
+        if (all_metrics) {
+                printf("rmse %.4f psnr %.2f dB ssim %.4f\n",
+                       quality.rmse, quality.psnr, quality.ssim);
+        } else {
+                printf("%.4f\n", quality.rmse);
+        }
+
+        Pnm_ppmfree(&first);
+        Pnm_ppmfree(&second);
+        return EXIT_SUCCESS;
+}
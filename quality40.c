@@ -0,0 +1,269 @@
+/**************************************************************
+*
+*                     quality40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       quality40.c implements RMSE, PSNR, and SSIM between two
+*       images. Both images are first flattened into contiguous float
+*       planes scaled to [0, 1]; the metric loops then run over those
+*       planes four lanes at a time (one SSE register) using GCC vector
+*       types, so that sweeping a whole corpus stays cheap.
+*
+**************************************************************/
+#include "quality40.h"
+
+#include <string.h>
+#include <math.h>
+#include "assert.h"
+#include "mem.h"
+
+/* SSIM uses 8x8 windows stepped by 4 pixels, with the usual constants */
+#define LANES 4
+#define SSIM_WINDOW 8
+#define SSIM_STEP 4
+#define SSIM_C1 (0.01 * 0.01)
+#define SSIM_C2 (0.03 * 0.03)
+
+/* elements summed in float before folding into a double accumulator */
+#define CHUNK 4096
+
+typedef float v4sf __attribute__((vector_size(LANES * sizeof(float))));
+
+/********** Planes **********
+ *
+ * struct to hold an image flattened for the metric loops
+ *
+ * Contains:
+ *      float *rgb  - interleaved R, G, B samples, 3 * width * height long
+ *      float *luma - Y' samples, width * height long
+ *
+ ************************/
+typedef struct Planes {
+        float *rgb;
+        float *luma;
+} Planes;
+
+
+/********** load4 **********
+ *
+ * Loads four consecutive floats (no alignment required) into a vector
+ *
+ ************************/
+static inline v4sf load4(const float *p)
+{
+        v4sf v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+}
+
+
+/********** sum4 **********
+ *
+ * Adds up the four lanes of a vector
+ *
+ ************************/
+static inline double sum4(v4sf v)
+{
+        double sum = 0.0;
+        for (int lane = 0; lane < LANES; lane++) {
+                sum += v[lane];
+        }
+        return sum;
+}
+
+
+/********** flatten **********
+ *
+ * Copies the top-left width x height region of an image into float planes
+ * scaled by the image's denominator
+ *
+ * Notes:
+ *      The caller frees both planes with FREE
+ ************************/
+static Planes flatten(Pnm_ppm image, unsigned width, unsigned height)
+{
+        Planes planes;
+        size_t num_pixels = (size_t) width * height;
+        float scale = 1.0f / image->denominator;
+
+        /* one spare element, so an empty region still gets planes */
+        planes.rgb = ALLOC((3 * num_pixels + 1) * sizeof(float));
+        planes.luma = ALLOC((num_pixels + 1) * sizeof(float));
+
+        for (unsigned row = 0; row < height; row++) {
+                for (unsigned col = 0; col < width; col++) {
+                        Pnm_rgb pixel = image->methods->at(image->pixels,
+                                                           col, row);
+                        size_t i = (size_t) row * width + col;
+                        float r = pixel->red * scale;
+                        float g = pixel->green * scale;
+                        float b = pixel->blue * scale;
+
+                        planes.rgb[3 * i] = r;
+                        planes.rgb[3 * i + 1] = g;
+                        planes.rgb[3 * i + 2] = b;
+                        planes.luma[i] = 0.299f * r + 0.587f * g + 0.114f * b;
+                }
+        }
+        return planes;
+}
+
+
+/********** sum_squared_error **********
+ *
+ * Returns the sum of (a[i] - b[i])^2 over n elements
+ *
+ * Notes:
+ *      Lanes accumulate in float for at most CHUNK elements at a time and
+ *      are then folded into a double, so large images do not lose precision
+ ************************/
+static double sum_squared_error(const float *a, const float *b, size_t n)
+{
+        double total = 0.0;
+        size_t i = 0;
+
+        while (i + LANES <= n) {
+                v4sf acc = { 0 };
+                size_t chunk_end = i + CHUNK < n ? i + CHUNK : n;
+                for (; i + LANES <= chunk_end; i += LANES) {
+                        v4sf diff = load4(a + i) - load4(b + i);
+                        acc += diff * diff;
+                }
+                total += sum4(acc);
+        }
+        for (; i < n; i++) {
+                double diff = a[i] - b[i];
+                total += diff * diff;
+        }
+        return total;
+}
+
+
+/********** window_ssim **********
+ *
+ * Computes SSIM from the sums of one window's samples
+ *
+ ************************/
+static double window_ssim(double sx, double sy, double sxx, double syy,
+                          double sxy, double n)
+{
+        double mu_x = sx / n;
+        double mu_y = sy / n;
+        double var_x = sxx / n - mu_x * mu_x;
+        double var_y = syy / n - mu_y * mu_y;
+        double cov = sxy / n - mu_x * mu_y;
+
+        return ((2 * mu_x * mu_y + SSIM_C1) * (2 * cov + SSIM_C2))
+               / ((mu_x * mu_x + mu_y * mu_y + SSIM_C1)
+                  * (var_x + var_y + SSIM_C2));
+}
+
+
+/********** mean_ssim **********
+ *
+ * Returns the mean SSIM of two luma planes over 8x8 windows
+ *
+ * Notes:
+ *      Each window row is exactly two vectors, so a window costs sixteen
+ *      vector loads per plane. Images smaller than a window are treated
+ *      as a single window covering the whole image.
+ ************************/
+static double mean_ssim(const float *x, const float *y, unsigned width,
+                        unsigned height)
+{
+        if (width < SSIM_WINDOW || height < SSIM_WINDOW) {
+                double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+                size_t n = (size_t) width * height;
+                for (size_t i = 0; i < n; i++) {
+                        sx += x[i];
+                        sy += y[i];
+                        sxx += x[i] * x[i];
+                        syy += y[i] * y[i];
+                        sxy += x[i] * y[i];
+                }
+                return n == 0 ? 1.0 : window_ssim(sx, sy, sxx, syy, sxy, n);
+        }
+
+        double total = 0.0;
+        size_t windows = 0;
+
+        for (unsigned top = 0; top + SSIM_WINDOW <= height;
+             top += SSIM_STEP) {
+                for (unsigned left = 0; left + SSIM_WINDOW <= width;
+                     left += SSIM_STEP) {
+                        v4sf sx = { 0 }, sy = { 0 };
+                        v4sf sxx = { 0 }, syy = { 0 }, sxy = { 0 };
+
+                        for (unsigned r = 0; r < SSIM_WINDOW; r++) {
+                                size_t i = (size_t) (top + r) * width + left;
+                                for (unsigned c = 0; c < SSIM_WINDOW;
+                                     c += LANES) {
+                                        v4sf vx = load4(x + i + c);
+                                        v4sf vy = load4(y + i + c);
+                                        sx += vx;
+                                        sy += vy;
+                                        sxx += vx * vx;
+                                        syy += vy * vy;
+                                        sxy += vx * vy;
+                                }
+                        }
+                        total += window_ssim(sum4(sx), sum4(sy), sum4(sxx),
+                                             sum4(syy), sum4(sxy),
+                                             SSIM_WINDOW * SSIM_WINDOW);
+                        windows++;
+                }
+        }
+        return total / windows;
+}
+
+
+/********** Quality40_compare **********
+ *
+ * Measures how closely decoded matches original
+ *
+ * Parameters:
+ *      Pnm_ppm original - The reference image
+ *      Pnm_ppm decoded  - The image to score against it
+ *
+ * Return:
+ *      A Quality40 holding RMSE, PSNR, and SSIM
+ *
+ * Expects:
+ *      original and decoded are non-null
+ *      CRE if either is NULL
+ *
+ * Notes:
+ *      Only the region both images cover is compared, so an image trimmed
+ *      to even dimensions by the compressor can be scored against the
+ *      untrimmed original
+ ************************/
+Quality40 Quality40_compare(Pnm_ppm original, Pnm_ppm decoded)
+{
+        assert(original != NULL && decoded != NULL);
+
+        Quality40 quality;
+        quality.width = original->width < decoded->width ? original->width
+                                                         : decoded->width;
+        quality.height = original->height < decoded->height
+                         ? original->height : decoded->height;
+
+        Planes a = flatten(original, quality.width, quality.height);
+        Planes b = flatten(decoded, quality.width, quality.height);
+        size_t num_samples = 3 * (size_t) quality.width * quality.height;
+
+        double sse = sum_squared_error(a.rgb, b.rgb, num_samples);
+        quality.rmse = num_samples == 0 ? 0.0 : sqrt(sse / num_samples);
+        quality.psnr = quality.rmse == 0.0 ? INFINITY
+                                           : -20.0 * log10(quality.rmse);
+        quality.ssim = mean_ssim(a.luma, b.luma, quality.width,
+                                 quality.height);
+
+        FREE(a.rgb);
+        FREE(a.luma);
+        FREE(b.rgb);
+        FREE(b.luma);
+        return quality;
+}
@@ -0,0 +1,48 @@
+/**************************************************************
+*
+*                     quality40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       quality40.h declares image quality metrics (RMSE, PSNR, and
+*       SSIM) used by ppmdiff and by the round-trip evaluation mode
+*       of 40image.
+*
+**************************************************************/
+#ifndef QUALITY40_INCLUDED
+#define QUALITY40_INCLUDED
+
+#include "pnm.h"
+
+/********** Quality40 **********
+ *
+ * struct to hold the result of comparing two images
+ *
+ * Contains:
+ *      unsigned width, height
+ *          size of the region compared (the smaller of the two images)
+ *
+ *      double rmse
+ *          root mean square error over all channels, with both images
+ *          scaled to [0, 1] by their own denominators
+ *
+ *      double psnr
+ *          peak signal-to-noise ratio in dB (INFINITY if identical)
+ *
+ *      double ssim
+ *          mean structural similarity of the luma planes, in [-1, 1]
+ *
+ ************************/
+typedef struct Quality40 {
+        unsigned width;
+        unsigned height;
+        double rmse;
+        double psnr;
+        double ssim;
+} Quality40;
+
+extern Quality40 Quality40_compare(Pnm_ppm original, Pnm_ppm decoded);
+
+#endif
@@ -0,0 +1,181 @@
+/**************************************************************
+*
+*                     scale40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       scale40.c implements halving of compressed images. A block's
+*       a field is the mean luma of its four pixels, which is what a
+*       box filter gives for the one pixel that block shrinks to. The
+*       four a values of a 2x2 group of blocks are therefore the luma
+*       of a 2x2 block of the half-size image, and go through the usual
+*       DCT and quantizer in codec40.c. Its chroma is the mean of the
+*       four blocks' dequantized Pb and Pr, requantized by
+*       chroma_quantization. No RGB is ever computed.
+*
+*       Odd last columns or rows of blocks are dropped, as odd pixel
+*       columns and rows are when compressing.
+*
+**************************************************************/
+#include "scale40.h"
+
+#include "assert.h"
+#include "bitpack.h"
+#include "arith40.h"
+#include "a2plain.h"
+#include "a2parallel.h"
+#include "codec40.h"
+
+#define A2 A2Methods_UArray2
+
+#define GROUPSIZE 2
+
+/********** Scale40_merge **********
+ *
+ * Builds the codeword of a half-size block from a 2x2 group of blocks
+ *
+ * Parameters:
+ *      const uint32_t codewords[4] - The group, in the order top-left,
+ *                                    top-right, bottom-left, bottom-right
+ *
+ * Return:
+ *      The merged block's codeword
+ *
+ * Notes:
+ *      Only the a, Pb, and Pr fields of the group are used; b, c, and d
+ *      describe detail inside a block, which halving averages away
+ ************************/
+uint32_t Scale40_merge(const uint32_t codewords[4])
+{
+        CodeWord_Element a_field = CODEWORD_A;
+        CodeWord_Element pb_field = CODEWORD_PB;
+        CodeWord_Element pr_field = CODEWORD_PR;
+        Block_Pixel_Info block;
+
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                uint32_t word = codewords[block_i];
+                uint64_t a = Bitpack_getu(word, a_field.width, a_field.lsb);
+                uint64_t pb = Bitpack_getu(word, pb_field.width, pb_field.lsb);
+                uint64_t pr = Bitpack_getu(word, pr_field.width, pr_field.lsb);
+
+                block.compvidArr[block_i].y = a / 511.0f;
+                block.compvidArr[block_i].pb = Arith40_chroma_of_index(pb);
+                block.compvidArr[block_i].pr = Arith40_chroma_of_index(pr);
+        }
+
+        discrete_Cosine_Transform(&block);
+        abcd_quantization(&block);
+        chroma_quantization(&block);
+
+        CodeWord_Element code_elems[NUM_CODEWORD_ELEMENTS] = { CODEWORD_A,
+                                                               CODEWORD_B,
+                                                               CODEWORD_C,
+                                                               CODEWORD_D,
+                                                               CODEWORD_PB,
+                                                               CODEWORD_PR };
+        code_elems[0].value = block.quantized_abcd[0];
+        code_elems[1].value = block.quantized_abcd[1];
+        code_elems[2].value = block.quantized_abcd[2];
+        code_elems[3].value = block.quantized_abcd[3];
+        code_elems[4].value = block.pb_chromaIndex;
+        code_elems[5].value = block.pr_chromaIndex;
+        return pack_codeword(code_elems);
+}
+
+
+/********** applyHalve **********
+ *
+ * Apply function that fills one block of the half-size image from its
+ * group in the full-size codewords (cl)
+ *
+ ************************/
+static void applyHalve(int col, int row, A2 half, void *elem, void *cl)
+{
+        (void)half;
+        A2 codewords = cl;
+        A2Methods_T methods = uarray2_methods_plain;
+        uint32_t group[BLOCKAREA];
+
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                int group_col = col * GROUPSIZE + block_i % GROUPSIZE;
+                int group_row = row * GROUPSIZE + block_i / GROUPSIZE;
+                group[block_i] = *(uint32_t *)methods->at(codewords,
+                                                          group_col,
+                                                          group_row);
+        }
+        *(uint32_t *)elem = Scale40_merge(group);
+}
+
+
+/********** Scale40_halve **********
+ *
+ * Halves a whole image of codewords
+ *
+ * Parameters:
+ *      A2 codewords - UArray2 of uint32_t codewords, one per block
+ *
+ * Return:
+ *      A new UArray2 of codewords for the image at half the width and
+ *      height, with an odd last column or row of blocks dropped
+ *
+ * Expects:
+ *      codewords is non-null
+ *
+ * Notes:
+ *      The caller frees the result with uarray2_methods_plain->free
+ ************************/
+A2 Scale40_halve(A2 codewords)
+{
+        assert(codewords != NULL);
+        A2Methods_T methods = uarray2_methods_plain;
+
+        A2 half = methods->new(methods->width(codewords) / GROUPSIZE,
+                               methods->height(codewords) / GROUPSIZE,
+                               sizeof(uint32_t));
+        void *cls[A2PARALLEL_MAX_WORKERS];
+        for (int w = 0; w < A2Parallel_workers(); w++) {
+                cls[w] = codewords;
+        }
+        uarray2_parallel_plain->map_row_major(half, applyHalve, cls);
+        return half;
+}
+
+
+/********** Scale40_stream **********
+ *
+ * Reads a compressed image and writes its half-size version
+ *
+ * Parameters:
+ *      FILE *input  - A format 2 or 3 compressed image
+ *      FILE *output - The stream to write to
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null
+ *      CRE if input is not a format 2 or 3 compressed image
+ *
+ * Notes:
+ *      Format 3 input stays format 3; format 2 is written as format 2
+ *      unless format 3 has been selected with Codec40_use_run_length
+ ************************/
+void Scale40_stream(FILE *input, FILE *output)
+{
+        assert(input != NULL && output != NULL);
+
+        unsigned width, height;
+        unsigned format = Codec40_read_header(input, &width, &height);
+        A2 codewords = Codec40_read_codewords(input, format, width, height);
+        if (format == 3) {
+                Codec40_use_run_length(true);
+        }
+
+        A2 half = Scale40_halve(codewords);
+        Codec40_write(output, half);
+
+        uarray2_methods_plain->free(&half);
+        uarray2_methods_plain->free(&codewords);
+}
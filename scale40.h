@@ -0,0 +1,32 @@
+/**************************************************************
+*
+*                     scale40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       scale40.h declares halving of compressed images. Each 2x2
+*       group of blocks becomes one block of the half-size image, built
+*       from the groups' a fields (each block's mean luma) and chroma
+*       indices, so thumbnails come straight from the codewords.
+*
+**************************************************************/
+#ifndef SCALE40_INCLUDED
+#define SCALE40_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include "a2methods.h"
+
+/* the codeword for the half-size block made from four, in the order
+ * top-left, top-right, bottom-left, bottom-right */
+extern uint32_t Scale40_merge(const uint32_t codewords[4]);
+
+/* a new array of half the width and height, rounded down */
+extern A2Methods_UArray2 Scale40_halve(A2Methods_UArray2 codewords);
+
+/* read a compressed image from input and write it at half size to output */
+extern void Scale40_stream(FILE *input, FILE *output);
+
+#endif
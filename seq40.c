@@ -0,0 +1,347 @@
+/**************************************************************
+*
+*                     seq40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       seq40.c implements the frame-sequence container. After the
+*       usual header line (format 5, then width and height) come the
+*       frames, each starting with one byte:
+*
+*               'K'  a keyframe: every codeword, as in format 2
+*               'D'  a delta: a bitmap with one bit per block in
+*                    row-major order (block k is bit k % 8 of byte
+*                    k / 8), then the codewords of the set bits
+*
+*       The encoder keeps the codewords the decoder will be holding
+*       (the reference) rather than the previous frame's, so blocks
+*       skipped by the threshold cannot drift further with each frame.
+*       The decoder keeps its last decoded frame and only decodes the
+*       blocks a delta replaces.
+*
+**************************************************************/
+#include "seq40.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "assert.h"
+#include "mem.h"
+#include "bitpack.h"
+#include "a2plain.h"
+#include "codec40.h"
+#include "pnm40.h"
+
+#define T Seq40_T
+#define A2 A2Methods_UArray2
+
+#define KEYFRAME 'K'
+#define DELTA 'D'
+
+/********** Seq40_T **********
+ *
+ * struct to hold the state of a sequence being compressed
+ *
+ * Contains:
+ *      FILE *output
+ *          where the sequence is written
+ *
+ *      unsigned threshold
+ *          largest per-field change that does not count as a change
+ *
+ *      A2 reference
+ *          the codewords the decoder holds, NULL before the keyframe
+ *
+ *      unsigned char *bitmap, size_t bitmap_bytes
+ *          the changed-block bitmap of the frame being written
+ *
+ *      uint32_t *changed
+ *          the changed codewords of the frame being written
+ *
+ ************************/
+struct T {
+        FILE *output;
+        unsigned threshold;
+        A2 reference;
+        unsigned char *bitmap;
+        size_t bitmap_bytes;
+        uint32_t *changed;
+};
+
+
+/********** Seq40_new **********
+ *
+ * Starts a compressed sequence
+ *
+ * Parameters:
+ *      FILE *output       - The stream to write to
+ *      unsigned threshold - Largest change in any quantized field of a
+ *                           block that is not stored
+ *
+ * Return:
+ *      The new sequence, finished with Seq40_free
+ *
+ * Expects:
+ *      output is non-null
+ *
+ * Notes:
+ *      Nothing is written until the first frame is added
+ ************************/
+T Seq40_new(FILE *output, unsigned threshold)
+{
+        assert(output != NULL);
+
+        T seq;
+        NEW(seq);
+        seq->output = output;
+        seq->threshold = threshold;
+        seq->reference = NULL;
+        seq->bitmap = NULL;
+        seq->bitmap_bytes = 0;
+        seq->changed = NULL;
+        return seq;
+}
+
+
+/********** Seq40_free **********
+ *
+ * Frees a sequence's state
+ *
+ * Expects:
+ *      seq and *seq are non-null
+ ************************/
+void Seq40_free(T *seq)
+{
+        assert(seq != NULL && *seq != NULL);
+        if ((*seq)->reference != NULL) {
+                uarray2_methods_plain->free(&(*seq)->reference);
+        }
+        FREE((*seq)->bitmap);
+        FREE((*seq)->changed);
+        FREE(*seq);
+}
+
+
+/********** block_changed **********
+ *
+ * Returns whether a block's codeword moved from old to new by more than
+ * threshold in any field
+ *
+ ************************/
+static bool block_changed(uint32_t old, uint32_t new, unsigned threshold)
+{
+        if (old == new) {
+                return false;
+        }
+        if (threshold == 0) {
+                return true;
+        }
+
+        CodeWord_Element fields[NUM_CODEWORD_ELEMENTS] = { CODEWORD_A,
+                                                           CODEWORD_B,
+                                                           CODEWORD_C,
+                                                           CODEWORD_D,
+                                                           CODEWORD_PB,
+                                                           CODEWORD_PR };
+        for (int i = 0; i < NUM_CODEWORD_ELEMENTS; i++) {
+                int64_t before, after;
+                if (fields[i].isSigned) {
+                        before = Bitpack_gets(old, fields[i].width,
+                                              fields[i].lsb);
+                        after = Bitpack_gets(new, fields[i].width,
+                                             fields[i].lsb);
+                } else {
+                        before = Bitpack_getu(old, fields[i].width,
+                                              fields[i].lsb);
+                        after = Bitpack_getu(new, fields[i].width,
+                                             fields[i].lsb);
+                }
+                if (llabs(after - before) > (int64_t) threshold) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+
+/********** write_keyframe **********
+ *
+ * Writes the header and the first frame, which becomes the reference
+ *
+ ************************/
+static void write_keyframe(T seq, A2 codewords)
+{
+        A2Methods_T methods = uarray2_methods_plain;
+        int blocks_wide = methods->width(codewords);
+        int blocks_high = methods->height(codewords);
+
+        fprintf(seq->output, "COMP40 Compressed image format %d\n%u %u\n",
+                SEQ40_FORMAT, blocks_wide * BLOCKSIZE,
+                blocks_high * BLOCKSIZE);
+        putc(KEYFRAME, seq->output);
+        for (int row = 0; row < blocks_high; row++) {
+                for (int col = 0; col < blocks_wide; col++) {
+                        print_codeword(seq->output, *(uint32_t *)
+                                       methods->at(codewords, col, row));
+                }
+        }
+
+        size_t num_blocks = (size_t) blocks_wide * blocks_high;
+        seq->reference = codewords;
+        seq->bitmap_bytes = (num_blocks + 7) / 8;
+        seq->bitmap = ALLOC(seq->bitmap_bytes + 1);
+        seq->changed = ALLOC(num_blocks * sizeof(uint32_t) + 1);
+}
+
+
+/********** Seq40_add **********
+ *
+ * Compresses the next frame of the sequence
+ *
+ * Parameters:
+ *      T seq         - The sequence
+ *      Pnm_ppm frame - The frame
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      seq and frame are non-null and frame has even width and height
+ *      CRE if frame is not the same size as the first frame
+ *
+ * Notes:
+ *      The first frame is written as a keyframe, and every later one as
+ *      a delta against the reference, which is then brought up to date
+ ************************/
+void Seq40_add(T seq, Pnm_ppm frame)
+{
+        assert(seq != NULL && frame != NULL);
+        A2Methods_T methods = uarray2_methods_plain;
+        A2 codewords = Codec40_encode(frame);
+
+        if (seq->reference == NULL) {
+                write_keyframe(seq, codewords);
+                return;
+        }
+        int blocks_wide = methods->width(codewords);
+        int blocks_high = methods->height(codewords);
+        assert(blocks_wide == methods->width(seq->reference)
+               && blocks_high == methods->height(seq->reference));
+
+        memset(seq->bitmap, 0, seq->bitmap_bytes);
+        size_t num_changed = 0;
+        size_t block = 0;
+        for (int row = 0; row < blocks_high; row++) {
+                for (int col = 0; col < blocks_wide; col++, block++) {
+                        uint32_t codeword = *(uint32_t *)
+                                            methods->at(codewords, col, row);
+                        uint32_t *held = methods->at(seq->reference, col,
+                                                     row);
+                        if (!block_changed(*held, codeword, seq->threshold)) {
+                                continue;
+                        }
+                        seq->bitmap[block / 8] |= 1u << (block % 8);
+                        seq->changed[num_changed++] = codeword;
+                        *held = codeword;
+                }
+        }
+
+        putc(DELTA, seq->output);
+        size_t wrote = fwrite(seq->bitmap, 1, seq->bitmap_bytes, seq->output);
+        assert(wrote == seq->bitmap_bytes);
+        for (size_t i = 0; i < num_changed; i++) {
+                print_codeword(seq->output, seq->changed[i]);
+        }
+        methods->free(&codewords);
+}
+
+
+/********** apply_delta **********
+ *
+ * Reads a delta frame and decodes each block it replaces into image
+ *
+ ************************/
+static void apply_delta(FILE *input, Pnm_ppm image, unsigned char *bitmap,
+                        size_t bitmap_bytes)
+{
+        size_t got = fread(bitmap, 1, bitmap_bytes, input);
+        assert(got == bitmap_bytes);
+
+        unsigned blocks_wide = image->width / BLOCKSIZE;
+        size_t num_blocks = (size_t) blocks_wide
+                            * (image->height / BLOCKSIZE);
+        for (size_t block = 0; block < num_blocks; block++) {
+                if ((bitmap[block / 8] >> (block % 8) & 1) == 0) {
+                        continue;
+                }
+                uint64_t codeword;
+                read_codeword(input, &codeword);
+
+                int col = block % blocks_wide * BLOCKSIZE;
+                int row = block / blocks_wide * BLOCKSIZE;
+                Pnm_rgb pixels[BLOCKAREA];
+                for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                        pixels[block_i] = image->methods->at(image->pixels,
+                                                col + block_i % BLOCKSIZE,
+                                                row + block_i / BLOCKSIZE);
+                }
+                Codec40_decode_block(codeword, image->denominator, pixels);
+        }
+}
+
+
+/********** Seq40_decompress **********
+ *
+ * Decodes every frame of a sequence
+ *
+ * Parameters:
+ *      FILE *input     - Stream positioned just after the header
+ *      unsigned width  - Frame width from the header
+ *      unsigned height - Frame height from the header
+ *      FILE *output    - Where the frames are written, as PPMs
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      input and output are non-null
+ *      CRE if a frame is malformed, the input ends inside a frame, or
+ *      the first frame is not a keyframe
+ *
+ * Notes:
+ *      The frame buffer persists between frames, so a delta costs one
+ *      block decode per changed block (plus writing the frame out)
+ ************************/
+void Seq40_decompress(FILE *input, unsigned width, unsigned height,
+                      FILE *output)
+{
+        assert(input != NULL && output != NULL);
+
+        size_t num_blocks = (size_t) (width / BLOCKSIZE)
+                            * (height / BLOCKSIZE);
+        size_t bitmap_bytes = (num_blocks + 7) / 8;
+        unsigned char *bitmap = ALLOC(bitmap_bytes + 1);
+        Pnm_ppm image = NULL;
+
+        for (int kind = getc(input); kind != EOF; kind = getc(input)) {
+                if (kind == KEYFRAME) {
+                        A2 codewords = Codec40_read_codewords(input, 2, width,
+                                                              height);
+                        if (image != NULL) {
+                                Pnm_ppmfree(&image);
+                        }
+                        image = Codec40_decode(codewords);
+                        uarray2_methods_plain->free(&codewords);
+                } else {
+                        assert(kind == DELTA && image != NULL);
+                        apply_delta(input, image, bitmap, bitmap_bytes);
+                }
+                Pnm40_write_ppm(output, image);
+        }
+
+        if (image != NULL) {
+                Pnm_ppmfree(&image);
+        }
+        FREE(bitmap);
+}
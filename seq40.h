@@ -0,0 +1,49 @@
+/**************************************************************
+*
+*                     seq40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       seq40.h is the interface to the frame-sequence container
+*       (compressed image format 5). The first frame is stored whole,
+*       as format 2 codewords; each later frame stores a bitmap of the
+*       blocks that changed and the codewords of just those blocks.
+*
+**************************************************************/
+#ifndef SEQ40_INCLUDED
+#define SEQ40_INCLUDED
+
+#include <stdio.h>
+#include "pnm.h"
+
+/* format number in the header of a compressed sequence */
+#define SEQ40_FORMAT 5
+
+#define T Seq40_T
+typedef struct T *T;
+
+/*
+ * Starts a sequence written to output. A block is stored again only if
+ * some quantized field (a, b, c, d, or a chroma index) differs by more
+ * than threshold from what the decoder already has; 0 stores every change.
+ */
+extern T Seq40_new(FILE *output, unsigned threshold);
+
+/* compresses the next frame; every frame must have the same (even) size */
+extern void Seq40_add(T seq, Pnm_ppm frame);
+
+/* finishes the sequence; the output stays open */
+extern void Seq40_free(T *seq);
+
+/*
+ * Reads the frames of a format 5 file whose header Codec40_read_header
+ * has already consumed, and writes each to output as a PPM, one after
+ * another
+ */
+extern void Seq40_decompress(FILE *input, unsigned width, unsigned height,
+                             FILE *output);
+
+#undef T
+#endif
@@ -0,0 +1,509 @@
+/**************************************************************
+*
+*                     serve40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       serve40.c implements server mode. The main thread accepts
+*       connections on the socket and gives each one a thread of its
+*       own, which reads request frames, has the worker process below
+*       code each one, and writes back the result. A connection keeps
+*       its request buffer for its whole life, so a client sending many
+*       images of about the same size reads each into memory already
+*       allocated. The buffer never grows past the --max-request limit: a
+*       longer frame is refused before any of it is read or allocated.
+*
+*       The codec does not run in the server process. Requests are
+*       relayed, one at a time, to a worker process over a socket pair,
+*       and the worker runs each through Batch40_code on memory streams,
+*       using the whole a2parallel pool. Batch40_code stops a malformed
+*       image failing more than its own request, but not the memory the
+*       codec had allocated for it, so a worker that has answered a
+*       request with an error exits, taking that memory with it, and a
+*       fresh worker is forked for the next request. The server process
+*       itself never codes, so it never starts the pool and every worker
+*       forks from a process with no codec state. Connection threads do
+*       their socket I/O with clients outside the worker, so reading the
+*       next request and sending the last result overlap with the codec.
+*
+*       Each worker codes a small image both ways before taking requests,
+*       so the pool is started and the conversion and block tables are
+*       built before the first request reaches it.
+*
+**************************************************************/
+#include "serve40.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "assert.h"
+#include "mem.h"
+#include "batch40.h"
+#include "wire40.h"
+
+/* size of the image coded at start-up to warm the codec */
+#define WARM_WIDTH  64
+#define WARM_HEIGHT 48
+
+/* where a worker finds its end of the socket pair */
+#define WORKER_FD (STDERR_FILENO + 1)
+
+/* the socket to remove when the server is stopped */
+static const char *socket_path;
+
+/* longest request payload a connection may send */
+static size_t request_limit;
+
+/* the worker process, if one is running; both guarded by worker_lock */
+static pthread_mutex_t worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static int worker_fd = -1;
+static pid_t worker_pid;
+
+
+/********** code_buffer **********
+ *
+ * Runs Batch40_code from length bytes at input into a new buffer
+ *
+ * Parameters:
+ *      bool decompress        - direction of the codec
+ *      unsigned char *input   - the request's payload
+ *      size_t length          - its length
+ *      char **output          - set to the result, to be freed with free
+ *      size_t *output_length  - set to the result's length
+ *
+ * Return:
+ *      true if the input was coded, false if it was malformed or a
+ *      stream could not be opened (*output is then NULL)
+ ************************/
+static bool code_buffer(bool decompress, unsigned char *input, size_t length,
+                        char **output, size_t *output_length)
+{
+        *output = NULL;
+        *output_length = 0;
+
+        /* fmemopen will not open an empty buffer; an empty image is bad */
+        if (length == 0) {
+                return false;
+        }
+        FILE *in = fmemopen(input, length, "rb");
+        if (in == NULL) {
+                return false;
+        }
+        FILE *out = open_memstream(output, output_length);
+        if (out == NULL) {
+                fclose(in);
+                return false;
+        }
+
+        bool coded = Batch40_code(decompress, in, out);
+        fclose(in);
+        fclose(out);
+        if (!coded) {
+                free(*output);
+                *output = NULL;
+                *output_length = 0;
+        }
+        return coded;
+}
+
+
+/********** warm_up **********
+ *
+ * Compresses a small generated image and decompresses the result, so
+ * everything the codec sets up on first use is ready
+ *
+ ************************/
+static void warm_up(void)
+{
+        char header[32];
+        int header_length = snprintf(header, sizeof(header),
+                                     "P6\n%d %d\n255\n", WARM_WIDTH,
+                                     WARM_HEIGHT);
+        size_t length = header_length + 3 * WARM_WIDTH * WARM_HEIGHT;
+        unsigned char *image = ALLOC(length);
+        memcpy(image, header, header_length);
+
+        unsigned char *sample = image + header_length;
+        for (int row = 0; row < WARM_HEIGHT; row++) {
+                for (int col = 0; col < WARM_WIDTH; col++) {
+                        *sample++ = col * 255 / (WARM_WIDTH - 1);
+                        *sample++ = row * 255 / (WARM_HEIGHT - 1);
+                        *sample++ = (row + col) % 256;
+                }
+        }
+
+        char *compressed, *decompressed;
+        size_t compressed_length, decompressed_length;
+        bool coded = code_buffer(false, image, length, &compressed,
+                                 &compressed_length);
+        assert(coded);
+        coded = code_buffer(true, (unsigned char *) compressed,
+                            compressed_length, &decompressed,
+                            &decompressed_length);
+        assert(coded);
+
+        free(compressed);
+        free(decompressed);
+        FREE(image);
+}
+
+
+/********** worker_main **********
+ *
+ * Body of a worker process: codes the requests the server relays on
+ * WORKER_FD until the server closes it or a request fails
+ *
+ * Notes:
+ *      Does not return. SIGINT is ignored, so a ^C meant for the server
+ *      leaves the worker to see its socket close and exit normally.
+ *      After any error answer the worker exits, so memory the codec
+ *      could not free goes with it.
+ ************************/
+static void worker_main(void)
+{
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, SIG_DFL);
+        warm_up();
+
+        unsigned char *request = NULL;
+        size_t capacity = 0;
+        unsigned char tag;
+        size_t length;
+
+        while (Wire40_read(WORKER_FD, &tag, &request, &capacity, &length,
+                           request_limit) == WIRE40_FRAME) {
+                const char *error = NULL;
+                char *result = NULL;
+                size_t result_length = 0;
+
+                if (!code_buffer(tag == WIRE40_DECOMPRESS, request, length,
+                                 &result, &result_length)) {
+                        error = "malformed image\n";
+                } else if (result_length > WIRE40_MAX_LENGTH) {
+                        error = "result too large\n";
+                }
+
+                bool sent;
+                if (error != NULL) {
+                        sent = Wire40_write(WORKER_FD, WIRE40_ERROR, error,
+                                            strlen(error));
+                } else {
+                        sent = Wire40_write(WORKER_FD, WIRE40_OK, result,
+                                            result_length);
+                }
+                free(result);
+                if (!sent || error != NULL) {
+                        break;
+                }
+        }
+        exit(EXIT_SUCCESS);
+}
+
+
+/********** start_worker **********
+ *
+ * Forks a worker process and keeps the server's end of its socket pair in
+ * worker_fd
+ *
+ * Return:
+ *      true if the worker was started
+ *
+ * Expects:
+ *      worker_lock is held and no worker is running
+ ************************/
+static bool start_worker(void)
+{
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+                perror("socketpair");
+                return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+                perror("fork");
+                close(pair[0]);
+                close(pair[1]);
+                return false;
+        }
+        if (pid == 0) {
+                /* keep only the worker's end: no clients, no listener */
+                if (pair[1] != WORKER_FD) {
+                        dup2(pair[1], WORKER_FD);
+                }
+                closefrom(WORKER_FD + 1);
+                worker_main();
+        }
+        close(pair[1]);
+        worker_fd = pair[0];
+        worker_pid = pid;
+        return true;
+}
+
+
+/********** stop_worker **********
+ *
+ * Closes the server's end of the worker's socket pair and waits for the
+ * worker to exit
+ *
+ * Expects:
+ *      worker_lock is held and a worker is running
+ ************************/
+static void stop_worker(void)
+{
+        close(worker_fd);
+        worker_fd = -1;
+        while (waitpid(worker_pid, NULL, 0) < 0 && errno == EINTR) {
+        }
+}
+
+
+/********** relay **********
+ *
+ * Has the worker code one request and reads back its answer
+ *
+ * Parameters:
+ *      unsigned char tag       - WIRE40_COMPRESS or WIRE40_DECOMPRESS
+ *      unsigned char *request  - the request's payload
+ *      size_t length           - its length
+ *      unsigned char *answer_tag, **answer, *capacity, *answer_length
+ *                              - the answer frame, read as by Wire40_read
+ *
+ * Return:
+ *      true if the worker answered, with WIRE40_OK or WIRE40_ERROR;
+ *      false if there was no worker or it died before answering
+ *
+ * Notes:
+ *      A worker that answers with an error has exited, so it is reaped
+ *      and the next one is started at once, to warm up before the next
+ *      request arrives. A worker found dead before it took the request
+ *      is replaced and the request sent to the new one.
+ ************************/
+static bool relay(unsigned char tag, unsigned char *request, size_t length,
+                  unsigned char *answer_tag, unsigned char **answer,
+                  size_t *capacity, size_t *answer_length)
+{
+        pthread_mutex_lock(&worker_lock);
+        if (worker_fd < 0 && !start_worker()) {
+                pthread_mutex_unlock(&worker_lock);
+                return false;
+        }
+
+        bool sent = Wire40_write(worker_fd, tag, request, length);
+        if (!sent) {
+                /* it died while idle, so the request never reached it */
+                stop_worker();
+                sent = start_worker()
+                       && Wire40_write(worker_fd, tag, request, length);
+        }
+        bool answered = sent
+                        && Wire40_read(worker_fd, answer_tag, answer,
+                                       capacity, answer_length,
+                                       WIRE40_MAX_LENGTH) == WIRE40_FRAME;
+        if (worker_fd >= 0 && (!answered || *answer_tag != WIRE40_OK)) {
+                stop_worker();
+                start_worker();
+        }
+        pthread_mutex_unlock(&worker_lock);
+        return answered;
+}
+
+
+/********** connection_main **********
+ *
+ * Connection thread: answers the requests on one connection, in order,
+ * until the client closes it
+ *
+ * Parameters:
+ *      void *arg - the connection's descriptor, cast to a pointer
+ *
+ * Notes:
+ *      A frame with an unknown tag gets an error response and the
+ *      connection carries on; a frame over request_limit gets one and
+ *      ends it, as its payload is never read, and so does a frame that
+ *      cannot be read at all
+ ************************/
+static void *connection_main(void *arg)
+{
+        int fd = (int) (intptr_t) arg;
+        unsigned char *request = NULL;
+        unsigned char *answer = NULL;
+        size_t request_capacity = 0;
+        size_t answer_capacity = 0;
+        unsigned char tag;
+        size_t length;
+        Wire40_Result got;
+
+        while ((got = Wire40_read(fd, &tag, &request, &request_capacity,
+                                  &length, request_limit)) == WIRE40_FRAME) {
+                const char *error = NULL;
+                unsigned char answer_tag;
+                size_t answer_length;
+
+                if (tag != WIRE40_COMPRESS && tag != WIRE40_DECOMPRESS) {
+                        error = "unknown request\n";
+                } else if (!relay(tag, request, length, &answer_tag, &answer,
+                                  &answer_capacity, &answer_length)) {
+                        error = "server error\n";
+                }
+
+                bool sent;
+                if (error != NULL) {
+                        sent = Wire40_write(fd, WIRE40_ERROR, error,
+                                            strlen(error));
+                } else {
+                        sent = Wire40_write(fd, answer_tag, answer,
+                                            answer_length);
+                }
+                if (!sent) {
+                        break;
+                }
+        }
+
+        if (got == WIRE40_OVERSIZE) {
+                const char *error = "request too large\n";
+                Wire40_write(fd, WIRE40_ERROR, error, strlen(error));
+        }
+        free(request);
+        free(answer);
+        close(fd);
+        return NULL;
+}
+
+
+/********** stop **********
+ *
+ * Signal handler for SIGINT and SIGTERM: removes the socket and exits
+ *
+ ************************/
+static void stop(int signal_number)
+{
+        (void) signal_number;
+        unlink(socket_path);
+        _exit(EXIT_SUCCESS);
+}
+
+
+/********** open_socket **********
+ *
+ * Binds and listens on a Unix socket at path
+ *
+ * Return:
+ *      the listening descriptor, or -1 after reporting why on stderr
+ *
+ * Notes:
+ *      A socket already at path is removed only if nothing answers on it
+ ************************/
+static int open_socket(const char *path)
+{
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+                fprintf(stderr, "%s: %s\n", path, strerror(ENAMETOOLONG));
+                return -1;
+        }
+        strcpy(address.sun_path, path);
+
+        struct stat info;
+        if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+                int live = Wire40_connect(path);
+                if (live >= 0) {
+                        close(live);
+                        fprintf(stderr, "%s: a server is already "
+                                "listening\n", path);
+                        return -1;
+                }
+                unlink(path);
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+                perror("socket");
+                return -1;
+        }
+        if (bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0
+            || listen(fd, SOMAXCONN) < 0) {
+                perror(path);
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+
+/********** Serve40_run **********
+ *
+ * Serves compress and decompress requests on a Unix socket at path
+ *
+ * Parameters:
+ *      const char *path   - where to create the socket
+ *      size_t max_request - longest request payload to accept, in bytes
+ *
+ * Return:
+ *      EXIT_FAILURE if the socket could not be set up; otherwise it does
+ *      not return, the process exiting on SIGINT or SIGTERM
+ *
+ * Expects:
+ *      path is non-null, and 0 < max_request <= WIRE40_MAX_LENGTH
+ ************************/
+int Serve40_run(const char *path, size_t max_request)
+{
+        assert(path != NULL);
+        assert(max_request > 0 && max_request <= WIRE40_MAX_LENGTH);
+        request_limit = max_request;
+
+        int listener = open_socket(path);
+        if (listener < 0) {
+                return EXIT_FAILURE;
+        }
+        socket_path = path;
+
+        /* warms up while the server waits for its first connection */
+        pthread_mutex_lock(&worker_lock);
+        bool started = start_worker();
+        pthread_mutex_unlock(&worker_lock);
+        if (!started) {
+                unlink(path);
+                return EXIT_FAILURE;
+        }
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stop;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+        for (;;) {
+                int fd = accept(listener, NULL, NULL);
+                if (fd < 0) {
+                        if (errno != EINTR && errno != ECONNABORTED) {
+                                perror("accept");
+                                /* out of descriptors: let some close */
+                                sleep(1);
+                        }
+                        continue;
+                }
+                pthread_t thread;
+                if (pthread_create(&thread, &attributes, connection_main,
+                                   (void *) (intptr_t) fd) != 0) {
+                        close(fd);
+                }
+        }
+}
@@ -0,0 +1,35 @@
+/**************************************************************
+*
+*                     serve40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       serve40.h declares server mode, which keeps one 40image process
+*       running and answers compress and decompress requests sent to it
+*       over a Unix socket in the frames of wire40.h, so that a caller
+*       with many small images pays for process start-up, the thread
+*       pool, and the lookup tables once instead of once per image.
+*
+**************************************************************/
+#ifndef SERVE40_INCLUDED
+#define SERVE40_INCLUDED
+
+#include <stddef.h>
+
+/* default and largest request payload, in MiB, for 40image --max-request */
+#define SERVE40_DEFAULT_REQUEST_MB 64
+#define SERVE40_MAX_REQUEST_MB 1024
+
+/*
+ * Listens on a Unix socket at path and serves requests until the process
+ * is sent SIGINT or SIGTERM, when it removes the socket and exits. A stale
+ * socket left at path by a server that has gone is replaced. A request
+ * longer than max_request bytes is answered with an error and its
+ * connection closed. Returns EXIT_FAILURE if the socket could not be set
+ * up.
+ */
+extern int Serve40_run(const char *path, size_t max_request);
+
+#endif
@@ -0,0 +1,260 @@
+/**************************************************************
+*
+*                     stats40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       stats40.c implements the instrumentation interface: the stage
+*       clock, the accumulators behind the STATS_* macros, and the
+*       summary emitted at exit (as text on stderr or as JSON).
+*
+**************************************************************/
+#include "stats40.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "assert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS40_TSC 1
+#endif
+
+bool Stats40_enabled = false;
+uint64_t Stats40_ticks[STATS_NUM_STAGES];
+uint64_t Stats40_counters[STATS_NUM_COUNTERS];
+Stats40_Worker Stats40_workers[STATS_MAX_WORKERS];
+uint64_t Stats40_parallel_ticks;
+int Stats40_num_workers;
+
+static const char *stage_names[STATS_NUM_STAGES] = {
+        "read", "convert", "dct", "quantize", "pack", "write"
+};
+
+static const char *counter_names[STATS_NUM_COUNTERS] = {
+        "blocks", "clamped_coefficients", "clamped_rgb", "cache_hits",
+        "cache_misses"
+};
+
+/* state captured by Stats40_enable for the report */
+static const char *run_mode;
+static const char *run_json_path;
+static uint64_t start_ticks;
+static double start_ns;
+
+static void report(void);
+static void report_workers(FILE *out, double ns_per_tick, bool json);
+
+
+/********** wall_ns **********
+ *
+ * Returns the monotonic wall clock in nanoseconds
+ *
+ ************************/
+static double wall_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/********** Stats40_now **********
+ *
+ * Returns the current value of the stage clock
+ *
+ * Notes:
+ *      On x86 this is the time-stamp counter, which is cheap enough to read
+ *      around every block. Elsewhere it falls back to nanoseconds from the
+ *      monotonic clock. report() converts ticks to time either way.
+ ************************/
+uint64_t Stats40_now(void)
+{
+#ifdef STATS40_TSC
+        return __rdtsc();
+#else
+        return (uint64_t) wall_ns();
+#endif
+}
+
+
+/********** Stats40_enable **********
+ *
+ * Turns on recording and registers the summary to be emitted at exit
+ *
+ * Parameters:
+ *      const char *mode      - name of the run, e.g. "compress"
+ *      const char *json_path - file to write JSON to, or NULL for stderr
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      mode is non-null; both strings outlive the program's main
+ *
+ * Notes:
+ *      If the program was built without STATS40 the hot path has no
+ *      instrumentation, so a warning is printed and nothing is recorded
+ ************************/
+void Stats40_enable(const char *mode, const char *json_path)
+{
+        assert(mode != NULL);
+#ifndef STATS40
+        (void)json_path;
+        (void)report;
+        fprintf(stderr, "warning: built without STATS40, "
+                        "statistics are not available\n");
+#else
+        if (Stats40_enabled) {
+                return;
+        }
+        run_mode = mode;
+        run_json_path = json_path;
+        start_ns = wall_ns();
+        start_ticks = Stats40_now();
+        Stats40_enabled = true;
+        atexit(report);
+#endif
+}
+
+
+/********** report **********
+ *
+ * Emits the accumulated statistics. Registered with atexit.
+ *
+ * Notes:
+ *      Ticks are converted to milliseconds using the tick rate observed
+ *      over the whole run, which is exact for the monotonic fallback and a
+ *      good estimate for an invariant TSC
+ ************************/
+static void report(void)
+{
+        double elapsed_ns = wall_ns() - start_ns;
+        double elapsed_ticks = (double) (Stats40_now() - start_ticks);
+        double ns_per_tick = elapsed_ticks > 0 ? elapsed_ns / elapsed_ticks
+                                               : 0.0;
+        FILE *out = stderr;
+
+        if (run_json_path != NULL) {
+                out = fopen(run_json_path, "w");
+                if (out == NULL) {
+                        perror(run_json_path);
+                        return;
+                }
+                fprintf(out, "{\n  \"mode\": \"%s\",\n"
+                        "  \"elapsed_ms\": %.3f,\n  \"stages\": {\n",
+                        run_mode, elapsed_ns / 1e6);
+        } else {
+                fprintf(out, "%s: %.3f ms total\n", run_mode,
+                        elapsed_ns / 1e6);
+                fprintf(out, "  %-10s %14s %12s %7s\n",
+                        "stage", "ticks", "ms", "%");
+        }
+
+        for (int stage = 0; stage < STATS_NUM_STAGES; stage++) {
+                double ms = Stats40_ticks[stage] * ns_per_tick / 1e6;
+                double percent = elapsed_ns > 0
+                                 ? 100.0 * ms * 1e6 / elapsed_ns : 0.0;
+                if (run_json_path != NULL) {
+                        fprintf(out, "    \"%s\": { \"ticks\": %llu, "
+                                "\"ms\": %.3f }%s\n", stage_names[stage],
+                                (unsigned long long) Stats40_ticks[stage],
+                                ms, stage + 1 < STATS_NUM_STAGES ? "," : "");
+                } else {
+                        fprintf(out, "  %-10s %14llu %12.3f %7.2f\n",
+                                stage_names[stage],
+                                (unsigned long long) Stats40_ticks[stage],
+                                ms, percent);
+                }
+        }
+
+        if (run_json_path != NULL) {
+                fprintf(out, "  },\n  \"counters\": {\n");
+        }
+        for (int counter = 0; counter < STATS_NUM_COUNTERS; counter++) {
+                unsigned long long n = Stats40_counters[counter];
+                if (run_json_path != NULL) {
+                        fprintf(out, "    \"%s\": %llu%s\n",
+                                counter_names[counter], n,
+                                counter + 1 < STATS_NUM_COUNTERS ? "," : "");
+                } else {
+                        fprintf(out, "  %-21s %llu\n",
+                                counter_names[counter], n);
+                }
+        }
+
+        uint64_t lookups = Stats40_counters[STATS_CACHE_HITS]
+                           + Stats40_counters[STATS_CACHE_MISSES];
+        double hit_rate = lookups == 0 ? 0.0
+                          : 100.0 * Stats40_counters[STATS_CACHE_HITS]
+                            / lookups;
+        if (run_json_path != NULL) {
+                fprintf(out, "  },\n  \"cache_hit_rate\": %.4f",
+                        hit_rate / 100.0);
+                report_workers(out, ns_per_tick, true);
+                fprintf(out, "\n}\n");
+                fclose(out);
+                return;
+        }
+        if (lookups > 0) {
+                fprintf(out, "  %-21s %.2f%%\n", "cache_hit_rate", hit_rate);
+        }
+        report_workers(out, ns_per_tick, false);
+}
+
+
+/********** report_workers **********
+ *
+ * Emits each worker's busy time, utilization, tasks, and steals, if any
+ * parallel map or pipeline ran. As JSON this continues the top-level
+ * object.
+ *
+ * Notes:
+ *      Utilization is busy time over the time spent in parallel work;
+ *      an even spread shows every worker near the same figure
+ ************************/
+static void report_workers(FILE *out, double ns_per_tick, bool json)
+{
+        if (Stats40_parallel_ticks == 0) {
+                return;
+        }
+        double parallel_ms = Stats40_parallel_ticks * ns_per_tick / 1e6;
+        int num_workers = Stats40_num_workers;
+
+        if (json) {
+                fprintf(out, ",\n  \"parallel_ms\": %.3f,\n"
+                        "  \"workers\": [\n", parallel_ms);
+        } else {
+                fprintf(out, "  %-10s %14s %12s %7s %8s\n", "worker",
+                        "tasks", "busy ms", "util %", "steals");
+        }
+        for (int w = 0; w < num_workers; w++) {
+                Stats40_Worker *worker = &Stats40_workers[w];
+                double busy_ms = worker->busy * ns_per_tick / 1e6;
+                double utilization = busy_ms / parallel_ms;
+                if (json) {
+                        fprintf(out, "    { \"tasks\": %llu, "
+                                "\"busy_ms\": %.3f, "
+                                "\"utilization\": %.4f, "
+                                "\"steals\": %llu }%s\n",
+                                (unsigned long long) worker->tasks, busy_ms,
+                                utilization,
+                                (unsigned long long) worker->steals,
+                                w + 1 < num_workers ? "," : "");
+                } else {
+                        fprintf(out, "  %-10d %14llu %12.3f %7.2f %8llu\n",
+                                w, (unsigned long long) worker->tasks,
+                                busy_ms, 100.0 * utilization,
+                                (unsigned long long) worker->steals);
+                }
+        }
+        if (json) {
+                fprintf(out, "  ]");
+        } else {
+                fprintf(out, "  %-21s %.3f ms\n", "in parallel work",
+                        parallel_ms);
+        }
+}
@@ -0,0 +1,163 @@
+/**************************************************************
+*
+*                     stats40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       stats40.h is the instrumentation interface for the codec. It
+*       accumulates time spent in each pipeline stage and counts events
+*       (blocks processed, clamped values) on the hot path.
+*
+*       The STATS_* macros compile to nothing unless STATS40 is
+*       defined (see the STATS variable in the Makefile). When it is
+*       defined, recording is still off until Stats40_enable is called,
+*       so an instrumented binary costs one predictable branch per
+*       macro when statistics are not requested.
+*
+*       Recording is safe from several threads: accumulators are updated
+*       with relaxed atomic adds, and stage times are summed across all
+*       threads (so with parallel workers they can exceed wall time).
+*
+*       The a2parallel.c pool also records, per worker, the time spent
+*       running tasks, the tasks run, and the steals made, and so do the
+*       pipeline40.c workers, for which a block row is a task. The
+*       summary divides each worker's busy time by the time spent in
+*       parallel work, to show how evenly the load was spread.
+*
+**************************************************************/
+#ifndef STATS40_INCLUDED
+#define STATS40_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/********** Stats40_Stage **********
+ *
+ * pipeline stages that are timed. Decompression reuses the same slots for
+ * its mirror stages: read is reading codewords, pack is unpacking them,
+ * quantize is chroma dequantization, dct is the inverse DCT, convert is
+ * component video to RGB, and write is writing the PPM.
+ *
+ ************************/
+typedef enum Stats40_Stage {
+        STATS_READ = 0,
+        STATS_CONVERT,
+        STATS_DCT,
+        STATS_QUANTIZE,
+        STATS_PACK,
+        STATS_WRITE,
+        STATS_NUM_STAGES
+} Stats40_Stage;
+
+/********** Stats40_Counter **********
+ *
+ * events that are counted. The cache counters are for the encoder's block
+ * cache when compressing and the decoder's when decompressing.
+ *
+ ************************/
+typedef enum Stats40_Counter {
+        STATS_BLOCKS = 0,
+        STATS_CLAMPED_COEFFS,
+        STATS_CLAMPED_RGB,
+        STATS_CACHE_HITS,
+        STATS_CACHE_MISSES,
+        STATS_NUM_COUNTERS
+} Stats40_Counter;
+
+/* most workers accounted for, as A2PARALLEL_MAX_WORKERS */
+#define STATS_MAX_WORKERS 64
+
+/********** Stats40_Worker **********
+ *
+ * one worker's accounting: ticks spent inside tasks, tasks run, and
+ * ranges of tasks stolen from other workers
+ *
+ ************************/
+typedef struct Stats40_Worker {
+        uint64_t busy;
+        uint64_t tasks;
+        uint64_t steals;
+} Stats40_Worker;
+
+extern bool Stats40_enabled;
+extern uint64_t Stats40_ticks[STATS_NUM_STAGES];
+extern uint64_t Stats40_counters[STATS_NUM_COUNTERS];
+
+/*
+ * per-worker accounting, ticks spent in parallel maps and pipelines, and
+ * the most workers either has used
+ */
+extern Stats40_Worker Stats40_workers[STATS_MAX_WORKERS];
+extern uint64_t Stats40_parallel_ticks;
+extern int Stats40_num_workers;
+
+/*
+ * Turns recording on and arranges for a summary to be emitted at exit.
+ * mode names the run ("compress" or "decompress"); json_path is a file to
+ * write JSON to, or NULL to print a summary on stderr.
+ */
+extern void Stats40_enable(const char *mode, const char *json_path);
+
+/* current value of the stage clock (TSC cycles where available) */
+extern uint64_t Stats40_now(void);
+
+#ifdef STATS40
+
+#define STATS_START(var) \
+        uint64_t var = Stats40_enabled ? Stats40_now() : 0
+
+#define STATS_STOP(stage, var) do {                                     \
+        if (Stats40_enabled) {                                          \
+                __atomic_fetch_add(&Stats40_ticks[(stage)],             \
+                                   Stats40_now() - (var),               \
+                                   __ATOMIC_RELAXED);                   \
+        }                                                               \
+} while (0)
+
+#define STATS_COUNT(counter, n) do {                                    \
+        if (Stats40_enabled) {                                          \
+                __atomic_fetch_add(&Stats40_counters[(counter)],        \
+                                   (uint64_t) (n), __ATOMIC_RELAXED);   \
+        }                                                               \
+} while (0)
+
+/* worker finished a task begun at var (worker 0 is any calling thread) */
+#define STATS_TASK(worker, var) do {                                    \
+        if (Stats40_enabled) {                                          \
+                Stats40_Worker *w_ = &Stats40_workers[(worker)];        \
+                __atomic_fetch_add(&w_->busy, Stats40_now() - (var),    \
+                                   __ATOMIC_RELAXED);                   \
+                __atomic_fetch_add(&w_->tasks, 1, __ATOMIC_RELAXED);    \
+        }                                                               \
+} while (0)
+
+#define STATS_STEAL(worker) do {                                        \
+        if (Stats40_enabled) {                                          \
+                __atomic_fetch_add(&Stats40_workers[(worker)].steals,   \
+                                   1, __ATOMIC_RELAXED);                \
+        }                                                               \
+} while (0)
+
+/* a parallel map or pipeline begun at var has finished */
+#define STATS_PARALLEL(var) do {                                        \
+        if (Stats40_enabled) {                                          \
+                __atomic_fetch_add(&Stats40_parallel_ticks,             \
+                                   Stats40_now() - (var),               \
+                                   __ATOMIC_RELAXED);                   \
+        }                                                               \
+} while (0)
+
+#else
+
+#define STATS_START(var)
+#define STATS_STOP(stage, var) do { } while (0)
+#define STATS_COUNT(counter, n) do { } while (0)
+#define STATS_TASK(worker, var) do { } while (0)
+#define STATS_STEAL(worker) do { } while (0)
+#define STATS_PARALLEL(var) do { } while (0)
+
+#endif
+
+#endif
@@ -16,18 +16,21 @@
  #include <stdio.h>
  #include <stdlib.h>
  #include <stdbool.h>
+ #include <limits.h>
  
  #define T UArray2_T
  
  /* 
   * struct to hold uarray2 data including width, height, 
-  * element size, and a UArray_T with elements 
+  * element size, and the elements, row after row in one buffer. Offsets
+  * into the buffer are size_t, so the element count may pass INT_MAX
+  * (a UArray_T, indexed by int, could not hold a 50k x 50k image)
   */
  struct T {
          int width;
          int height;
          int elementSize;
-         UArray_T elements;
+         char *elements;
  };
  
  
@@ -48,18 +51,25 @@
   * Notes: 
   *      - throws CRE if elementSize <= 0
   *      - throws CRE if height or width < 0
+  *      - throws CRE if the array would not fit in a long's worth of bytes
+  *      - elements start out zeroed, as in a UArray_T
   *
   ************************/
  T UArray2_new(int width, int height, int elementSize) 
  {
-         assert(width >= 0 && height >= 0 && elementSize >= 0);
+         assert(width >= 0 && height >= 0 && elementSize > 0);
          
          T new_uarray2 = ALLOC(sizeof(*new_uarray2));
  
          new_uarray2->width = width;
          new_uarray2->height = height;
          new_uarray2->elementSize = elementSize;
-         new_uarray2->elements = UArray_new(width * height, elementSize);
+ 
+         /* at most 2^62 elements, so only the byte count can overflow */
+         size_t length = (size_t) width * height;
+         assert(length <= (size_t) LONG_MAX / elementSize);
+         new_uarray2->elements = CALLOC(length > 0 ? length : 1,
+                                        elementSize);
  
          return new_uarray2;
  
@@ -89,8 +99,8 @@
          assert(uarray2 != NULL);
          assert(*uarray2 != NULL);
  
-         /* free contents of uarray2 using UArray_free */
-         UArray_free(&((*uarray2)->elements)); 
+         /* free the elements */
+         FREE((*uarray2)->elements); 
  
          /* free and set uarray2 to NULL */
          FREE(*uarray2); 
@@ -188,9 +198,9 @@
          assert(row >= 0 && row < uarray2->height);
  
          /* convert 2d index to 1d index */
-         int index = row * uarray2->width + col;
+         size_t index = (size_t) row * uarray2->width + col;
          
-         return UArray_at(uarray2->elements, index);
+         return uarray2->elements + index * uarray2->elementSize;
  }
  
  
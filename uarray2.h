@@ -13,8 +13,6 @@
  #ifndef __UARRAY2_H
  #define __UARRAY2_H
  
- #include "uarray.h"
- 
  #define T UArray2_T
  
  typedef struct T *T;
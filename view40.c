@@ -0,0 +1,526 @@
+/**************************************************************
+*
+*                     view40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       view40.c implements random access into format 2 files. The
+*       header is parsed once with Codec40_read_header (through a
+*       memory stream over the mapping); after that the codeword of
+*       block (col, row) is the four big-endian bytes at
+*
+*               header_length + 4 * (row * blocks_wide + col)
+*
+*       Pages of the file are only read in as queries touch them. A
+*       pipe or other stream cannot be mapped, so it is read into memory
+*       whole instead.
+*
+*       An update opens the same file for writing too, re-encodes the
+*       blocks under the changed rectangle, and pwrites each block
+*       row's changed codewords back at those offsets in one call.
+*
+**************************************************************/
+#include "view40.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "assert.h"
+#include "mem.h"
+#include "codec40.h"
+
+#define T View40_T
+
+#define BYTES_PER_CODEWORD 4
+
+static uint32_t update_block(uint32_t old, unsigned col, unsigned row,
+                             unsigned x, unsigned y, Pnm_ppm patch);
+static bool write_all(int fd, const unsigned char *bytes, size_t length,
+                      off_t offset);
+static unsigned char *read_stream(int fd, size_t *length);
+
+/********** View40_T **********
+ *
+ * struct to hold a mapped format 2 file
+ *
+ * Contains:
+ *      const unsigned char *map, size_t length
+ *          the mapping and its size
+ *
+ *      bool mapped
+ *          true if map is a mapping of the file, false if it is a copy
+ *          of a stream, to be freed with FREE
+ *
+ *      const unsigned char *codewords
+ *          the first codeword, just past the header
+ *
+ *      unsigned width, height, blocks_wide
+ *          the image size in pixels, and blocks per block row
+ *
+ ************************/
+struct T {
+        const unsigned char *map;
+        size_t length;
+        bool mapped;
+        const unsigned char *codewords;
+        unsigned width;
+        unsigned height;
+        unsigned blocks_wide;
+};
+
+
+/********** View40_open **********
+ *
+ * Maps a format 2 file and parses its header
+ *
+ * Parameters:
+ *      const char *path - The compressed file
+ *
+ * Return:
+ *      The new view, closed with View40_close, or NULL (with errno set) if
+ *      the file could not be opened, mapped, or read
+ *
+ * Expects:
+ *      path is non-null
+ *      CRE if the file is not format 2 or is shorter than its header says
+ *
+ * Notes:
+ *      A path that is not a regular file, such as a pipe on /dev/stdin,
+ *      is read into memory to its end instead of mapped
+ ************************/
+T View40_open(const char *path)
+{
+        assert(path != NULL);
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+                return NULL;
+        }
+        struct stat info;
+        if (fstat(fd, &info) < 0) {
+                int saved = errno;
+                close(fd);
+                errno = saved;
+                return NULL;
+        }
+
+        T view;
+        NEW(view);
+        view->mapped = S_ISREG(info.st_mode);
+        if (view->mapped) {
+                assert(info.st_size > 0);
+                void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE,
+                                 fd, 0);
+                view->map = map == MAP_FAILED ? NULL : map;
+                view->length = info.st_size;
+        } else {
+                view->map = read_stream(fd, &view->length);
+        }
+        int saved = errno;
+        close(fd);
+        if (view->map == NULL) {
+                FREE(view);
+                errno = saved;
+                return NULL;
+        }
+
+        FILE *header = fmemopen((void *) view->map, view->length, "rb");
+        assert(header != NULL);
+        unsigned format = Codec40_read_header(header, &view->width,
+                                              &view->height);
+        assert(format == 2);
+        size_t header_length = ftell(header);
+        fclose(header);
+
+        view->blocks_wide = view->width / BLOCKSIZE;
+        size_t num_blocks = (size_t) view->blocks_wide
+                            * (view->height / BLOCKSIZE);
+        assert(view->length - header_length
+               >= num_blocks * BYTES_PER_CODEWORD);
+        view->codewords = view->map + header_length;
+        return view;
+}
+
+
+/********** View40_close **********
+ *
+ * Unmaps the file (or frees the copy read from a stream) and frees the
+ * view
+ *
+ * Expects:
+ *      view and *view are non-null
+ ************************/
+void View40_close(T *view)
+{
+        assert(view != NULL && *view != NULL);
+        if ((*view)->mapped) {
+                munmap((void *) (*view)->map, (*view)->length);
+        } else {
+                unsigned char *copy = (unsigned char *) (*view)->map;
+                FREE(copy);
+        }
+        FREE(*view);
+}
+
+
+/********** View40_width **********
+ *
+ * Returns the width of the image in pixels
+ *
+ ************************/
+unsigned View40_width(T view)
+{
+        assert(view != NULL);
+        return view->width;
+}
+
+
+/********** View40_height **********
+ *
+ * Returns the height of the image in pixels
+ *
+ ************************/
+unsigned View40_height(T view)
+{
+        assert(view != NULL);
+        return view->height;
+}
+
+
+/********** View40_codeword **********
+ *
+ * Returns the codeword of one block, read straight from the mapping
+ *
+ * Parameters:
+ *      T view       - The view
+ *      unsigned col - Column of the block grid
+ *      unsigned row - Row of the block grid
+ *
+ * Return:
+ *      The block's codeword
+ *
+ * Expects:
+ *      view is non-null and (col, row) is inside the block grid
+ ************************/
+uint32_t View40_codeword(T view, unsigned col, unsigned row)
+{
+        assert(view != NULL);
+        assert(col < view->blocks_wide && row < view->height / BLOCKSIZE);
+
+        const unsigned char *bytes = view->codewords + BYTES_PER_CODEWORD
+                                     * ((size_t) row * view->blocks_wide
+                                        + col);
+        return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16
+               | (uint32_t) bytes[2] << 8 | bytes[3];
+}
+
+
+/********** View40_pixel **********
+ *
+ * Decodes a single pixel
+ *
+ * Parameters:
+ *      T view         - The view
+ *      unsigned x     - Column of the pixel
+ *      unsigned y     - Row of the pixel
+ *      Pnm_rgb pixel  - Filled in with the pixel, on a scale of 255
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      view and pixel are non-null and (x, y) is inside the image
+ *
+ * Notes:
+ *      Decodes only the block holding the pixel
+ ************************/
+void View40_pixel(T view, unsigned x, unsigned y, Pnm_rgb pixel)
+{
+        assert(view != NULL && pixel != NULL);
+        assert(x < view->width && y < view->height);
+
+        struct Pnm_rgb block[BLOCKAREA];
+        Pnm_rgb pixels[BLOCKAREA] = {
+                &block[0], &block[1], &block[2], &block[3]
+        };
+        uint32_t codeword = View40_codeword(view, x / BLOCKSIZE,
+                                            y / BLOCKSIZE);
+        Codec40_decode_block(codeword, DECOMPRESSION_IMAGE_DENOMINATOR,
+                             pixels);
+        *pixel = block[(y % BLOCKSIZE) * BLOCKSIZE + x % BLOCKSIZE];
+}
+
+
+/********** View40_rows **********
+ *
+ * Decodes a range of pixel rows and writes them as a P6 image
+ *
+ * Parameters:
+ *      T view         - The view
+ *      unsigned first - First pixel row wanted
+ *      unsigned last  - Last pixel row wanted (inclusive)
+ *      FILE *output   - The stream to write to
+ *
+ * Return:
+ *      None
+ *
+ * Expects:
+ *      view and output are non-null and first <= last < height
+ *
+ * Notes:
+ *      Decodes only the block rows holding the wanted rows; the output
+ *      is the full width of the image and last - first + 1 rows tall
+ ************************/
+void View40_rows(T view, unsigned first, unsigned last, FILE *output)
+{
+        assert(view != NULL && output != NULL);
+        assert(first <= last && last < view->height);
+
+        fprintf(output, "P6\n%u %u\n%u\n", view->width, last - first + 1,
+                DECOMPRESSION_IMAGE_DENOMINATOR);
+
+        size_t row_length = view->width;
+        struct Pnm_rgb *rows = ALLOC(BLOCKSIZE * row_length
+                                     * sizeof(struct Pnm_rgb) + 1);
+        unsigned char *bytes = ALLOC(3 * row_length + 1);
+
+        for (unsigned block_row = first / BLOCKSIZE;
+             block_row <= last / BLOCKSIZE; block_row++) {
+                for (unsigned col = 0; col < view->blocks_wide; col++) {
+                        size_t x = (size_t) col * BLOCKSIZE;
+                        Pnm_rgb pixels[BLOCKAREA] = {
+                                &rows[x], &rows[x + 1],
+                                &rows[row_length + x],
+                                &rows[row_length + x + 1]
+                        };
+                        Codec40_decode_block(View40_codeword(view, col,
+                                                             block_row),
+                                             DECOMPRESSION_IMAGE_DENOMINATOR,
+                                             pixels);
+                }
+
+                for (unsigned r = 0; r < BLOCKSIZE; r++) {
+                        unsigned y = block_row * BLOCKSIZE + r;
+                        if (y < first || y > last) {
+                                continue;
+                        }
+                        struct Pnm_rgb *row = rows + r * row_length;
+                        for (size_t x = 0; x < row_length; x++) {
+                                bytes[3 * x] = row[x].red;
+                                bytes[3 * x + 1] = row[x].green;
+                                bytes[3 * x + 2] = row[x].blue;
+                        }
+                        size_t wrote = fwrite(bytes, 3, row_length, output);
+                        assert(wrote == row_length);
+                }
+        }
+
+        FREE(bytes);
+        FREE(rows);
+}
+
+
+/********** View40_update **********
+ *
+ * Re-encodes the blocks of a format 2 file that a changed rectangle of
+ * pixels overlaps, and overwrites just their codewords
+ *
+ * Parameters:
+ *      const char *path - The compressed file, updated in place
+ *      unsigned x       - Column where the patch's left edge goes
+ *      unsigned y       - Row where the patch's top edge goes
+ *      Pnm_ppm patch    - The new pixels of the rectangle
+ *
+ * Return:
+ *      true, or false (with errno set) if the file could not be opened or
+ *      written
+ *
+ * Expects:
+ *      path and patch are non-null
+ *      CRE if the file is not format 2 or the patch does not fit inside
+ *      the image
+ *
+ * Notes:
+ *      A block only partly covered by the patch is decoded, has the
+ *      covered pixels replaced, and is encoded again. Codewords that come
+ *      out unchanged are not written.
+ ************************/
+bool View40_update(const char *path, unsigned x, unsigned y, Pnm_ppm patch)
+{
+        assert(path != NULL && patch != NULL);
+
+        T view = View40_open(path);
+        if (view == NULL) {
+                return false;
+        }
+        assert(x <= view->width && patch->width <= view->width - x);
+        assert(y <= view->height && patch->height <= view->height - y);
+        if (patch->width == 0 || patch->height == 0) {
+                View40_close(&view);
+                return true;
+        }
+
+        int fd = open(path, O_WRONLY);
+        if (fd < 0) {
+                int saved = errno;
+                View40_close(&view);
+                errno = saved;
+                return false;
+        }
+
+        unsigned first_col = x / BLOCKSIZE;
+        unsigned last_col = (x + patch->width - 1) / BLOCKSIZE;
+        unsigned first_row = y / BLOCKSIZE;
+        unsigned last_row = (y + patch->height - 1) / BLOCKSIZE;
+        unsigned char *bytes = ALLOC((last_col - first_col + 1)
+                                     * BYTES_PER_CODEWORD + 1);
+        size_t header_length = view->codewords - view->map;
+        bool ok = true;
+
+        for (unsigned row = first_row; row <= last_row && ok; row++) {
+                unsigned low = last_col + 1;    /* changed columns */
+                unsigned high = first_col;
+                for (unsigned col = first_col; col <= last_col; col++) {
+                        uint32_t old = View40_codeword(view, col, row);
+                        uint32_t codeword = update_block(old, col, row, x, y,
+                                                         patch);
+                        unsigned char *out = bytes + BYTES_PER_CODEWORD
+                                                     * (col - first_col);
+                        out[0] = codeword >> 24;
+                        out[1] = codeword >> 16;
+                        out[2] = codeword >> 8;
+                        out[3] = codeword;
+                        if (codeword != old) {
+                                low = low < col ? low : col;
+                                high = col;
+                        }
+                }
+                if (low > high) {
+                        continue;
+                }
+                off_t offset = header_length + BYTES_PER_CODEWORD
+                               * ((size_t) row * view->blocks_wide + low);
+                ok = write_all(fd, bytes + BYTES_PER_CODEWORD
+                                           * (low - first_col),
+                               BYTES_PER_CODEWORD * (high - low + 1), offset);
+        }
+
+        int saved = errno;
+        if (close(fd) < 0 && ok) {
+                ok = false;
+                saved = errno;
+        }
+        FREE(bytes);
+        View40_close(&view);
+        errno = saved;
+        return ok;
+}
+
+
+/********** update_block **********
+ *
+ * Returns the new codeword for block (col, row), which had codeword old,
+ * once the pixels under patch (placed at (x, y)) are replaced
+ *
+ ************************/
+static uint32_t update_block(uint32_t old, unsigned col, unsigned row,
+                             unsigned x, unsigned y, Pnm_ppm patch)
+{
+        struct Pnm_rgb block[BLOCKAREA];
+        Pnm_rgb pixels[BLOCKAREA] = {
+                &block[0], &block[1], &block[2], &block[3]
+        };
+        bool covered[BLOCKAREA];
+        bool partial = false;
+
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                unsigned px = col * BLOCKSIZE + block_i % BLOCKSIZE;
+                unsigned py = row * BLOCKSIZE + block_i / BLOCKSIZE;
+                covered[block_i] = px >= x && px - x < patch->width
+                                   && py >= y && py - y < patch->height;
+                partial = partial || !covered[block_i];
+        }
+
+        /* keep the old block's decoded pixels where the patch does not go */
+        if (partial) {
+                Codec40_decode_block(old, patch->denominator, pixels);
+        }
+        for (int block_i = 0; block_i < BLOCKAREA; block_i++) {
+                if (covered[block_i]) {
+                        unsigned px = col * BLOCKSIZE + block_i % BLOCKSIZE;
+                        unsigned py = row * BLOCKSIZE + block_i / BLOCKSIZE;
+                        block[block_i] = *(Pnm_rgb) patch->methods->at(
+                                                patch->pixels, px - x, py - y);
+                }
+        }
+        return Codec40_encode_block(pixels, patch->denominator);
+}
+
+
+/********** write_all **********
+ *
+ * Writes all length bytes at offset with pwrite, retrying short writes
+ *
+ * Return:
+ *      true, or false with errno set
+ *
+ ************************/
+static bool write_all(int fd, const unsigned char *bytes, size_t length,
+                      off_t offset)
+{
+        while (length > 0) {
+                ssize_t n = pwrite(fd, bytes, length, offset);
+                if (n < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (n <= 0) {
+                        errno = n < 0 ? errno : EIO;
+                        return false;
+                }
+                bytes += n;
+                length -= n;
+                offset += n;
+        }
+        return true;
+}
+
+
+/********** read_stream **********
+ *
+ * Reads fd to its end into a new buffer
+ *
+ * Return:
+ *      the buffer, freed with FREE, holding *length bytes; or NULL with
+ *      errno set if a read failed
+ *
+ ************************/
+static unsigned char *read_stream(int fd, size_t *length)
+{
+        size_t capacity = 1 << 16;
+        unsigned char *bytes = ALLOC(capacity);
+        *length = 0;
+        for (;;) {
+                if (*length == capacity) {
+                        capacity *= 2;
+                        RESIZE(bytes, capacity);
+                }
+                ssize_t n = read(fd, bytes + *length, capacity - *length);
+                if (n < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (n < 0) {
+                        int saved = errno;
+                        FREE(bytes);
+                        errno = saved;
+                        return NULL;
+                }
+                if (n == 0) {
+                        return bytes;
+                }
+                *length += n;
+        }
+}
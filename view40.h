@@ -0,0 +1,60 @@
+/**************************************************************
+*
+*                     view40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       view40.h is the interface to random access into format 2
+*       files. Every format 2 codeword is four bytes, stored in
+*       row-major block order after the header, so the codeword of any
+*       block is at a known offset. A view maps the file into memory
+*       and decodes only the blocks a query touches, and an update
+*       re-encodes only the blocks a changed rectangle touches.
+*
+**************************************************************/
+#ifndef VIEW40_INCLUDED
+#define VIEW40_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pnm.h"
+
+#define T View40_T
+typedef struct T *T;
+
+/*
+ * Maps a format 2 file, or reads it into memory if it is a pipe or other
+ * stream. If it cannot be opened, mapped, or read, errno is set and NULL
+ * is returned; a file that is not format 2, or is too short, is a CRE.
+ */
+extern T View40_open(const char *path);
+extern void View40_close(T *view);
+
+/* size of the (trimmed) image, in pixels */
+extern unsigned View40_width(T view);
+extern unsigned View40_height(T view);
+
+/* the codeword of the block at (col, row) of the block grid */
+extern uint32_t View40_codeword(T view, unsigned col, unsigned row);
+
+/* decodes the pixel at (x, y), with denominator 255 */
+extern void View40_pixel(T view, unsigned x, unsigned y, Pnm_rgb pixel);
+
+/* decodes pixel rows first..last (inclusive) and writes them as a P6 */
+extern void View40_rows(T view, unsigned first, unsigned last, FILE *output);
+
+/*
+ * Re-encodes, in the file at path, every block that overlaps patch placed
+ * with its top-left pixel at (x, y), overwriting only those codewords. If
+ * the file cannot be opened or written, errno is set and false is
+ * returned. CRE if the patch does not fit inside the image.
+ */
+extern bool View40_update(const char *path, unsigned x, unsigned y,
+                          Pnm_ppm patch);
+
+#undef T
+#endif
@@ -0,0 +1,218 @@
+/**************************************************************
+*
+*                     wire40.c
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       wire40.c implements the frame format of wire40.h over a
+*       connected Unix stream socket. A frame's header and payload go out
+*       in one sendmsg call where the socket takes them, and reads loop
+*       until a whole frame has arrived, since a stream socket may split
+*       a frame anywhere.
+*
+**************************************************************/
+#include "wire40.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "assert.h"
+
+
+/********** Wire40_connect **********
+ *
+ * Connects to the Unix socket at path
+ *
+ * Parameters:
+ *      const char *path - the socket the server is listening on
+ *
+ * Return:
+ *      the connected descriptor, or -1 with errno set
+ *
+ * Expects:
+ *      path is non-null
+ ************************/
+int Wire40_connect(const char *path)
+{
+        assert(path != NULL);
+
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+                errno = ENAMETOOLONG;
+                return -1;
+        }
+        strcpy(address.sun_path, path);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+                return -1;
+        }
+        if (connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0) {
+                int error = errno;
+                close(fd);
+                errno = error;
+                return -1;
+        }
+        return fd;
+}
+
+
+/********** read_fully **********
+ *
+ * Reads exactly length bytes from fd into bytes
+ *
+ * Return:
+ *      false if the input ended or a read failed first
+ ************************/
+static bool read_fully(int fd, unsigned char *bytes, size_t length)
+{
+        while (length > 0) {
+                ssize_t got = read(fd, bytes, length);
+                if (got < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (got <= 0) {
+                        return false;
+                }
+                bytes += got;
+                length -= got;
+        }
+        return true;
+}
+
+
+/********** Wire40_read **********
+ *
+ * Reads one frame from fd
+ *
+ * Parameters:
+ *      int fd                  - connected socket
+ *      unsigned char *tag      - set to the frame's tag
+ *      unsigned char **buffer  - holds the payload; grown as needed
+ *      size_t *capacity        - size of *buffer, updated when it grows
+ *      size_t *length          - set to the payload's length
+ *      size_t limit            - longest payload to accept
+ *
+ * Return:
+ *      WIRE40_FRAME if a whole frame was read, WIRE40_CLOSED if the input
+ *      ended or a read failed first, or WIRE40_OVERSIZE if the frame is
+ *      longer than limit or the buffer could not be grown for it
+ *
+ * Expects:
+ *      the pointers are non-null; *buffer is NULL or holds *capacity
+ *      bytes allocated with malloc
+ *
+ * Notes:
+ *      The buffer is grown with realloc rather than RESIZE, so a peer
+ *      asking for more memory than there is gets WIRE40_OVERSIZE instead
+ *      of raising Mem_Failed on a thread with no handler for it
+ ************************/
+Wire40_Result Wire40_read(int fd, unsigned char *tag, unsigned char **buffer,
+                          size_t *capacity, size_t *length, size_t limit)
+{
+        assert(tag != NULL && buffer != NULL);
+        assert(capacity != NULL && length != NULL);
+
+        unsigned char header[WIRE40_HEADER];
+        if (!read_fully(fd, header, WIRE40_HEADER)) {
+                return WIRE40_CLOSED;
+        }
+        uint32_t size = ((uint32_t) header[1] << 24)
+                        | ((uint32_t) header[2] << 16)
+                        | ((uint32_t) header[3] << 8) | header[4];
+        *tag = header[0];
+        *length = size;
+        if (size > limit || size > WIRE40_MAX_LENGTH) {
+                return WIRE40_OVERSIZE;
+        }
+
+        /* one spare byte, so an empty payload still has a buffer */
+        if (*buffer == NULL || *capacity < (size_t) size + 1) {
+                size_t grown = *capacity < 4096 ? 4096 : *capacity;
+                while (grown < (size_t) size + 1) {
+                        grown *= 2;
+                }
+                unsigned char *bigger = realloc(*buffer, grown);
+                if (bigger == NULL) {
+                        return WIRE40_OVERSIZE;
+                }
+                *buffer = bigger;
+                *capacity = grown;
+        }
+
+        return read_fully(fd, *buffer, size) ? WIRE40_FRAME : WIRE40_CLOSED;
+}
+
+
+/********** Wire40_write **********
+ *
+ * Writes one frame to fd
+ *
+ * Parameters:
+ *      int fd                - connected socket
+ *      unsigned char tag     - the frame's tag
+ *      const void *payload   - length bytes to send after the header
+ *      size_t length         - payload length
+ *
+ * Return:
+ *      true if the whole frame was written
+ *
+ * Expects:
+ *      payload is non-null if length is not 0;
+ *      length is at most WIRE40_MAX_LENGTH
+ *
+ * Notes:
+ *      Sends with MSG_NOSIGNAL, so a peer that has gone away makes this
+ *      return false rather than raise SIGPIPE
+ ************************/
+bool Wire40_write(int fd, unsigned char tag, const void *payload,
+                  size_t length)
+{
+        assert(payload != NULL || length == 0);
+        assert(length <= WIRE40_MAX_LENGTH);
+
+        unsigned char header[WIRE40_HEADER] = {
+                tag, (length >> 24) & 0xff, (length >> 16) & 0xff,
+                (length >> 8) & 0xff, length & 0xff
+        };
+        struct iovec parts[2] = {
+                { header, WIRE40_HEADER },
+                { (void *) payload, length }
+        };
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = 2;
+
+        while (message.msg_iovlen > 0) {
+                ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+                if (sent < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (sent < 0) {
+                        return false;
+                }
+                /* step past what went out, which may end mid-part */
+                while (message.msg_iovlen > 0
+                       && (size_t) sent >= message.msg_iov->iov_len) {
+                        sent -= message.msg_iov->iov_len;
+                        message.msg_iov++;
+                        message.msg_iovlen--;
+                }
+                if (message.msg_iovlen > 0) {
+                        message.msg_iov->iov_base =
+                                (char *) message.msg_iov->iov_base + sent;
+                        message.msg_iov->iov_len -= sent;
+                }
+        }
+        return true;
+}
@@ -0,0 +1,75 @@
+/**************************************************************
+*
+*                     wire40.h
+*
+*       Assignment: arith
+*       Authors:    Mateusz, Annica
+*       Date:       10/18/26
+*
+*       wire40.h declares the framing used between the codec server
+*       (40image --serve, see serve40.c) and its clients, such as the
+*       load40 load generator. Every message in either direction is one
+*       frame: a one-byte tag, the payload length as a 4-byte big-endian
+*       number, and then that many payload bytes.
+*
+*       A client sends a request frame tagged WIRE40_COMPRESS, whose
+*       payload is a PNM image, or WIRE40_DECOMPRESS, whose payload is a
+*       compressed image. The server answers each request, in order, with
+*       one frame tagged WIRE40_OK holding exactly what 40image would have
+*       written to stdout, or WIRE40_ERROR holding a message. A connection
+*       carries any number of requests and ends when the client closes it.
+*
+**************************************************************/
+#ifndef WIRE40_INCLUDED
+#define WIRE40_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* request tags */
+#define WIRE40_COMPRESS   'c'
+#define WIRE40_DECOMPRESS 'd'
+
+/* response tags */
+#define WIRE40_OK    0
+#define WIRE40_ERROR 1
+
+/* bytes before the payload: the tag and the length */
+#define WIRE40_HEADER 5
+
+/* largest payload either side accepts */
+#define WIRE40_MAX_LENGTH (1u << 30)
+
+/* what Wire40_read found */
+typedef enum Wire40_Result {
+        WIRE40_FRAME = 0,       /* a whole frame */
+        WIRE40_CLOSED,          /* end of input or a read error */
+        WIRE40_OVERSIZE         /* a frame over the limit; payload unread */
+} Wire40_Result;
+
+/*
+ * Connects to the server listening on the Unix socket at path. Returns the
+ * connected descriptor, or -1 with errno set.
+ */
+extern int Wire40_connect(const char *path);
+
+/*
+ * Reads one frame from fd into *buffer, which holds *capacity bytes and is
+ * grown with realloc (or allocated, if NULL) when the payload does not fit,
+ * so a caller can keep one buffer for a whole connection; free it with
+ * free. Sets *tag and *length. A frame longer than limit, or one the
+ * buffer cannot be grown for, is WIRE40_OVERSIZE and its payload is left
+ * unread, so the connection cannot carry on.
+ */
+extern Wire40_Result Wire40_read(int fd, unsigned char *tag,
+                                 unsigned char **buffer, size_t *capacity,
+                                 size_t *length, size_t limit);
+
+/*
+ * Writes one frame to fd. Returns false on a write error, for instance if
+ * the other end has closed the connection.
+ */
+extern bool Wire40_write(int fd, unsigned char tag, const void *payload,
+                         size_t length);
+
+#endif